@@ -1,37 +1,55 @@
 #pragma once
 
 #include "../XCachePolicy.h"
+#include "../XEvictionStats.h"
+#include "../XTracer.h"
 #include "XArcLFUpart.h"
 #include "XArcLRUpart.h"
 
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 
 namespace XCache
 {
-    template <typename Key, typename Value>
+    template <typename Key, typename Value, typename Tracer = XNoopTracer>
     class XArcCache : public XCachePolicy<Key, Value>
     {
     public:
-        explicit XArcCache(size_t capacity_ = 10, size_t transformThreshold_ = 2)
+        using ModifyFn = typename XCachePolicy<Key, Value>::ModifyFn;
+        using RemovePred = typename XCachePolicy<Key, Value>::RemovePred;
+
+        // resource见XMemoryResource.h
+        explicit XArcCache(size_t capacity_ = 10, size_t transformThreshold_ = 2,
+                           std::pmr::memory_resource *resource = std::pmr::get_default_resource())
             : capacity(capacity_), transformThreshold(transformThreshold_),
-              lfupart(std::make_unique<XArcLFUpart<Key, Value>>(capacity_, transformThreshold_)),
-              lrupart(std::make_unique<XArcLRUpart<Key, Value>>(capacity_, transformThreshold_)) {};
+              lfupart(std::make_unique<XArcLFUpart<Key, Value, Tracer>>(capacity_, transformThreshold_, this, resource)),
+              lrupart(std::make_unique<XArcLRUpart<Key, Value, Tracer>>(capacity_, transformThreshold_, this, resource)) {};
 
         ~XArcCache() override = default;
 
         void put(Key key, Value value) override
         {
+            std::shared_ptr<XEvictionStats> stats = currentStats();
             checkGhostCaches(key);
             bool inLFU = lfupart->contain(key);
+            bool isNew = (Tracer::kEnabled || stats) && !inLFU && !lrupart->contain(key);
             lrupart->put(key, value);
             if (inLFU)
             {
                 lfupart->put(key, value);
             }
+            if (isNew)
+            {
+                Tracer::onInsert(this, key);
+                if (stats)
+                    stats->onInsert(evictionKeyHash(key));
+            }
         }
 
         bool get(Key key, Value &value) override
         {
+            std::shared_ptr<XEvictionStats> stats = currentStats();
             checkGhostCaches(key);
             bool shouldTransForm = false;
             if (lrupart->get(key, value, shouldTransForm))
@@ -39,10 +57,26 @@ namespace XCache
                 if (shouldTransForm)
                 {
                     lfupart->put(key, value);
+                    Tracer::onPromote(this, key);
                 }
+                Tracer::onHit(this, key);
+                if (stats)
+                    stats->onHit(evictionKeyHash(key));
                 return true;
             }
-            return lfupart->get(key, value);
+            bool hit = lfupart->get(key, value);
+            if (hit)
+                Tracer::onHit(this, key);
+            else
+                Tracer::onMiss(this, key);
+            if (stats)
+            {
+                if (hit)
+                    stats->onHit(evictionKeyHash(key));
+                else
+                    stats->onMiss(evictionKeyHash(key));
+            }
+            return hit;
         }
 
         Value get(Key key) override
@@ -52,7 +86,115 @@ namespace XCache
             return value;
         }
 
+        void remove(Key key) override
+        {
+            lrupart->remove(key);
+            lfupart->remove(key);
+            std::shared_ptr<XEvictionStats> stats = currentStats();
+            if (stats)
+                stats->onRemove(evictionKeyHash(key));
+        }
+
+        // key可能同时有LRU部分与LFU部分的副本，各自判断
+        bool removeIf(Key key, const RemovePred &pred) override
+        {
+            bool removed = lrupart->removeIf(key, pred);
+            removed = lfupart->removeIf(key, pred) || removed;
+            std::shared_ptr<XEvictionStats> stats = currentStats();
+            if (removed && stats)
+                stats->onRemove(evictionKeyHash(key));
+            return removed;
+        }
+
+        // 两个部分各自加锁，modify之间另用computeMtx串行，避免并发的merge在key不存在时都插入而丢失更新
+        Value modify(Key key, const ModifyFn &fn) override
+        {
+            std::lock_guard<std::mutex> lock(computeMtx);
+            std::shared_ptr<XEvictionStats> stats = currentStats();
+            checkGhostCaches(key);
+            bool wrote = false;
+            Value processed{}; // fn处理后的值；result为引擎中存放的值，未写回时不变
+            auto apply = [&](Value &value, bool present) {
+                wrote = fn(value, present);
+                processed = value;
+                return wrote;
+            };
+            Value result{};
+            bool shouldTransform = false;
+            bool hit = lrupart->modify(key, apply, result, shouldTransform);
+            if (hit)
+            {
+                // 与get一样达到阈值时复制到LFU部分；与put一样更新LFU部分中的旧副本
+                if (shouldTransform)
+                {
+                    lfupart->put(key, result);
+                    Tracer::onPromote(this, key);
+                }
+                else if (wrote && lfupart->contain(key))
+                {
+                    lfupart->put(key, result);
+                }
+            }
+            else
+            {
+                hit = lfupart->modify(key, apply, result);
+            }
+            if (hit)
+            {
+                Tracer::onHit(this, key);
+                if (stats)
+                    stats->onHit(evictionKeyHash(key));
+                return processed;
+            }
+            Tracer::onMiss(this, key);
+            if (stats)
+                stats->onMiss(evictionKeyHash(key));
+            if (apply(result, false))
+            {
+                lrupart->put(key, result);
+                Tracer::onInsert(this, key);
+                if (stats)
+                    stats->onInsert(evictionKeyHash(key));
+            }
+            return result;
+        }
+
+        // 不检查幽灵表，不触发容量调整与LRU到LFU的转换
+        bool peek(Key key, Value &value) const override
+        {
+            return lrupart->peek(key, value) || lfupart->peek(key, value);
+        }
+
+        bool contains(Key key) const override
+        {
+            return lrupart->contain(key) || lfupart->contain(key);
+        }
+
+        // 任一部分把key移入幽灵表都计为一次淘汰
+        void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override
+        {
+            lrupart->setEvictionStats(stats);
+            lfupart->setEvictionStats(stats);
+            std::atomic_store(&evictionStats, std::move(stats));
+        }
+
+        // 两个部分各自交换出空的结构，容量分配恢复初始值；与modify互斥，避免modify跨在两次交换之间
+        void clear() override
+        {
+            std::lock_guard<std::mutex> lock(computeMtx);
+            lrupart->clear();
+            lfupart->clear();
+            if (std::shared_ptr<XEvictionStats> stats = currentStats())
+                stats->onClear();
+        }
+
     private:
+        // 两个部分没有共用的锁，evictionStats用原子的shared_ptr操作读写，可以在其他线程使用缓存时替换
+        std::shared_ptr<XEvictionStats> currentStats() const
+        {
+            return std::atomic_load(&evictionStats);
+        }
+
         bool checkGhostCaches(Key key)
         {
             bool inGhost = false;
@@ -74,7 +216,9 @@ namespace XCache
     private:
         size_t capacity;
         size_t transformThreshold;
-        std::unique_ptr<XArcLFUpart<Key, Value>> lfupart;
-        std::unique_ptr<XArcLRUpart<Key, Value>> lrupart;
+        std::unique_ptr<XArcLFUpart<Key, Value, Tracer>> lfupart;
+        std::unique_ptr<XArcLRUpart<Key, Value, Tracer>> lrupart;
+        std::shared_ptr<XEvictionStats> evictionStats; // 为空时不统计
+        std::mutex computeMtx;
     };
 }
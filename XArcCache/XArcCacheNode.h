@@ -26,9 +26,9 @@ namespace XCache
 
         ~ArcNode() = default;
 
-        template <typename K, typename V>
+        template <typename K, typename V, typename T>
         friend class XArcLFUpart;
-        template <typename K, typename V>
+        template <typename K, typename V, typename T>
         friend class XArcLRUpart;
     };
 } // namespace XCache
\ No newline at end of file
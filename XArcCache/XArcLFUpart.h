@@ -2,32 +2,48 @@
 
 #include <list>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 
+#include "../XEvictionStats.h"
+#include "../XMemoryResource.h"
+#include "../XReclaimer.h"
+#include "../XTracer.h"
 #include "XArcCacheNode.h"
 
 namespace XCache {
-template <typename Key, typename Value> class XArcLFUpart {
+template <typename Key, typename Value, typename Tracer = XNoopTracer>
+class XArcLFUpart {
   using NodeType = ArcNode<Key, Value>;      // ARC算法节点
   using NodePtr = std::shared_ptr<NodeType>; //指向ARC算法节点的智能指针
-  using NodeMap = std::unordered_map<Key, NodePtr>; //存储智能指针的哈希表
-  using FreqMap =
-      std::map<size_t, std::list<NodePtr>>; //存储频率到节点列表的映射
+  using NodeMap = std::pmr::unordered_map<Key, NodePtr>; //存储智能指针的哈希表
+  using FreqMap = std::pmr::map<
+      size_t, std::pmr::list<NodePtr>>; //存储频率到节点列表的映射
 
 public:
-  explicit XArcLFUpart(size_t capacity, size_t transformThreshold)
+  // owner为追踪事件上报的引擎地址，默认为自身
+  explicit XArcLFUpart(
+      size_t capacity, size_t transformThreshold, const void *owner = nullptr,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
       : capacity(capacity), ghostCapacity(capacity),
-        transformThreshold(transformThreshold), minFreq(0) {
+        transformThreshold(transformThreshold), minFreq(0),
+        traceOwner(owner ? owner : this), resource(resource),
+        mainCache(resource), ghostCache(resource), freqMap(resource) {
     initializeList();
   }
 
-  ~XArcLFUpart() = default;
+  ~XArcLFUpart() {
+    releaseList(ghostHead);
+    if (retiredAny)
+      reclaimer.drain(); // 后台释放完成前resource不能销毁
+  }
 
   bool put(Key key, Value value) {
     if (capacity == 0)
       return false;
-    std::lock_guard<std::mutex> lock(mtx); //可能需要修改数据，需要加锁
+    XTracedLock<Tracer> lock(mtx, traceOwner); //可能需要修改数据，需要加锁
     auto it = mainCache.find(key);
     if (it != mainCache.end()) {
       return updateExistingNode(it->second, value); //更新已存在节点的值
@@ -36,7 +52,7 @@ public:
   }
 
   bool get(Key key, Value &value) {
-    std::lock_guard<std::mutex> lock(mtx); //可能需要修改数据，需要加锁
+    XTracedLock<Tracer> lock(mtx, traceOwner); //可能需要修改数据，需要加锁
     auto it = mainCache.find(key);
     if (it != mainCache.end()) {
       updateNodeFreq(it->second); //更新节点的访问频率
@@ -46,10 +62,61 @@ public:
     return false;
   }
 
-  bool contain(Key key) { return mainCache.find(key) != mainCache.end(); }
+  // 已存在时对副本调用fn(value, true)，返回true才写回，并增加频率，result为之后存放的值；
+  // 不存在时返回false
+  template <typename Fn> bool modify(Key key, Fn &fn, Value &result) {
+    XTracedLock<Tracer> lock(mtx, traceOwner);
+    auto it = mainCache.find(key);
+    if (it == mainCache.end())
+      return false;
+    Value value = it->second->value;
+    if (fn(value, true))
+      it->second->value = std::move(value);
+    updateNodeFreq(it->second);
+    result = it->second->value;
+    return true;
+  }
+
+  // 只读查询，不调整频率
+  bool peek(Key key, Value &value) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = mainCache.find(key);
+    if (it == mainCache.end())
+      return false;
+    value = it->second->value;
+    return true;
+  }
+
+  bool contain(Key key) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return mainCache.find(key) != mainCache.end();
+  }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) {
+    std::lock_guard<std::mutex> lock(mtx);
+    evictionStats = std::move(stats);
+  }
+
+  void remove(Key key) // 从主缓存中删除节点（不进入幽灵缓存）
+  {
+    XTracedLock<Tracer> lock(mtx, traceOwner);
+    auto it = mainCache.find(key);
+    if (it != mainCache.end())
+      eraseFromMain(it);
+  }
+
+  template <typename Pred> bool removeIf(Key key, const Pred &pred) {
+    XTracedLock<Tracer> lock(mtx, traceOwner);
+    auto it = mainCache.find(key);
+    if (it == mainCache.end() || !pred(it->second->value))
+      return false;
+    eraseFromMain(it);
+    return true;
+  }
 
   bool checkGhost(Key key) // 检查并删除幽灵缓存中的节点
   {
+    std::lock_guard<std::mutex> lock(mtx);
     auto it = ghostCache.find(key);
     if (it != ghostCache.end()) {
       removeFromGhost(it->second);
@@ -59,9 +126,35 @@ public:
     return false;
   }
 
-  void increaseCapacity() { capacity++; }
+  // 主缓存、频率表与幽灵缓存换成空的，容量恢复为初始值；旧的节点由XReclaimer在后台释放
+  void clear() {
+    auto retired = std::make_shared<Retired>(resource);
+    NodePtr head = makePmrShared<NodeType>(resource);
+    NodePtr tail = makePmrShared<NodeType>(resource);
+    head->next = tail;
+    tail->prev = head;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      retired->main.swap(mainCache);
+      retired->ghost.swap(ghostCache);
+      retired->freq.swap(freqMap);
+      retired->ghostHead = std::exchange(ghostHead, std::move(head));
+      ghostTail = std::move(tail);
+      minFreq = 0;
+      capacity = ghostCapacity;
+      retiredAny = true;
+    }
+    reclaimer.retire(std::move(retired), resource);
+  }
+
+  // 容量调整与put/get并发，同样在锁内完成，见XArcLRUpart
+  void increaseCapacity() {
+    std::lock_guard<std::mutex> lock(mtx);
+    capacity++;
+  }
 
   bool decreaseCapacity() {
+    std::lock_guard<std::mutex> lock(mtx);
     if (capacity <= 0)
       return false;
     if (mainCache.size() ==
@@ -74,9 +167,28 @@ public:
   }
 
 private:
+  // clear换下的索引、频率表与幽灵链表
+  struct Retired {
+    explicit Retired(std::pmr::memory_resource *resource)
+        : main(resource), ghost(resource), freq(resource) {}
+    ~Retired() { releaseList(ghostHead); }
+    NodeMap main;
+    NodeMap ghost;
+    FreqMap freq;
+    NodePtr ghostHead;
+  };
+
+  // 逐个断开next强引用，避免长链表在析构时递归过深导致栈溢出
+  static void releaseList(NodePtr node) {
+    while (node) {
+      NodePtr next = std::move(node->next);
+      node = std::move(next);
+    }
+  }
+
   void initializeList() {
-    ghostHead = std::make_shared<NodeType>();
-    ghostTail = std::make_shared<NodeType>();
+    ghostHead = makePmrShared<NodeType>(resource);
+    ghostTail = makePmrShared<NodeType>(resource);
     ghostHead->next = ghostTail;
     ghostTail->prev = ghostHead;
   }
@@ -100,6 +212,21 @@ private:
     ghostCache[node->getKey()] = node;
   }
 
+  // 把主缓存中的节点连同所在的频率链表一起删除，调用者持有mtx
+  void eraseFromMain(typename NodeMap::iterator it) {
+    size_t freq = it->second->getAccessCount();
+    auto listIt = freqMap.find(freq);
+    if (listIt != freqMap.end()) {
+      listIt->second.remove(it->second);
+      if (listIt->second.empty()) {
+        freqMap.erase(listIt);
+        if (minFreq == freq && !freqMap.empty())
+          minFreq = freqMap.begin()->first;
+      }
+    }
+    mainCache.erase(it);
+  }
+
   void removeFromGhost(NodePtr node) // 从幽灵缓存中移除节点
   {
     if (auto prevNode = node->prev.lock(); prevNode && node->next) {
@@ -123,10 +250,7 @@ private:
         minFreq = newFreq;
       }
     }
-    // 添加到新的频率列表
-    if (freqMap.find(newFreq) == freqMap.end()) {
-      freqMap[newFreq] = std::list<NodePtr>();
-    }
+    // 添加到新的频率列表（operator[]按需创建，列表与freqMap共用resource）
     freqMap[newFreq].push_back(node);
   }
 
@@ -155,6 +279,9 @@ private:
     addToGhost(node);
     // 从主缓存中移除节点
     mainCache.erase(node->getKey());
+    Tracer::onEvict(traceOwner, node->getKey());
+    if (evictionStats)
+      evictionStats->onEvict(evictionKeyHash(node->getKey()));
   }
 
   void removeOldestGhost() // 移除最旧的幽灵节点
@@ -170,11 +297,8 @@ private:
     if (mainCache.size() >= capacity) {
       evictLeastFrequentNode();
     }
-    NodePtr node = std::make_shared<NodeType>(key, value);
+    NodePtr node = makePmrShared<NodeType>(resource, key, value);
     mainCache[key] = node;
-    if (mainCache.find(1) == mainCache.end()) {
-      freqMap[1] = std::list<NodePtr>();
-    }
     freqMap[1].push_back(node);
     minFreq = 1;
     return true;
@@ -185,7 +309,9 @@ private:
   size_t ghostCapacity;      // 幽灵缓存容量
   size_t transformThreshold; // 转换阈值
   size_t minFreq;            // 最小频率
-  std::mutex mtx;
+  const void *traceOwner;
+  std::pmr::memory_resource *resource;
+  mutable std::mutex mtx;
 
   NodeMap mainCache;  // 主缓存
   NodeMap ghostCache; // 幽灵缓存
@@ -193,5 +319,9 @@ private:
 
   NodePtr ghostHead; // 幽灵链表头
   NodePtr ghostTail; // 幽灵链表尾
+
+  bool retiredAny = false; // 是否有交给XReclaimer的旧结构
+  XReclaimer &reclaimer = XReclaimer::instance(); // 构造时创建，见XReclaimer.h
+  std::shared_ptr<XEvictionStats> evictionStats; // 为空时不统计
 };
 } // namespace XCache
\ No newline at end of file
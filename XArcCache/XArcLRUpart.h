@@ -3,31 +3,46 @@
 #include <unordered_map>
 #include <mutex>
 #include <memory>
+#include <memory_resource>
+#include <utility>
+#include "../XEvictionStats.h"
+#include "../XMemoryResource.h"
+#include "../XReclaimer.h"
+#include "../XTracer.h"
 #include "XArcCacheNode.h"
 
 namespace XCache
 {
-    template <typename Key, typename Value>
+    template <typename Key, typename Value, typename Tracer = XNoopTracer>
     class XArcLRUpart
     {
         using NodeType = ArcNode<Key, Value>;
         using NodePtr = std::shared_ptr<NodeType>;
-        using NodeMap = std::unordered_map<Key, NodePtr>;
+        using NodeMap = std::pmr::unordered_map<Key, NodePtr>;
 
     public:
-        explicit XArcLRUpart(size_t capacity, size_t transformThreshold)
-            : capacity(capacity), ghostCapacity(capacity), transformThreshold(transformThreshold)
+        // owner为追踪事件上报的引擎地址，默认为自身
+        explicit XArcLRUpart(size_t capacity, size_t transformThreshold, const void *owner = nullptr,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : capacity(capacity), ghostCapacity(capacity), transformThreshold(transformThreshold),
+              traceOwner(owner ? owner : this), resource(resource), mainCache(resource), ghostCache(resource)
         {
             initializeList();
         }
 
-        ~XArcLRUpart() = default;
+        ~XArcLRUpart()
+        {
+            releaseList(mainHead);
+            releaseList(ghostHead);
+            if (retiredAny)
+                reclaimer.drain(); // 后台释放完成前resource不能销毁
+        }
 
         bool put(Key key, Value value) // 向主缓存中添加或更新节点
         {
             if (capacity == 0)
                 return false;
-            std::lock_guard<std::mutex> lock(mtx);
+            XTracedLock<Tracer> lock(mtx, traceOwner);
             auto it = mainCache.find(key);
             if (it != mainCache.end())
             {
@@ -38,7 +53,7 @@ namespace XCache
 
         bool get(Key key, Value &value, bool &shouldTransform) // 从主缓存中获取指定键对应的值及判断是否需要转换
         {
-            std::lock_guard<std::mutex> lock(mtx);
+            XTracedLock<Tracer> lock(mtx, traceOwner);
             auto it = mainCache.find(key);
             if (it != mainCache.end())
             {
@@ -49,8 +64,72 @@ namespace XCache
             return false;
         }
 
+        void remove(Key key) // 从主缓存中删除节点（不进入幽灵缓存）
+        {
+            XTracedLock<Tracer> lock(mtx, traceOwner);
+            auto it = mainCache.find(key);
+            if (it != mainCache.end())
+            {
+                removeFromMain(it->second);
+                mainCache.erase(it);
+            }
+        }
+
+        template <typename Pred>
+        bool removeIf(Key key, const Pred &pred)
+        {
+            XTracedLock<Tracer> lock(mtx, traceOwner);
+            auto it = mainCache.find(key);
+            if (it == mainCache.end() || !pred(it->second->value))
+                return false;
+            removeFromMain(it->second);
+            mainCache.erase(it);
+            return true;
+        }
+
+        // 已存在时对副本调用fn(value, true)，返回true才写回，之后与一次命中的get相同，
+        // result为之后存放的值；不存在时返回false
+        template <typename Fn>
+        bool modify(Key key, Fn &fn, Value &result, bool &shouldTransform)
+        {
+            XTracedLock<Tracer> lock(mtx, traceOwner);
+            auto it = mainCache.find(key);
+            if (it == mainCache.end())
+                return false;
+            Value value = it->second->value;
+            if (fn(value, true))
+                it->second->value = std::move(value);
+            shouldTransform = updateNodeAccess(it->second);
+            result = it->second->getValue();
+            return true;
+        }
+
+        // 只读查询，不移动节点也不增加访问计数
+        bool peek(Key key, Value &value) const
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = mainCache.find(key);
+            if (it == mainCache.end())
+                return false;
+            value = it->second->getValue();
+            return true;
+        }
+
+        bool contain(Key key) const
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return mainCache.find(key) != mainCache.end();
+        }
+
+        void setEvictionStats(std::shared_ptr<XEvictionStats> stats)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            evictionStats = std::move(stats);
+        }
+
         bool checkGhost(Key key) // 检查幽灵缓存中是否存在指定的节点并移除
         {
+            std::lock_guard<std::mutex> lock(mtx);
             auto it = ghostCache.find(key);
             if (it != ghostCache.end())
             {
@@ -61,10 +140,42 @@ namespace XCache
             return false;
         }
 
-        void increaseCapacity() { capacity++; }
+        // 主缓存与幽灵缓存换成空的，容量恢复为初始值；旧的节点由XReclaimer在后台释放
+        void clear()
+        {
+            auto retired = std::make_shared<Retired>(resource);
+            NodePtr head = makePmrShared<NodeType>(resource);
+            NodePtr tail = makePmrShared<NodeType>(resource);
+            head->next = tail;
+            tail->prev = head;
+            NodePtr ghostHeadFresh = makePmrShared<NodeType>(resource);
+            NodePtr ghostTailFresh = makePmrShared<NodeType>(resource);
+            ghostHeadFresh->next = ghostTailFresh;
+            ghostTailFresh->prev = ghostHeadFresh;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                retired->main.swap(mainCache);
+                retired->ghost.swap(ghostCache);
+                retired->mainHead = std::exchange(mainHead, std::move(head));
+                retired->ghostHead = std::exchange(ghostHead, std::move(ghostHeadFresh));
+                mainTail = std::move(tail);
+                ghostTail = std::move(ghostTailFresh);
+                capacity = ghostCapacity;
+                retiredAny = true;
+            }
+            reclaimer.retire(std::move(retired), resource);
+        }
+
+        // 容量调整由XArcCache在两个部分之间进行，与put/get并发，同样在部分的锁内完成
+        void increaseCapacity()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            capacity++;
+        }
 
         bool decreaseCapacity()
         {
+            std::lock_guard<std::mutex> lock(mtx);
             if (capacity <= 0)
                 return false;
             if (mainCache.size() == capacity) // 如果主缓存已满，移除最近最少使用的节点
@@ -76,10 +187,37 @@ namespace XCache
         }
 
     private:
+        // clear换下的索引与链表
+        struct Retired
+        {
+            explicit Retired(std::pmr::memory_resource *resource) : main(resource), ghost(resource) {}
+            ~Retired()
+            {
+                releaseList(mainHead);
+                releaseList(ghostHead);
+            }
+            NodeMap main;
+            NodeMap ghost;
+            NodePtr mainHead;
+            NodePtr ghostHead;
+        };
+
+        // 逐个断开next强引用，避免长链表在析构时递归过深导致栈溢出
+        static void releaseList(NodePtr node)
+        {
+            while (node)
+            {
+                NodePtr next = std::move(node->next);
+                node = std::move(next);
+            }
+        }
+
         size_t capacity;           // 缓存容量
         size_t ghostCapacity;      // 幽灵缓存容量
         size_t transformThreshold; // 转换阈值
-        std::mutex mtx;
+        const void *traceOwner;
+        std::pmr::memory_resource *resource;
+        mutable std::mutex mtx;
 
         NodeMap mainCache;  // 主缓存
         NodeMap ghostCache; // 幽灵缓存
@@ -90,14 +228,18 @@ namespace XCache
         NodePtr ghostHead;
         NodePtr ghostTail;
 
+        std::shared_ptr<XEvictionStats> evictionStats; // 为空时不统计
+        bool retiredAny = false;                       // 是否有交给XReclaimer的旧结构
+        XReclaimer &reclaimer = XReclaimer::instance(); // 构造时创建，见XReclaimer.h
+
         void initializeList()
         {
-            mainHead = std::make_shared<NodeType>();
-            mainTail = std::make_shared<NodeType>();
+            mainHead = makePmrShared<NodeType>(resource);
+            mainTail = makePmrShared<NodeType>(resource);
             mainHead->next = mainTail;
             mainTail->prev = mainHead;
-            ghostHead = std::make_shared<NodeType>();
-            ghostTail = std::make_shared<NodeType>();
+            ghostHead = makePmrShared<NodeType>(resource);
+            ghostTail = makePmrShared<NodeType>(resource);
             ghostHead->next = ghostTail;
             ghostTail->prev = ghostHead;
         }
@@ -124,7 +266,7 @@ namespace XCache
                 evictLeastRecent();
             }
             // 创建新节点并添加到主缓存
-            NodePtr newNode = std::make_shared<NodeType>(key, value);
+            NodePtr newNode = makePmrShared<NodeType>(resource, key, value);
             mainCache[key] = newNode;
             addToFront(newNode);
             return true;
@@ -147,6 +289,9 @@ namespace XCache
             addToGhost(leastUseNode);
             // 从主缓存映射中移除
             mainCache.erase(leastUseNode->getKey());
+            Tracer::onEvict(traceOwner, leastUseNode->getKey());
+            if (evictionStats)
+                evictionStats->onEvict(evictionKeyHash(leastUseNode->getKey()));
         }
 
         void moveToFront(NodePtr node) // 将节点移动到主缓存的前端
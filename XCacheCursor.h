@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 按淘汰策略的顺序遍历缓存，用于导出热点条目做跨进程预热：
+// XLRUCache从MRU到LRU，XLFUCache按频率从高到低（同频率内新进入的在前），
+// XWTinyLFUCache先window再主区，每个区内从MRU到LRU。
+//
+// 游标每次在引擎锁内最多前进chunkSize个条目，把它们拷贝到缓冲区后释放锁，
+// 导出千万级的缓存时其他线程最多等待一个分块。遍历是弱一致的：
+// - 遍历期间没有被访问、修改或淘汰的条目恰好返回一次
+// - 遍历开始后被访问或写入的条目会移到已遍历的一侧（LRU的MRU端、LFU的更高频率），不再返回
+// - 被删除或淘汰的条目在到达之前消失则不返回
+// - 遍历期间引擎被clear时遍历直接结束，之前已返回的条目不受影响
+// - XLFUCache的频率衰减会重排所有节点，之后的条目可能重复返回；W-TinyLFU中已返回的
+//   window条目若在遍历期间被挤入主区，也会再返回一次
+// 游标不调整LRU顺序和频率，也不计入命中统计；游标不能比缓存活得久
+namespace XCache {
+template <typename Key, typename Value, typename Engine> class XCacheCursor {
+public:
+  using Entry = std::pair<Key, Value>;
+
+  XCacheCursor(const Engine &engine, size_t chunkSize)
+      : engine(&engine), chunkSize(chunkSize > 0 ? chunkSize : 1) {}
+
+  bool next(Key &key, Value &value) {
+    if (offset == buffer.size()) {
+      buffer.clear();
+      offset = 0;
+      if (fill(buffer) == 0)
+        return false;
+    }
+    key = buffer[offset].first;
+    value = buffer[offset].second;
+    ++offset;
+    return true;
+  }
+
+  // 把下一批条目追加到out，返回追加的个数，0表示遍历结束
+  size_t nextChunk(std::vector<Entry> &out) {
+    if (offset < buffer.size()) {
+      size_t count = buffer.size() - offset;
+      out.insert(out.end(), buffer.begin() + offset, buffer.end());
+      buffer.clear();
+      offset = 0;
+      return count;
+    }
+    return fill(out);
+  }
+
+  bool done() const { return finished && offset == buffer.size(); }
+
+private:
+  // 引擎跳过已返回的节点也计入分块大小，未结束时分块可能为空，继续取下一块
+  size_t fill(std::vector<Entry> &out) {
+    size_t before = out.size();
+    while (!finished && out.size() == before)
+      finished = engine->cursorChunk(position, chunkSize, out);
+    return out.size() - before;
+  }
+
+  const Engine *engine;
+  size_t chunkSize;
+  typename Engine::CursorPosition position;
+  bool finished = false;
+  std::vector<Entry> buffer;
+  size_t offset = 0;
+};
+} // namespace XCache
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "XArcCache/XArcCache.h"
+#include "XCachePolicy.h"
+#include "XLFUCache.h"
+#include "XLRUCache.h"
+#include "XTracer.h"
+#include "XWTinyLFUCache.h"
+
+namespace XCache {
+// 可按名称创建的淘汰策略（服务端与模拟器共用）
+inline const std::vector<std::string> &cachePolicyNames() {
+  static const std::vector<std::string> names = {
+      "lru", "lru-k", "lfu", "lfu-aging", "arc", "w-tinylfu"};
+  return names;
+}
+
+// 按名称创建淘汰引擎，Tracer见XTracer.h，resource见XMemoryResource.h
+template <typename Key, typename Value, typename Tracer = XNoopTracer>
+std::unique_ptr<XCachePolicy<Key, Value>> makeCachePolicy(
+    const std::string &policy, size_t capacity,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+  int cap = static_cast<int>(capacity);
+  if (policy == "lru")
+    return std::make_unique<XLRUCache<Key, Value, Tracer>>(cap, resource);
+  if (policy == "lru-k")
+    return std::make_unique<XLRUKCache<Key, Value, Tracer>>(cap, 2, 2.5,
+                                                            resource);
+  if (policy == "lfu")
+    return std::make_unique<XLFUCache<Key, Value, Tracer>>(cap, 1000000,
+                                                           resource);
+  if (policy == "lfu-aging")
+    return std::make_unique<XLFUCache<Key, Value, Tracer>>(cap, 50000, 5000,
+                                                           0.7, resource);
+  if (policy == "arc")
+    return std::make_unique<XArcCache<Key, Value, Tracer>>(capacity, 2,
+                                                           resource);
+  if (policy == "w-tinylfu")
+    return std::make_unique<XWTinyLFUCache<Key, Value, Tracer>>(capacity, 0.01,
+                                                                resource);
+  throw std::invalid_argument("unknown cache policy: " + policy);
+}
+} // namespace XCache
@@ -1,16 +1,88 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 namespace XCache
 {
+    class XEvictionStats;
+
+    // 在modify之上提供compute/computeIfAbsent/merge，Derived需实现
+    // Value modify(Key key, fn)：查找一次key，在引擎锁内调用bool fn(Value &value, bool present)。
+    // present时value为当前值的副本，否则为Value{}。fn返回true表示写回（存在时为更新，
+    // 不存在时插入，插入仍受淘汰与准入约束），返回false表示不写，对副本的修改被丢弃；未写回的访问与一次get相同。
+    // 返回fn处理后的value。fn在锁内执行，不能再访问同一个缓存
+    template <typename Derived, typename Key, typename Value>
+    class XComputeOps
+    {
+    public:
+        // fn(const Value *old) -> Value，old为nullptr表示不存在；结果总是写回
+        template <typename Fn>
+        Value compute(Key key, Fn &&fn)
+        {
+            return self().modify(key, [&](Value &value, bool present) {
+                value = fn(present ? &value : nullptr);
+                return true;
+            });
+        }
+
+        // 存在时返回当前值（等同一次命中的get），否则写入fn()的结果
+        template <typename Fn>
+        Value computeIfAbsent(Key key, Fn &&fn)
+        {
+            return self().modify(key, [&](Value &value, bool present) {
+                if (present)
+                    return false;
+                value = fn();
+                return true;
+            });
+        }
+
+        // 不存在时写入delta，否则写入fn(old, delta)，适合计数与聚合
+        template <typename Fn>
+        Value merge(Key key, Value delta, Fn &&fn)
+        {
+            return self().modify(key, [&](Value &value, bool present) {
+                value = present ? fn(value, delta) : delta;
+                return true;
+            });
+        }
+
+    private:
+        Derived &self() { return static_cast<Derived &>(*this); }
+    };
 
     template <typename Key, typename Value>
-    class XCachePolicy
+    class XCachePolicy : public XComputeOps<XCachePolicy<Key, Value>, Key, Value>
     {
     public:
+        using ModifyFn = std::function<bool(Value &value, bool present)>;
+        using RemovePred = std::function<bool(const Value &value)>;
+
         virtual ~XCachePolicy() {};
 
         virtual void put(Key key, Value value) = 0;
         virtual bool get(Key key, Value &value) = 0;
         virtual Value get(Key key) = 0;
+        virtual void remove(Key key) = 0;
+
+        // 条件删除：在引擎锁内对当前值调用pred，返回true才删除，返回是否删除。
+        // 与remove一样不进入幽灵缓存；pred在锁内执行，不能再访问同一个缓存
+        virtual bool removeIf(Key key, const RemovePred &pred) = 0;
+
+        // 只读查询：不调整淘汰顺序、访问频率、sketch等策略状态，也不计入统计。
+        // 与get共用引擎的互斥锁，持锁时间只有一次哈希查找
+        virtual bool peek(Key key, Value &value) const = 0;
+        virtual bool contains(Key key) const = 0;
+
+        // 原子读改写，语义见XComputeOps
+        virtual Value modify(Key key, const ModifyFn &fn) = 0;
+
+        // 清空所有条目：锁内只交换成空的结构，旧条目由XReclaimer（XReclaimer.h）在后台释放，
+        // resource不是线程安全的时候在调用线程上释放
+        virtual void clear() = 0;
+
+        // 挂接淘汰统计（见XEvictionStats.h），传空指针关闭；不支持的引擎忽略
+        virtual void setEvictionStats(std::shared_ptr<XEvictionStats>) {}
     };
-} // namespace XCache
\ No newline at end of file
+} // namespace XCache
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "XHistogram.h"
+#include "XReclaimer.h"
+
+namespace XCache {
+// 引擎回调时使用的key哈希
+template <typename Key> uint64_t evictionKeyHash(const Key &key) {
+  return std::hash<Key>()(key);
+}
+
+// 时间度量：Wall为真实时间（微秒），Accesses为访问次数（trace回放时更有意义）
+enum class XEvictionClock { Wall, Accesses };
+
+// 淘汰行为统计：条目被淘汰时的年龄与命中次数，以及被淘汰的key隔多久又被请求。
+// 引擎在插入、命中、未命中、淘汰、删除时以key哈希回调；驻留条目的插入时间与命中数
+// 记在统计对象自己的表中，不占用引擎节点的字段。被淘汰的key哈希进入有界幽灵表，
+// 再次被请求（未命中或重新插入）时记录间隔；超出幽灵表容量的淘汰不再追踪。
+// 这些分布用于调整windowRatio、transformThreshold、agingFactor等参数：
+// 大量条目在零命中时被淘汰且很快又被请求，说明新条目留存时间不够
+class XEvictionStats {
+  struct Resident {
+    uint64_t insertedAt;
+    uint64_t hits;
+  };
+  using ResidentMap = std::unordered_map<uint64_t, Resident>;
+  struct Ghost {
+    uint64_t evictedAt;
+    uint64_t seq;
+  };
+
+public:
+  explicit XEvictionStats(size_t ghostCapacity = 1 << 16,
+                          XEvictionClock clock = XEvictionClock::Wall)
+      : ghostCapacity(ghostCapacity), clock(clock) {}
+
+  void onInsert(uint64_t keyHash) {
+    std::lock_guard<std::mutex> lock(mtx);
+    uint64_t t = now();
+    checkGhost(keyHash, t);
+    resident[keyHash] = Resident{t, 0};
+  }
+
+  void onHit(uint64_t keyHash) {
+    std::lock_guard<std::mutex> lock(mtx);
+    accesses++;
+    auto it = resident.find(keyHash);
+    if (it != resident.end())
+      it->second.hits++;
+  }
+
+  void onMiss(uint64_t keyHash) {
+    std::lock_guard<std::mutex> lock(mtx);
+    accesses++;
+    checkGhost(keyHash, now());
+  }
+
+  void onEvict(uint64_t keyHash) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = resident.find(keyHash);
+    if (it == resident.end())
+      return; // 统计开启前插入的条目
+    uint64_t t = now();
+    ageAtEviction.record(t - it->second.insertedAt);
+    hitsAtEviction.record(it->second.hits);
+    if (it->second.hits == 0)
+      zeroHitEvictions++;
+    resident.erase(it);
+    evictions++;
+
+    if (ghostCapacity == 0)
+      return;
+    ghost[keyHash] = Ghost{t, ++ghostSeq};
+    ghostOrder.emplace_back(keyHash, ghostSeq);
+    while (ghostOrder.size() > ghostCapacity) {
+      auto oldest = ghostOrder.front();
+      ghostOrder.pop_front();
+      auto g = ghost.find(oldest.first);
+      if (g != ghost.end() && g->second.seq == oldest.second)
+        ghost.erase(g);
+    }
+  }
+
+  // 显式删除不算淘汰
+  void onRemove(uint64_t keyHash) {
+    std::lock_guard<std::mutex> lock(mtx);
+    resident.erase(keyHash);
+  }
+
+  // 引擎被clear：驻留条目都不算淘汰，整张驻留表换成空的，旧表由XReclaimer在后台释放；幽灵表保留。
+  // 统计对象被多个引擎共用时，任一引擎clear都会丢弃所有引擎的驻留记录
+  void onClear() {
+    auto retired = std::make_shared<ResidentMap>();
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      retired->swap(resident);
+    }
+    XReclaimer::instance().retire(std::move(retired),
+                                  std::pmr::new_delete_resource()); // 驻留表在全局堆上
+  }
+
+  // 淘汰时的年龄（微秒或访问次数）
+  XHistogram getAgeAtEviction() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return ageAtEviction;
+  }
+
+  // 淘汰到再次被请求的间隔（微秒或访问次数）
+  XHistogram getEvictionToRerequest() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return rerequestAfter;
+  }
+
+  // 淘汰时条目累计的命中次数
+  XHistogram getHitsAtEviction() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return hitsAtEviction;
+  }
+
+  uint64_t getEvictions() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return evictions;
+  }
+
+  uint64_t getZeroHitEvictions() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return zeroHitEvictions;
+  }
+
+  // 被淘汰后在幽灵表有效期内又被请求的次数
+  uint64_t getRerequests() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return rerequestAfter.count();
+  }
+
+  // 正在追踪的驻留条目数
+  size_t getResidentCount() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return resident.size();
+  }
+
+  XEvictionClock getClock() const { return clock; }
+
+private:
+  uint64_t now() const {
+    if (clock == XEvictionClock::Accesses)
+      return accesses;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void checkGhost(uint64_t keyHash, uint64_t t) {
+    auto g = ghost.find(keyHash);
+    if (g == ghost.end())
+      return;
+    rerequestAfter.record(t - g->second.evictedAt);
+    ghost.erase(g); // 幽灵队列中的旧项出队时按seq识别为失效
+  }
+
+  size_t ghostCapacity;
+  XEvictionClock clock;
+
+  mutable std::mutex mtx;
+  uint64_t accesses = 0;
+  ResidentMap resident;
+  std::unordered_map<uint64_t, Ghost> ghost;
+  std::deque<std::pair<uint64_t, uint64_t>> ghostOrder; // (key哈希, seq)
+  uint64_t ghostSeq = 0;
+
+  XHistogram ageAtEviction;
+  XHistogram rerequestAfter;
+  XHistogram hitsAtEviction;
+  uint64_t evictions = 0;
+  uint64_t zeroHitEvictions = 0;
+};
+} // namespace XCache
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace XCache {
+// HDR风格的对数分桶直方图：每个2的幂区间再等分为2^kSubBits个子桶，
+// 相对误差不超过1/2^kSubBits（约3%），可覆盖全部uint64范围，内存固定约15KB。
+// 记录只是一次前导零计数加一次数组自增，不加锁；多线程时每个线程记录到自己的实例，
+// 结束后用merge汇总
+class XHistogram {
+public:
+  static constexpr int kSubBits = 5;
+  static constexpr uint64_t kSubCount = uint64_t(1) << kSubBits;
+  static constexpr size_t kBuckets = (65 - kSubBits) * kSubCount;
+
+  void record(uint64_t value) {
+    counts[bucketOf(value)]++;
+    total++;
+    sum += value;
+    maxValue = std::max(maxValue, value);
+    minValue = std::min(minValue, value);
+  }
+
+  void merge(const XHistogram &other) {
+    for (size_t i = 0; i < kBuckets; ++i)
+      counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    maxValue = std::max(maxValue, other.maxValue);
+    minValue = std::min(minValue, other.minValue);
+  }
+
+  void reset() { *this = XHistogram(); }
+
+  // 百分位数（0~100），返回所在桶的上界，不超过实际最大值
+  uint64_t percentile(double p) const {
+    if (total == 0)
+      return 0;
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    rank = std::min(std::max<uint64_t>(rank, 1), total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts[i];
+      if (seen >= rank)
+        return std::min(highestOf(i), maxValue);
+    }
+    return maxValue;
+  }
+
+  uint64_t count() const { return total; }
+  uint64_t max() const { return maxValue; }
+  uint64_t min() const { return total ? minValue : 0; }
+  double mean() const { return total ? double(sum) / total : 0; }
+
+  static size_t bucketOf(uint64_t value) {
+    if (value < kSubCount)
+      return static_cast<size_t>(value);
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - kSubBits;
+    uint64_t mantissa = value >> shift; // [kSubCount, 2*kSubCount)
+    return static_cast<size_t>((shift + 1) * kSubCount + (mantissa - kSubCount));
+  }
+
+  // 桶内能表示的最大值
+  static uint64_t highestOf(size_t bucket) {
+    if (bucket < kSubCount)
+      return bucket;
+    int shift = static_cast<int>(bucket / kSubCount) - 1;
+    uint64_t mantissa = kSubCount + bucket % kSubCount;
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+private:
+  std::array<uint64_t, kBuckets> counts{};
+  uint64_t total = 0;
+  uint64_t sum = 0;
+  uint64_t maxValue = 0;
+  uint64_t minValue = UINT64_MAX;
+};
+} // namespace XCache
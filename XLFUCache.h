@@ -1,17 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
 #include <mutex>
 #include <vector>
 #include <unordered_map>
 #include <thread>
 #include <memory>
+#include <memory_resource>
 #include <cmath>
 
+#include "XCacheCursor.h"
 #include "XCachePolicy.h"
+#include "XEvictionStats.h"
+#include "XMemoryResource.h"
+#include "XReclaimer.h"
+#include "XTracer.h"
 
 namespace XCache
 {
-    template <typename Key, typename Value>
+    template <typename Key, typename Value, typename Tracer>
     class XLFUCache; // 这是一个向前声明，用于解决循环依赖问题
 
     template <typename Key, typename Value>
@@ -23,6 +33,7 @@ namespace XCache
             Key key;
             Value value;
             int freq;
+            uint64_t stamp = 0;       // 进入当前频率列表的序号，列表从头到尾递增，供游标定位
             std::weak_ptr<Node> prev; // 前一个节点的弱引用，避免循环引用
             std::shared_ptr<Node> next;
             Node() : freq(1), next(nullptr) {}                                 // 无参构造，初始化频率为1
@@ -35,14 +46,25 @@ namespace XCache
         NodePtr tail;
 
     public:
-        explicit Freqlist(int f) : freq(f) // 设置缓存队列
+        Freqlist(int f, std::pmr::memory_resource *resource) : freq(f) // 设置缓存队列
         {
-            head = std::make_shared<Node>();
-            tail = std::make_shared<Node>();
+            head = makePmrShared<Node>(resource);
+            tail = makePmrShared<Node>(resource);
             head->next = tail;
             tail->prev = head;
         }
 
+        ~Freqlist()
+        {
+            // 逐个断开next强引用，避免长链表在析构时递归过深导致栈溢出
+            NodePtr node = head;
+            while (node)
+            {
+                NodePtr next = std::move(node->next);
+                node = std::move(next);
+            }
+        }
+
         bool isEmpty() const // 判断队列是否为空
         {
             return head->next == tail;
@@ -76,38 +98,61 @@ namespace XCache
             return head->next;
         }
 
-        friend class XLFUCache<Key, Value>; // 声明友元类，以支持访问私有成员
+        template <typename, typename, typename>
+        friend class XLFUCache; // 声明友元类，以支持访问私有成员
     };
 
-    template <typename Key, typename Value>
+    template <typename Key, typename Value, typename Tracer = XNoopTracer>
     class XLFUCache : public XCachePolicy<Key, Value>
     {
     public:
         using Node = typename Freqlist<Key, Value>::Node; //
         using NodePtr = std::shared_ptr<Node>;
-        using NodeMap = std::unordered_map<Key, NodePtr>;
+        using NodeMap = std::pmr::unordered_map<Key, NodePtr>;
+        using ModifyFn = typename XCachePolicy<Key, Value>::ModifyFn;
+        using RemovePred = typename XCachePolicy<Key, Value>::RemovePred;
+        using Cursor = XCacheCursor<Key, Value, XLFUCache>;
 
-        XLFUCache(int capacity_, int maxAvgFreq = 1000000) : capacity(capacity_), maxAverageFreq(maxAvgFreq), curAverageFreq(0), curTotalFreq(0), minFreq(INT8_MAX) {}
+        // 游标位置：freq为正在遍历的频率（0表示尚未开始），node为其中下一个要访问的节点，
+        // stamp为保存时它的stamp，bound为该频率列表中已返回节点的最小stamp，epoch为开始遍历时的clear次数
+        struct CursorPosition
+        {
+            int freq = 0;
+            NodePtr node;
+            uint64_t stamp = 0;
+            uint64_t bound = UINT64_MAX;
+            uint64_t epoch = 0;
+        };
+
+        // resource见XMemoryResource.h
+        XLFUCache(int capacity_, int maxAvgFreq = 1000000,
+                  std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : capacity(capacity_), maxAverageFreq(maxAvgFreq), curAverageFreq(0), curTotalFreq(0), minFreq(INT8_MAX),
+              resource(resource), nodeMap(resource), freqMap(resource) {}
         
         // 新增构造函数，支持更灵活的参数调整
-        XLFUCache(int capacity_, int maxAvgFreq, int agingThreshold, double agingFactor) 
+        XLFUCache(int capacity_, int maxAvgFreq, int agingThreshold, double agingFactor,
+                  std::pmr::memory_resource *resource = std::pmr::get_default_resource())
             : capacity(capacity_), maxAverageFreq(maxAvgFreq), curAverageFreq(0), curTotalFreq(0), minFreq(INT8_MAX),
-              agingThreshold(agingThreshold), agingFactor(agingFactor) {}
+              agingThreshold(agingThreshold), agingFactor(agingFactor),
+              resource(resource), nodeMap(resource), freqMap(resource) {}
         ~XLFUCache() override 
         {
             // 释放freqMap中的所有Freqlist对象
             for (auto& pair : freqMap)
             {
-                delete pair.second;
+                deletePmrObject(resource, pair.second);
                 pair.second = nullptr;
             }
             freqMap.clear();
+            if (retiredAny)
+                reclaimer.drain(); // 后台释放完成前resource不能销毁
         }
         void put(Key key, Value value) override
         {
             if (capacity == 0)
                 return;
-            std::lock_guard<std::mutex> lock(mtx);
+            XTracedLock<Tracer> lock(mtx, this);
             auto it = nodeMap.find(key);
             if (it != nodeMap.end())
             {
@@ -121,13 +166,19 @@ namespace XCache
 
         bool get(Key key, Value &value) override
         {
-            std::lock_guard<std::mutex> lock(mtx);
+            XTracedLock<Tracer> lock(mtx, this);
             auto it = nodeMap.find(key);
             if (it != nodeMap.end())
             {
                 getInternal(it->second, value);
+                Tracer::onHit(this, key);
+                if (evictionStats)
+                    evictionStats->onHit(evictionKeyHash(key));
                 return true;
             }
+            Tracer::onMiss(this, key);
+            if (evictionStats)
+                evictionStats->onMiss(evictionKeyHash(key));
             return false;
         }
         Value get(Key key) override
@@ -137,23 +188,185 @@ namespace XCache
             return value;
         }
 
-        void purge()
+        void remove(Key key) override
+        {
+            XTracedLock<Tracer> lock(mtx, this);
+            auto it = nodeMap.find(key);
+            if (it == nodeMap.end())
+                return;
+            NodePtr node = it->second;
+            removeFromFreqlist(node);
+            nodeMap.erase(it);
+            decreaseFreqNum(node->freq); // minFreq可能失效，kickout时会重新计算
+            if (evictionStats)
+                evictionStats->onRemove(evictionKeyHash(key));
+        }
+
+        bool removeIf(Key key, const RemovePred &pred) override
+        {
+            XTracedLock<Tracer> lock(mtx, this);
+            auto it = nodeMap.find(key);
+            if (it == nodeMap.end() || !pred(it->second->value))
+                return false;
+            NodePtr node = it->second;
+            removeFromFreqlist(node);
+            nodeMap.erase(it);
+            decreaseFreqNum(node->freq);
+            if (evictionStats)
+                evictionStats->onRemove(evictionKeyHash(key));
+            return true;
+        }
+
+        Value modify(Key key, const ModifyFn &fn) override
+        {
+            XTracedLock<Tracer> lock(mtx, this);
+            auto it = nodeMap.find(key);
+            if (it != nodeMap.end())
+            {
+                NodePtr node = it->second;
+                Value value;
+                getInternal(node, value); // 先按一次命中的get取出副本并增加频率
+                if (fn(value, true))
+                    node->value = value;
+                Tracer::onHit(this, key);
+                if (evictionStats)
+                    evictionStats->onHit(evictionKeyHash(key));
+                return value;
+            }
+            Tracer::onMiss(this, key);
+            if (evictionStats)
+                evictionStats->onMiss(evictionKeyHash(key));
+            Value value{};
+            if (fn(value, false) && capacity != 0)
+                putInternal(key, value);
+            return value;
+        }
+
+        bool peek(Key key, Value &value) const override
         {
             std::lock_guard<std::mutex> lock(mtx);
-            nodeMap.clear();
-            // 释放freqMap中的所有Freqlist对象
-            for (auto& pair : freqMap)
+            auto it = nodeMap.find(key);
+            if (it == nodeMap.end())
+                return false;
+            value = it->second->value;
+            return true;
+        }
+
+        bool contains(Key key) const override
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            return nodeMap.find(key) != nodeMap.end();
+        }
+
+        void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            evictionStats = std::move(stats);
+        }
+
+        // 按频率从高到低遍历，同频率内从最近进入的开始，语义见XCacheCursor.h
+        Cursor cursor(size_t chunkSize = 1024) const
+        {
+            return Cursor(*this, chunkSize);
+        }
+
+        // 在锁内从position继续，最多取出budget个条目追加到out，遍历结束时返回true
+        bool cursorChunk(CursorPosition &position, size_t budget,
+                         std::vector<std::pair<Key, Value>> &out) const
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (position.freq == 0)
             {
-                delete pair.second;
-                pair.second = nullptr;
+                position.epoch = clears;
             }
-            freqMap.clear();
-            minFreq = INT8_MAX;
-            curTotalFreq = 0;
-            curAverageFreq = 0;
+            else if (position.epoch != clears)
+            {
+                position.node = nullptr; // 遍历期间被clear，之前的条目都已不存在
+                return true;
+            }
+            // 每个分块重新收集尚未遍历的频率，分块之间新出现的频率列表也能被看到
+            std::vector<int> lowerFreqs;
+            for (const auto &pair : freqMap)
+            {
+                if ((position.freq == 0 || pair.first < position.freq) && !pair.second->isEmpty())
+                    lowerFreqs.push_back(pair.first);
+            }
+            std::sort(lowerFreqs.begin(), lowerFreqs.end(), std::greater<int>());
+            auto nextFreq = lowerFreqs.begin();
+            if (position.freq == 0)
+                position.freq = nextFreq != lowerFreqs.end() ? *nextFreq++ : INT_MIN;
+
+            while (position.freq != INT_MIN)
+            {
+                auto it = freqMap.find(position.freq);
+                if (it != freqMap.end())
+                {
+                    const Freqlist<Key, Value> *list = it->second;
+                    NodePtr node = position.node;
+                    // 位置节点被删除、频率改变或在列表内被重新加入（stamp改变）时，从列表尾部重新定位
+                    if (!node || !node->next || node->freq != position.freq || node->stamp != position.stamp)
+                        node = list->tail->prev.lock();
+                    // 跳过已返回和bound之后进入的节点，跳过的节点也计入budget
+                    for (; node != list->head && node->stamp >= position.bound && budget > 0; --budget)
+                        node = node->prev.lock();
+                    for (; node != list->head && budget > 0; --budget)
+                    {
+                        out.emplace_back(node->key, node->value);
+                        position.bound = node->stamp;
+                        node = node->prev.lock();
+                    }
+                    if (node != list->head)
+                    {
+                        position.node = node;
+                        position.stamp = node->stamp;
+                        return false;
+                    }
+                }
+                position.freq = nextFreq != lowerFreqs.end() ? *nextFreq++ : INT_MIN;
+                position.node = nullptr;
+                position.bound = UINT64_MAX;
+            }
+            return true;
+        }
+
+        // 锁内只交换索引和频率表，节点与Freqlist由XReclaimer在后台释放；不逐个上报淘汰统计与追踪事件
+        void clear() override
+        {
+            auto retired = std::make_shared<Retired>(resource);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                retired->nodes.swap(nodeMap);
+                retired->lists.swap(freqMap);
+                minFreq = INT8_MAX;
+                curTotalFreq = 0;
+                curAverageFreq = 0;
+                clears++;
+                retiredAny = true;
+                if (evictionStats)
+                    evictionStats->onClear();
+            }
+            reclaimer.retire(std::move(retired), resource);
         }
 
+        // 旧名字，等同于clear
+        void purge() { clear(); }
+
     private:
+        // clear换下的索引与频率表
+        struct Retired
+        {
+            explicit Retired(std::pmr::memory_resource *resource)
+                : resource(resource), nodes(resource), lists(resource) {}
+            ~Retired()
+            {
+                for (auto &pair : lists)
+                    deletePmrObject(resource, pair.second);
+            }
+            std::pmr::memory_resource *resource;
+            NodeMap nodes;
+            std::pmr::unordered_map<int, Freqlist<Key, Value> *> lists;
+        };
+
         void putInternal(Key key, Value value);       // 存入缓存
         void getInternal(NodePtr node, Value &value); // 从缓存中获取数据
 
@@ -180,13 +393,19 @@ namespace XCache
         double agingFactor = 0.8;      // 频率衰减因子
         int operationCount = 0;         // 操作计数器
         
-        std::mutex mtx;
+        mutable std::mutex mtx;
+        std::pmr::memory_resource *resource;
         NodeMap nodeMap; // key到节点的映射
-        std::unordered_map<int, Freqlist<Key, Value> *> freqMap;
+        std::pmr::unordered_map<int, Freqlist<Key, Value> *> freqMap;
+        uint64_t nextStamp = 0;
+        uint64_t clears = 0;     // clear次数，游标据此发现遍历期间的清空
+        bool retiredAny = false; // 是否有交给XReclaimer的旧结构
+        XReclaimer &reclaimer = XReclaimer::instance(); // 构造时创建，见XReclaimer.h
+        std::shared_ptr<XEvictionStats> evictionStats; // 为空时不统计
     };
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::getInternal(NodePtr node, Value &value)
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::getInternal(NodePtr node, Value &value)
     {
         value = node->value;
         removeFromFreqlist(node);
@@ -199,22 +418,25 @@ namespace XCache
         addFreqNum();
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::putInternal(Key key, Value value)
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::putInternal(Key key, Value value)
     {
         if (nodeMap.size() == capacity)
         {
             kickout();
         }
-        NodePtr node = std::make_shared<Node>(key, value);
+        NodePtr node = makePmrShared<Node>(resource, key, value);
         nodeMap[key] = node;
         addToFreqlist(node);
         addFreqNum();
         minFreq = std::min(minFreq, 1);
+        Tracer::onInsert(this, key);
+        if (evictionStats)
+            evictionStats->onInsert(evictionKeyHash(key));
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::kickout()
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::kickout()
     {
         auto it = freqMap.find(minFreq);
         if (it == freqMap.end() || it->second->isEmpty())
@@ -228,30 +450,34 @@ namespace XCache
         removeFromFreqlist(node);
         nodeMap.erase(node->key);
         decreaseFreqNum(node->freq);
+        Tracer::onEvict(this, node->key);
+        if (evictionStats)
+            evictionStats->onEvict(evictionKeyHash(node->key));
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::addToFreqlist(NodePtr node)
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::addToFreqlist(NodePtr node)
     {
         if (!node)
             return;
         if (freqMap.find(node->freq) == freqMap.end()) // 如果频率列表不存在，则创建一个新的频率列表
         {
-            freqMap[node->freq] = new Freqlist<Key, Value>(node->freq);
+            freqMap[node->freq] = newPmrObject<Freqlist<Key, Value>>(resource, node->freq, resource);
         }
+        node->stamp = ++nextStamp;
         freqMap[node->freq]->addNode(node); // 将节点添加到对应频率的频率列表中
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::removeFromFreqlist(NodePtr node)
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::removeFromFreqlist(NodePtr node)
     {
         if (!node)
             return;
         freqMap[node->freq]->removeNode(node);
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::addFreqNum()
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::addFreqNum()
     {
         curTotalFreq++;
         operationCount++;
@@ -268,8 +494,8 @@ namespace XCache
         }
     }
     
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::performAging()
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::performAging()
     {
         if (nodeMap.empty())
             return;
@@ -300,8 +526,8 @@ namespace XCache
         updateMinFreq();
     }
     
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::recalculateFreqStats()
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::recalculateFreqStats()
     {
         curTotalFreq = 0;
         for (const auto& pair : nodeMap)
@@ -316,8 +542,8 @@ namespace XCache
             curAverageFreq = curTotalFreq / nodeMap.size();
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::decreaseFreqNum(int num)
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::decreaseFreqNum(int num)
     {
         curTotalFreq -= num;
         if (nodeMap.size() == 0)
@@ -326,8 +552,8 @@ namespace XCache
             curAverageFreq = curTotalFreq / nodeMap.size();
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::HandleOverMaxAvgFreq()
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::HandleOverMaxAvgFreq()
     {
         if (nodeMap.empty())
             return;
@@ -353,8 +579,8 @@ namespace XCache
         updateMinFreq();
     }
 
-    template <typename Key, typename Value>
-    void XLFUCache<Key, Value>::updateMinFreq()
+    template <typename Key, typename Value, typename Tracer>
+    void XLFUCache<Key, Value, Tracer>::updateMinFreq()
     {
         minFreq = INT8_MAX;
         for (const auto &pair : freqMap)
@@ -367,4 +593,93 @@ namespace XCache
         if (minFreq == INT8_MAX)
             minFreq = 1;
     }
+
+    // 对LFU进行分片操作，每个分片独立加锁，降低高并发下的锁竞争
+    template <typename Key, typename Value, typename Tracer = XNoopTracer>
+    class XHashLFUCache : public XComputeOps<XHashLFUCache<Key, Value, Tracer>, Key, Value>
+    {
+    public:
+        XHashLFUCache(size_t capacity, int sliceNum, int maxAvgFreq = 1000000,
+                      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : sliceNum(sliceNum > 0 ? sliceNum : 1), capacity(capacity)
+        {
+            size_t sliceCapacity = std::ceil(capacity / static_cast<double>(this->sliceNum));
+            for (int i = 0; i < this->sliceNum; ++i)
+            {
+                sliceCaches.emplace_back(new XLFUCache<Key, Value, Tracer>(sliceCapacity, maxAvgFreq, resource));
+            }
+        }
+
+        void put(Key key, Value value)
+        {
+            sliceCaches[Hash(key) % sliceNum]->put(key, value);
+        }
+
+        bool get(Key key, Value &value)
+        {
+            return sliceCaches[Hash(key) % sliceNum]->get(key, value);
+        }
+
+        Value get(Key key)
+        {
+            Value value{};
+            get(key, value);
+            return value;
+        }
+
+        void remove(Key key)
+        {
+            sliceCaches[Hash(key) % sliceNum]->remove(key);
+        }
+
+        template <typename Pred>
+        bool removeIf(Key key, Pred &&pred)
+        {
+            return sliceCaches[Hash(key) % sliceNum]->removeIf(key, std::forward<Pred>(pred));
+        }
+
+        bool peek(Key key, Value &value) const
+        {
+            return sliceCaches[Hash(key) % sliceNum]->peek(key, value);
+        }
+
+        template <typename Fn>
+        Value modify(Key key, Fn &&fn)
+        {
+            return sliceCaches[Hash(key) % sliceNum]->modify(key, std::forward<Fn>(fn));
+        }
+
+        bool contains(Key key) const
+        {
+            return sliceCaches[Hash(key) % sliceNum]->contains(key);
+        }
+
+        // 逐个分片清空，每个分片O(1)
+        void clear()
+        {
+            for (auto &slice : sliceCaches)
+                slice->clear();
+        }
+
+        void purge() { clear(); }
+
+        // 所有分片共用同一个统计对象
+        void setEvictionStats(std::shared_ptr<XEvictionStats> stats)
+        {
+            for (auto &slice : sliceCaches)
+                slice->setEvictionStats(stats);
+        }
+
+    private:
+        size_t Hash(Key key) const
+        {
+            std::hash<Key> hf;
+            return hf(key);
+        }
+
+    private:
+        int sliceNum;
+        size_t capacity;
+        std::vector<std::unique_ptr<XLFUCache<Key, Value, Tracer>>> sliceCaches;
+    };
 } // namespace XCache
\ No newline at end of file
@@ -1,23 +1,32 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <list>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
 
+#include "XCacheCursor.h"
 #include "XCachePolicy.h"
+#include "XEvictionStats.h"
+#include "XMemoryResource.h"
+#include "XReclaimer.h"
+#include "XTracer.h"
 
 namespace XCache {
-template <typename Key, typename Value> class XLRUCache;
+template <typename Key, typename Value, typename Tracer> class XLRUCache;
 
 template <typename Key, typename Value> class LRUNode {
 private:
   Key key;
   Value value;
   size_t accesscount;
+  uint64_t stamp = 0; // 最近一次移到MRU端的序号，链表从LRU到MRU递增，供游标定位
   std::weak_ptr<LRUNode<Key, Value>> prev;
   std::shared_ptr<LRUNode<Key, Value>> next;
 
@@ -32,24 +41,47 @@ public:
   void incrementAccessCount() { accesscount++; }
   ~LRUNode() = default;
 
-  friend class XLRUCache<Key, Value>;
+  template <typename, typename, typename> friend class XLRUCache;
 };
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Tracer = XNoopTracer>
 class XLRUCache : public XCachePolicy<Key, Value> {
   using LRUNodeType = LRUNode<Key, Value>;
   using NodePtr = std::shared_ptr<LRUNodeType>;
-  using NodeMap = std::unordered_map<Key, NodePtr>;
+  using NodeMap = std::pmr::unordered_map<Key, NodePtr>;
 
 public:
-  XLRUCache(int capacity) : capacity(capacity) { initializeList(); }
+  using ModifyFn = typename XCachePolicy<Key, Value>::ModifyFn;
+  using RemovePred = typename XCachePolicy<Key, Value>::RemovePred;
+  using Cursor = XCacheCursor<Key, Value, XLRUCache>;
+
+  // 游标位置：node为下一个要访问的节点，stamp为保存时它的stamp，
+  // bound为已返回节点中最小的stamp，epoch为开始遍历时的clear次数
+  struct CursorPosition {
+    NodePtr node;
+    uint64_t stamp = 0;
+    uint64_t bound = UINT64_MAX;
+    uint64_t epoch = 0;
+    bool started = false;
+  };
+
+  // resource见XMemoryResource.h
+  XLRUCache(int capacity, std::pmr::memory_resource *resource =
+                              std::pmr::get_default_resource())
+      : capacity(capacity), resource(resource), nodeMap(resource) {
+    initializeList();
+  }
 
-  ~XLRUCache() override = default;
+  ~XLRUCache() override {
+    releaseList(std::move(dummyHead));
+    if (retiredAny)
+      reclaimer.drain(); // 后台释放完成前resource不能销毁
+  }
 
   void put(Key key, Value value) override {
     if (capacity <= 0)
       return;
-    std::lock_guard<std::mutex> lock(mtx);
+    XTracedLock<Tracer> lock(mtx, this);
     auto it = nodeMap.find(key);
     if (it != nodeMap.end()) {
       updateExistingNode(it->second, value);
@@ -59,13 +91,19 @@ public:
   }
 
   bool get(Key key, Value &value) override {
-    std::lock_guard<std::mutex> lock(mtx);
+    XTracedLock<Tracer> lock(mtx, this);
     auto it = nodeMap.find(key);
     if (it != nodeMap.end()) {
       moveToMostRecent(it->second);
       value = it->second->getValue();
+      Tracer::onHit(this, key);
+      if (evictionStats)
+        evictionStats->onHit(evictionKeyHash(key));
       return true;
     }
+    Tracer::onMiss(this, key);
+    if (evictionStats)
+      evictionStats->onMiss(evictionKeyHash(key));
     return false;
   }
 
@@ -75,13 +113,89 @@ public:
     return v;
   }
 
-  void remove(Key key) {
-    std::lock_guard<std::mutex> lock(mtx);
+  void remove(Key key) override {
+    XTracedLock<Tracer> lock(mtx, this);
     auto it = nodeMap.find(key);
     if (it != nodeMap.end()) {
       removeNode(it->second);
       nodeMap.erase(it);
+      if (evictionStats)
+        evictionStats->onRemove(evictionKeyHash(key));
+    }
+  }
+
+  bool removeIf(Key key, const RemovePred &pred) override {
+    XTracedLock<Tracer> lock(mtx, this);
+    auto it = nodeMap.find(key);
+    if (it == nodeMap.end() || !pred(it->second->value))
+      return false;
+    removeNode(it->second);
+    nodeMap.erase(it);
+    if (evictionStats)
+      evictionStats->onRemove(evictionKeyHash(key));
+    return true;
+  }
+
+  Value modify(Key key, const ModifyFn &fn) override {
+    XTracedLock<Tracer> lock(mtx, this);
+    auto it = nodeMap.find(key);
+    if (it != nodeMap.end()) {
+      Value value = it->second->value;
+      if (fn(value, true))
+        it->second->value = value;
+      moveToMostRecent(it->second);
+      Tracer::onHit(this, key);
+      if (evictionStats)
+        evictionStats->onHit(evictionKeyHash(key));
+      return value;
     }
+    Tracer::onMiss(this, key);
+    if (evictionStats)
+      evictionStats->onMiss(evictionKeyHash(key));
+    Value value{};
+    if (fn(value, false) && capacity > 0)
+      addNewNode(key, value);
+    return value;
+  }
+
+  bool peek(Key key, Value &value) const override {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = nodeMap.find(key);
+    if (it == nodeMap.end())
+      return false;
+    value = it->second->getValue();
+    return true;
+  }
+
+  bool contains(Key key) const override {
+    std::lock_guard<std::mutex> lock(mtx);
+    return nodeMap.find(key) != nodeMap.end();
+  }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    std::lock_guard<std::mutex> lock(mtx);
+    evictionStats = std::move(stats);
+  }
+
+  // 新的空链表在锁外建好，锁内只交换索引和链表头；不逐个上报淘汰统计与追踪事件
+  void clear() override {
+    auto retired = std::make_shared<Retired>(resource);
+    NodePtr head = makePmrShared<LRUNodeType>(resource, Key(), Value());
+    NodePtr tail = makePmrShared<LRUNodeType>(resource, Key(), Value());
+    head->next = tail;
+    tail->prev = head;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      retired->nodes.swap(nodeMap);
+      retired->head = std::move(dummyHead);
+      dummyHead = std::move(head);
+      dummyTail = std::move(tail);
+      clears++;
+      retiredAny = true;
+      if (evictionStats)
+        evictionStats->onClear();
+    }
+    reclaimer.retire(std::move(retired), resource);
   }
 
   size_t size() {
@@ -89,6 +203,43 @@ public:
     return nodeMap.size();
   }
 
+  size_t getCapacity() const { return capacity > 0 ? capacity : 0; }
+
+  // 从MRU到LRU遍历，语义见XCacheCursor.h
+  Cursor cursor(size_t chunkSize = 1024) const {
+    return Cursor(*this, chunkSize);
+  }
+
+  // 在锁内从position继续，最多取出budget个条目追加到out，遍历结束时返回true
+  bool cursorChunk(CursorPosition &position, size_t budget,
+                   std::vector<std::pair<Key, Value>> &out) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!position.started) {
+      position.started = true;
+      position.epoch = clears;
+    } else if (position.epoch != clears) {
+      position.node = nullptr; // 遍历期间被clear，之前的条目都已不存在
+      return true;
+    }
+    NodePtr node = position.node;
+    // 位置节点被删除（next为空）或被访问移到了MRU端（stamp改变）时，从MRU端重新定位
+    if (!node || !node->next || node->stamp != position.stamp)
+      node = dummyTail->prev.lock();
+    // 跳过已返回和bound之后移动过的节点；跳过的节点也计入budget，
+    // 重新定位要走过的节点较多时分到之后的分块里，锁内的工作量不超过一个分块
+    for (; node != dummyHead && node->stamp >= position.bound && budget > 0;
+         --budget)
+      node = node->prev.lock();
+    for (; node != dummyHead && budget > 0; --budget) {
+      out.emplace_back(node->key, node->value);
+      position.bound = node->stamp;
+      node = node->prev.lock();
+    }
+    position.node = node;
+    position.stamp = node->stamp;
+    return node == dummyHead;
+  }
+
   Key getOldestKey() {
     std::lock_guard<std::mutex> lock(mtx);
     if (dummyHead->next && dummyHead->next != dummyTail) {
@@ -98,9 +249,25 @@ public:
   }
 
 private:
+  // clear换下的索引与链表，由XReclaimer在后台析构
+  struct Retired {
+    explicit Retired(std::pmr::memory_resource *resource) : nodes(resource) {}
+    ~Retired() { releaseList(std::move(head)); }
+    NodeMap nodes;
+    NodePtr head;
+  };
+
+  // 逐个断开next强引用，避免长链表在析构时递归过深导致栈溢出
+  static void releaseList(NodePtr node) {
+    while (node) {
+      NodePtr next = std::move(node->next);
+      node = std::move(next);
+    }
+  }
+
   void initializeList() {
-    dummyHead = std::make_shared<LRUNodeType>(Key(), Value());
-    dummyTail = std::make_shared<LRUNodeType>(Key(), Value());
+    dummyHead = makePmrShared<LRUNodeType>(resource, Key(), Value());
+    dummyTail = makePmrShared<LRUNodeType>(resource, Key(), Value());
     dummyHead->next = dummyTail;
     dummyTail->prev = dummyHead;
   }
@@ -114,9 +281,12 @@ private:
     if (nodeMap.size() >= capacity) {
       evictLeastRecent();
     }
-    NodePtr newNode = std::make_shared<LRUNodeType>(key, value);
+    NodePtr newNode = makePmrShared<LRUNodeType>(resource, key, value);
     insertNode(newNode);
     nodeMap[key] = newNode;
+    Tracer::onInsert(this, key);
+    if (evictionStats)
+      evictionStats->onInsert(evictionKeyHash(key));
   }
 
   void moveToMostRecent(NodePtr node) {
@@ -125,6 +295,7 @@ private:
   }
 
   void insertNode(NodePtr node) {
+    node->stamp = ++nextStamp;
     node->prev = dummyTail->prev;
     node->next = dummyTail;
     dummyTail->prev.lock()->next = node;
@@ -143,32 +314,49 @@ private:
     NodePtr node = dummyHead->next;
     removeNode(node);
     nodeMap.erase(node->getKey());
+    Tracer::onEvict(this, node->getKey());
+    if (evictionStats)
+      evictionStats->onEvict(evictionKeyHash(node->getKey()));
   }
 
   int capacity;
+  std::pmr::memory_resource *resource;
   NodeMap nodeMap;
-  std::mutex mtx;
+  mutable std::mutex mtx;
   NodePtr dummyHead;
   NodePtr dummyTail;
+  uint64_t nextStamp = 0;
+  uint64_t clears = 0;     // clear次数，游标据此发现遍历期间的清空
+  bool retiredAny = false; // 是否有交给XReclaimer的旧结构
+  XReclaimer &reclaimer = XReclaimer::instance(); // 构造时创建，见XReclaimer.h
+  std::shared_ptr<XEvictionStats> evictionStats; // 为空时不统计
 };
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Tracer = XNoopTracer>
 class XLRUKCache
     : public XLRUCache<
-          Key,
-          Value> // LRU优化的K版本，只有在历史访问次数达到K次时，才会将节点移动到主缓存中
+          Key, Value,
+          Tracer> // LRU优化的K版本，只有在历史访问次数达到K次时，才会将节点移动到主缓存中
 {
+  using Base = XLRUCache<Key, Value, Tracer>;
+
 public:
-  XLRUKCache(int capacity, int _k = 2, double historyRatio = 2.5)
-      : XLRUCache<Key, Value>(capacity), // 初始化主缓存的容量
-        historyList(std::make_unique<XLRUCache<Key, size_t>>(static_cast<int>(
-            capacity * historyRatio))), // 自动设置历史缓存为容量的2.5倍
-        k(_k) {}
+  using typename Base::ModifyFn;
+  using typename Base::RemovePred;
+
+  XLRUKCache(int capacity, int _k = 2, double historyRatio = 2.5,
+             std::pmr::memory_resource *resource =
+                 std::pmr::get_default_resource())
+      : Base(capacity, resource), // 初始化主缓存的容量
+        historyList(std::make_unique<XLRUCache<Key, size_t>>(
+            static_cast<int>(capacity * historyRatio),
+            resource)), // 自动设置历史缓存为容量的2.5倍
+        k(_k), historyMap(resource) {}
 
   ~XLRUKCache() = default;
 
   bool get(Key key, Value &value) override {
-    bool inMainCache = XLRUCache<Key, Value>::get(key, value);
+    bool inMainCache = Base::get(key, value);
 
     size_t historycount = historyList->get(key);
     historycount++;
@@ -186,7 +374,8 @@ public:
         Value storedValue = it->second;
         historyList->remove(key);
         historyMap.erase(it);
-        XLRUCache<Key, Value>::put(key, storedValue);
+        Tracer::onPromote(this, key);
+        Base::put(key, storedValue);
         value = storedValue;
         return true;
       }
@@ -197,7 +386,7 @@ public:
 
   Value get(Key key) {
     Value value{}; // 值初始化，避免找不到值的时候返回垃圾值
-    bool inMainCache = XLRUCache<Key, Value>::get(key, value);
+    bool inMainCache = Base::get(key, value);
 
     size_t historycount = historyList->get(key);
     historycount++;
@@ -215,7 +404,8 @@ public:
         Value storedValue = it->second;
         historyList->remove(key);
         historyMap.erase(it);
-        XLRUCache<Key, Value>::put(key, storedValue);
+        Tracer::onPromote(this, key);
+        Base::put(key, storedValue);
         return storedValue;
       }
     }
@@ -225,9 +415,9 @@ public:
 
   void put(Key key, Value value) override {
     Value existingValue{};
-    bool inMainCache = XLRUCache<Key, Value>::get(key, existingValue);
+    bool inMainCache = Base::get(key, existingValue);
     if (inMainCache) {
-      XLRUCache<Key, Value>::put(key, value);
+      Base::put(key, value);
       return;
     }
 
@@ -250,28 +440,106 @@ public:
         if (it != historyMap.end()) {
           Value storedValue = it->second;
           historyMap.erase(it);
-          XLRUCache<Key, Value>::put(key, storedValue);
+          Tracer::onPromote(this, key);
+          Base::put(key, storedValue);
         }
       }
     }
   }
 
+  // 主缓存命中时在其中更新；否则把历史表中暂存的值当作当前值，写回后按访问次数决定是否晋升，
+  // 未写回时与一次get相同，达到k次时晋升暂存的原值。两种情况都只增加一次历史计数。整个过程持有historyMtx，并发的modify不会在晋升时互相覆盖
+  Value modify(Key key, const ModifyFn &fn) override {
+    std::lock_guard<std::mutex> lock(historyMtx);
+    bool inMainCache = false;
+    Value result = Base::modify(key, [&](Value &value, bool present) {
+      inMainCache = present;
+      return present && fn(value, true);
+    });
+
+    size_t historyCount = historyList->get(key) + 1;
+    historyList->put(key, historyCount);
+    if (inMainCache)
+      return result;
+
+    auto it = historyMap.find(key);
+    bool present = it != historyMap.end();
+    Value value = present ? it->second : Value{};
+    if (!fn(value, present)) {
+      if (present && historyCount >= k) {
+        Tracer::onPromote(this, key);
+        Base::put(key, it->second);
+        historyMap.erase(it);
+        historyList->remove(key);
+      }
+      return value;
+    }
+    if (historyCount >= k) {
+      if (present)
+        historyMap.erase(it);
+      historyList->remove(key);
+      Tracer::onPromote(this, key);
+      Base::put(key, value);
+    } else {
+      historyMap[key] = value;
+    }
+    return value;
+  }
+
+  void remove(Key key) override {
+    Base::remove(key);
+    historyList->remove(key);
+    std::lock_guard<std::mutex> lock(historyMtx);
+    historyMap.erase(key);
+  }
+
+  // 主缓存与暂存的值各自判断；删除了任一处时一并丢弃访问历史
+  bool removeIf(Key key, const RemovePred &pred) override {
+    bool removed = Base::removeIf(key, pred);
+    std::lock_guard<std::mutex> lock(historyMtx);
+    auto it = historyMap.find(key);
+    if (it != historyMap.end() && pred(it->second)) {
+      historyMap.erase(it);
+      removed = true;
+    }
+    if (removed)
+      historyList->remove(key);
+    return removed;
+  }
+
+  // 主缓存、历史计数和暂存的值都换成空的
+  void clear() override {
+    auto retired = std::make_shared<std::pmr::unordered_map<Key, Value>>(
+        historyMap.get_allocator());
+    {
+      std::lock_guard<std::mutex> lock(historyMtx);
+      Base::clear();
+      historyList->clear();
+      retired->swap(historyMap);
+    }
+    XReclaimer::instance().retire(std::move(retired),
+                                  historyMap.get_allocator().resource());
+  }
+
 private:
   int k;
   std::unique_ptr<XLRUCache<Key, size_t>> historyList;
-  std::unordered_map<Key, Value> historyMap;
+  std::pmr::unordered_map<Key, Value> historyMap;
   std::mutex historyMtx; // 为historyMap添加独立的互斥锁
 };
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Tracer = XNoopTracer>
 class XHashLRUCaches // 对LRU进行分片操作，提高高并发使用的性能
-{
+    : public XComputeOps<XHashLRUCaches<Key, Value, Tracer>, Key, Value> {
 public:
-  XHashLRUCaches(int cacheSize, int sliceNum)
+  XHashLRUCaches(int cacheSize, int sliceNum,
+                 std::pmr::memory_resource *resource =
+                     std::pmr::get_default_resource())
       : cacheSize(cacheSize), sliceNum(sliceNum) {
     size_t sliceCapacity = std::ceil(cacheSize / static_cast<double>(sliceNum));
     for (int i = 0; i < sliceNum; ++i) {
-      sliceCaches.emplace_back(new XLRUCache<Key, Value>(sliceCapacity));
+      sliceCaches.emplace_back(
+          new XLRUCache<Key, Value, Tracer>(sliceCapacity, resource));
     }
   }
 
@@ -293,8 +561,43 @@ public:
     return value;
   }
 
+  void remove(Key key) {
+    size_t sliceIndex = Hash(key) % sliceNum;
+    sliceCaches[sliceIndex]->remove(key);
+  }
+
+  template <typename Pred> bool removeIf(Key key, Pred &&pred) {
+    return sliceCaches[Hash(key) % sliceNum]->removeIf(
+        key, std::forward<Pred>(pred));
+  }
+
+  bool peek(Key key, Value &value) const {
+    return sliceCaches[Hash(key) % sliceNum]->peek(key, value);
+  }
+
+  template <typename Fn> Value modify(Key key, Fn &&fn) {
+    return sliceCaches[Hash(key) % sliceNum]->modify(key,
+                                                      std::forward<Fn>(fn));
+  }
+
+  bool contains(Key key) const {
+    return sliceCaches[Hash(key) % sliceNum]->contains(key);
+  }
+
+  // 逐个分片清空，每个分片O(1)
+  void clear() {
+    for (auto &slice : sliceCaches)
+      slice->clear();
+  }
+
+  // 所有分片共用同一个统计对象
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) {
+    for (auto &slice : sliceCaches)
+      slice->setEvictionStats(stats);
+  }
+
 private:
-  size_t Hash(Key key) // 对key进行哈希，得到一个哈希值
+  size_t Hash(Key key) const // 对key进行哈希，得到一个哈希值
   {
     std::hash<Key> hf;
     return hf(key);
@@ -303,6 +606,7 @@ private:
 private:
   size_t cacheSize; // 总容量
   int sliceNum;     // 切片数量
-  std::vector<std::unique_ptr<XLRUCache<Key, Value>>> sliceCaches; // 切片缓存
+  std::vector<std::unique_ptr<XLRUCache<Key, Value, Tracer>>>
+      sliceCaches; // 切片缓存
 };
 } // namespace XCache
\ No newline at end of file
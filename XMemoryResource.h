@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// 各引擎的构造函数最后一个参数为std::pmr::memory_resource*（默认全局堆），
+// 节点、索引、频率桶、幽灵表和sketch都从这个resource分配，可以按租户统计内存、
+// 或者用monotonic_buffer_resource在销毁时一次性释放。
+//
+// resource必须比缓存活得久。同一个缓存内部可能在不同的锁下分配（LRU-K的历史表、
+// ARC的两个部分、W-TinyLFU的window与主区、分片缓存的各分片），多线程访问时需要
+// 线程安全的resource，例如synchronized_pool_resource；monotonic_buffer_resource与
+// unsynchronized_pool_resource只适合单线程或由调用方加锁的场景。
+// clear换下的旧结构只在isThreadSafeResource认定的resource上交给XReclaimer的后台线程释放，
+// 其余resource（包括自定义的）在调用clear的线程上直接释放，见XReclaimer.h
+namespace XCache {
+// 统计经过的分配量并转发给upstream，计数本身线程安全
+class XCountingResource : public std::pmr::memory_resource {
+public:
+  explicit XCountingResource(
+      std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : upstream(upstream) {}
+
+  size_t getBytesInUse() const {
+    return bytesInUse.load(std::memory_order_relaxed);
+  }
+  size_t getPeakBytes() const {
+    return peakBytes.load(std::memory_order_relaxed);
+  }
+  size_t getAllocations() const {
+    return allocations.load(std::memory_order_relaxed);
+  }
+  std::pmr::memory_resource *getUpstream() const { return upstream; }
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    void *p = upstream->allocate(bytes, alignment);
+    size_t now = bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (now > peak && !peakBytes.compare_exchange_weak(
+                             peak, now, std::memory_order_relaxed))
+      ;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return p;
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    upstream->deallocate(p, bytes, alignment);
+    bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource *upstream;
+  std::atomic<size_t> bytesInUse{0};
+  std::atomic<size_t> peakBytes{0};
+  std::atomic<size_t> allocations{0};
+};
+
+// 能否在其他线程上归还：全局堆、synchronized_pool_resource，以及上游线程安全的XCountingResource
+inline bool isThreadSafeResource(std::pmr::memory_resource *resource) {
+  if (resource == std::pmr::new_delete_resource())
+    return true;
+  if (dynamic_cast<std::pmr::synchronized_pool_resource *>(resource))
+    return true;
+  if (auto *counting = dynamic_cast<XCountingResource *>(resource))
+    return isThreadSafeResource(counting->getUpstream());
+  return false;
+}
+
+// 控制块与对象一起从resource分配
+template <typename T, typename... Args>
+std::shared_ptr<T> makePmrShared(std::pmr::memory_resource *resource,
+                                 Args &&...args) {
+  return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource),
+                                 std::forward<Args>(args)...);
+}
+
+// 从resource分配单个对象，对应C++20的polymorphic_allocator::new_object/delete_object
+template <typename T, typename... Args>
+T *newPmrObject(std::pmr::memory_resource *resource, Args &&...args) {
+  void *p = resource->allocate(sizeof(T), alignof(T));
+  try {
+    return ::new (p) T(std::forward<Args>(args)...);
+  } catch (...) {
+    resource->deallocate(p, sizeof(T), alignof(T));
+    throw;
+  }
+}
+
+template <typename T>
+void deletePmrObject(std::pmr::memory_resource *resource, T *object) {
+  if (!object)
+    return;
+  object->~T();
+  resource->deallocate(object, sizeof(T), alignof(T));
+}
+} // namespace XCache
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "XCachePolicy.h"
+
+namespace XCache {
+// 引擎中实际存放的值：插入时所属命名空间的代数 + 用户的值
+template <typename Value> struct XGenerationEntry {
+  uint64_t generation = 0;
+  Value value{};
+};
+
+// 按命名空间整体失效：每个key通过namespaceOf归属一个命名空间（如租户），条目记录插入时该命名空间的代数，
+// invalidateNamespace只把代数加一，O(1)让该命名空间的所有条目失效，不需要逐个remove。
+// 失效的条目惰性回收：get遇到时用removeIf在引擎锁内确认仍失效后删除（不会删掉并发put写入的新条目），modify写回时覆盖，peek/contains只当作不存在；没有被访问的失效条目
+// 不会再被命中而刷新，在LRU类引擎中随淘汰顺序移到末尾被淘汰，LFU中保留原频率直到衰减。
+// 命名空间的代数表只增不减，适合数量有限的命名空间
+template <typename Key, typename Value, typename Namespace = std::string>
+class XNamespaceCache : public XCachePolicy<Key, Value> {
+public:
+  using Entry = XGenerationEntry<Value>;
+  using Engine = XCachePolicy<Key, Entry>;
+  using NamespaceOf = std::function<Namespace(const Key &key)>;
+
+  // engine以Entry为值类型，例如makeCachePolicy<Key, XGenerationEntry<Value>>("lru", n)
+  XNamespaceCache(std::unique_ptr<Engine> engine, NamespaceOf namespaceOf)
+      : engine(std::move(engine)), namespaceOf(std::move(namespaceOf)) {}
+
+  void put(Key key, Value value) override {
+    Entry entry;
+    entry.generation = generationOf(namespaceOf(key));
+    entry.value = std::move(value);
+    engine->put(key, std::move(entry));
+  }
+
+  bool get(Key key, Value &value) override {
+    Entry entry;
+    if (!engine->get(key, entry))
+      return false;
+    uint64_t generation = generationOf(namespaceOf(key));
+    if (entry.generation != generation) {
+      if (engine->removeIf(key, [generation](const Entry &stored) {
+            return stored.generation != generation;
+          }))
+        staleReclaimed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    value = std::move(entry.value);
+    return true;
+  }
+
+  Value get(Key key) override {
+    Value value{};
+    get(key, value);
+    return value;
+  }
+
+  void remove(Key key) override { engine->remove(key); }
+
+  // 失效的条目对pred表现为不存在
+  bool removeIf(Key key,
+                const typename XCachePolicy<Key, Value>::RemovePred &pred) override {
+    uint64_t generation = generationOf(namespaceOf(key));
+    return engine->removeIf(key, [&](const Entry &stored) {
+      return stored.generation == generation && pred(stored.value);
+    });
+  }
+
+  // 失效的条目对fn表现为不存在，写回时带上当前代数
+  Value modify(Key key,
+               const typename XCachePolicy<Key, Value>::ModifyFn &fn) override {
+    uint64_t generation = generationOf(namespaceOf(key));
+    Value result{};
+    engine->modify(key, [&](Entry &stored, bool present) {
+      if (present && stored.generation == generation) {
+        bool wrote = fn(stored.value, true);
+        result = stored.value;
+        return wrote;
+      }
+      // 不存在或已失效：在副本上调用fn，只有写回时才覆盖引擎中的条目
+      Entry fresh;
+      fresh.generation = generation;
+      bool wrote = fn(fresh.value, false);
+      result = fresh.value;
+      if (wrote)
+        stored = std::move(fresh);
+      return wrote;
+    });
+    return result;
+  }
+
+  bool peek(Key key, Value &value) const override {
+    Entry entry;
+    if (!engine->peek(key, entry) ||
+        entry.generation != generationOf(namespaceOf(key)))
+      return false;
+    value = std::move(entry.value);
+    return true;
+  }
+
+  bool contains(Key key) const override {
+    Value value;
+    return peek(key, value);
+  }
+
+  // 代数表保留，清空后写入的条目仍带当前代数
+  void clear() override { engine->clear(); }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    engine->setEvictionStats(std::move(stats));
+  }
+
+  // 让命名空间中当前的所有条目失效，返回新的代数
+  uint64_t invalidateNamespace(const Namespace &ns) {
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    return ++generations[ns];
+  }
+
+  // 每次put/get都要查代数，用读锁让它们并行，只有invalidateNamespace独占
+  uint64_t generationOf(const Namespace &ns) const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    auto it = generations.find(ns);
+    return it == generations.end() ? 0 : it->second;
+  }
+
+  // 访问时发现并回收的失效条目数
+  uint64_t getStaleReclaimed() const {
+    return staleReclaimed.load(std::memory_order_relaxed);
+  }
+
+  Engine &getEngine() { return *engine; }
+
+private:
+  std::unique_ptr<Engine> engine;
+  NamespaceOf namespaceOf;
+  mutable std::shared_mutex mtx;
+  std::unordered_map<Namespace, uint64_t> generations;
+  std::atomic<uint64_t> staleReclaimed{0};
+};
+} // namespace XCache
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "XCachePolicy.h"
+
+namespace XCache {
+struct XNegativeCacheOptions {
+  size_t keysPerGeneration = 100000; // 每代记录的不存在key数，写满后轮换
+  double falsePositiveRate = 0.001;  // 每代的目标误判率
+  // 大于0时一代存在超过该时长也轮换，限制后端新增的key被当作不存在的时间
+  std::chrono::milliseconds maxAge{0};
+};
+
+// 近期确认不存在的key：两代计数Bloom过滤器，每个计数器4位。查询看两代，写入只进当前代，
+// 当前代写满或超时后成为上一代，原来的上一代清空复用，一个key最多保留两个周期。
+// invalidate把key的计数器各减一（饱和的15不再变化），put之后该key不再被当作不存在；
+// 与普通Bloom过滤器一样，不在集合中的key（包括刚invalidate的）约以falsePositiveRate的概率误判
+template <typename Key> class XNegativeFilter {
+public:
+  explicit XNegativeFilter(
+      XNegativeCacheOptions options = XNegativeCacheOptions(),
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : options(options), current(resource), previous(resource) {
+    double keys = static_cast<double>(std::max<size_t>(options.keysPerGeneration, 1));
+    double rate = std::clamp(options.falsePositiveRate, 1e-9, 0.5);
+    // 最优计数器数 m = -n·ln(p)/ln(2)^2，哈希函数数 k = log2(1/p)
+    double bits = -keys * std::log(rate) / (std::log(2.0) * std::log(2.0));
+    // 计数器数取偶数以便两两装进一个字节；不取2的幂，避免最多一倍的浪费
+    counters = std::max<size_t>(64, static_cast<size_t>(std::ceil(bits / 2)) * 2);
+    hashes = std::clamp<size_t>(static_cast<size_t>(std::lround(-std::log2(rate))), 1, 16);
+    current.counters.assign(counters / 2, 0);
+    previous.counters.assign(counters / 2, 0);
+    current.start = previous.start = std::chrono::steady_clock::now();
+  }
+
+  bool mayContain(const Key &key) {
+    uint64_t h = mix(std::hash<Key>()(key));
+    std::lock_guard<std::mutex> lock(mtx);
+    rotateIfExpired();
+    return contains(current, h) || contains(previous, h);
+  }
+
+  // 调用loader之前取得，loader返回不存在后随add传回：期间有invalidate则不记录
+  uint64_t version(const Key &key) {
+    uint64_t h = mix(std::hash<Key>()(key));
+    std::lock_guard<std::mutex> lock(mtx);
+    return stripeVersions[h % kStripes];
+  }
+
+  void add(const Key &key, uint64_t sinceVersion) {
+    uint64_t h = mix(std::hash<Key>()(key));
+    std::lock_guard<std::mutex> lock(mtx);
+    if (stripeVersions[h % kStripes] != sinceVersion)
+      return;
+    rotateIfExpired();
+    if (contains(current, h))
+      return;
+    for (size_t i = 0; i < hashes; ++i) {
+      size_t index = slot(h, i);
+      uint8_t value = counterAt(current, index);
+      if (value < 15)
+        setCounter(current, index, value + 1);
+    }
+    if (++current.keys >= options.keysPerGeneration)
+      rotate();
+  }
+
+  void invalidate(const Key &key) {
+    uint64_t h = mix(std::hash<Key>()(key));
+    std::lock_guard<std::mutex> lock(mtx);
+    ++stripeVersions[h % kStripes];
+    for (Generation *generation : {&current, &previous}) {
+      if (!contains(*generation, h))
+        continue;
+      for (size_t i = 0; i < hashes; ++i) {
+        size_t index = slot(h, i);
+        uint8_t value = counterAt(*generation, index);
+        if (value < 15)
+          setCounter(*generation, index, value - 1);
+      }
+    }
+  }
+
+  // 两代计数器占用的字节数
+  size_t memoryBytes() const {
+    return current.counters.size() + previous.counters.size();
+  }
+
+  // 两代中记录过的key数（invalidate不减少）
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return current.keys + previous.keys;
+  }
+
+  size_t hashCount() const { return hashes; }
+
+private:
+  struct Generation {
+    explicit Generation(std::pmr::memory_resource *resource)
+        : counters(resource) {}
+    std::pmr::vector<uint8_t> counters; // 每字节两个4位计数器
+    size_t keys = 0;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  static constexpr size_t kStripes = 256;
+
+  static uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+  }
+
+  // 双重哈希：第i个位置由 h1 + i·h2 的高32位乘以计数器数映射到 [0, counters)
+  size_t slot(uint64_t h, size_t i) const {
+    uint64_t g = h + i * ((h << 32) | (h >> 32) | 1);
+    return static_cast<size_t>(((g >> 32) * counters) >> 32);
+  }
+
+  static uint8_t counterAt(const Generation &generation, size_t index) {
+    return (generation.counters[index >> 1] >> ((index & 1) * 4)) & 0xF;
+  }
+
+  static void setCounter(Generation &generation, size_t index, uint8_t value) {
+    uint8_t &byte = generation.counters[index >> 1];
+    int shift = (index & 1) * 4;
+    byte = static_cast<uint8_t>((byte & ~(0xF << shift)) | (value << shift));
+  }
+
+  bool contains(const Generation &generation, uint64_t h) const {
+    for (size_t i = 0; i < hashes; ++i) {
+      if (counterAt(generation, slot(h, i)) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  void rotateIfExpired() {
+    if (options.maxAge.count() > 0 &&
+        std::chrono::steady_clock::now() - current.start >= options.maxAge)
+      rotate();
+  }
+
+  void rotate() {
+    std::swap(current, previous);
+    std::fill(current.counters.begin(), current.counters.end(), 0);
+    current.keys = 0;
+    current.start = std::chrono::steady_clock::now();
+  }
+
+  XNegativeCacheOptions options;
+  size_t counters = 0;
+  size_t hashes = 1;
+  mutable std::mutex mtx;
+  Generation current;
+  Generation previous;
+  std::array<uint64_t, kStripes> stripeVersions{};
+};
+
+struct XLoadingStats {
+  uint64_t loads = 0;        // 调用loader（访问后端）的次数
+  uint64_t absentLoads = 0;  // 其中后端确认不存在的次数
+  uint64_t negativeHits = 0; // 被负缓存拦下、省掉的后端访问
+};
+
+// 带加载器的缓存：未命中时调用loader读取后端，找到则写入engine。后端确认不存在的key记入
+// XNegativeFilter，之后的未命中直接返回不存在。put与写回的modify会invalidate过滤器；
+// loader执行期间同一key被写入时，这次的不存在结果不会被记录。
+// loader在锁外执行，同一key的并发未命中会各自访问后端；modify不调用loader
+template <typename Key, typename Value,
+          typename Engine = XCachePolicy<Key, Value>>
+class XLoadingCache : public XCachePolicy<Key, Value> {
+public:
+  // 找到时填写value并返回true
+  using Loader = std::function<bool(const Key &key, Value &value)>;
+
+  XLoadingCache(std::unique_ptr<Engine> engine, Loader loader,
+                XNegativeCacheOptions options = XNegativeCacheOptions())
+      : engine(std::move(engine)), loader(std::move(loader)), filter(options) {}
+
+  void put(Key key, Value value) override {
+    filter.invalidate(key);
+    engine->put(key, value);
+  }
+
+  bool get(Key key, Value &value) override {
+    if (engine->get(key, value))
+      return true;
+    if (filter.mayContain(key)) {
+      negativeHits.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    uint64_t version = filter.version(key);
+    loads.fetch_add(1, std::memory_order_relaxed);
+    if (loader(key, value)) {
+      engine->put(key, value);
+      return true;
+    }
+    absentLoads.fetch_add(1, std::memory_order_relaxed);
+    filter.add(key, version);
+    return false;
+  }
+
+  Value get(Key key) override {
+    Value value{};
+    get(key, value);
+    return value;
+  }
+
+  // 只删除缓存中的条目，不表示后端不存在
+  void remove(Key key) override { engine->remove(key); }
+
+  bool removeIf(Key key,
+                const typename XCachePolicy<Key, Value>::RemovePred &pred) override {
+    return engine->removeIf(key, pred);
+  }
+
+  Value modify(Key key,
+               const typename XCachePolicy<Key, Value>::ModifyFn &fn) override {
+    bool wrote = false;
+    Value value = engine->modify(key, [&](Value &v, bool present) {
+      wrote = fn(v, present);
+      return wrote;
+    });
+    if (wrote)
+      filter.invalidate(key);
+    return value;
+  }
+
+  bool peek(Key key, Value &value) const override {
+    return engine->peek(key, value);
+  }
+  bool contains(Key key) const override { return engine->contains(key); }
+
+  // 只清空缓存，负缓存记录的不存在key保留
+  void clear() override { engine->clear(); }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    engine->setEvictionStats(std::move(stats));
+  }
+
+  XLoadingStats getStats() const {
+    XLoadingStats stats;
+    stats.loads = loads.load(std::memory_order_relaxed);
+    stats.absentLoads = absentLoads.load(std::memory_order_relaxed);
+    stats.negativeHits = negativeHits.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  const XNegativeFilter<Key> &getFilter() const { return filter; }
+  Engine &getEngine() { return *engine; }
+
+private:
+  std::unique_ptr<Engine> engine;
+  Loader loader;
+  XNegativeFilter<Key> filter;
+  std::atomic<uint64_t> loads{0};
+  std::atomic<uint64_t> absentLoads{0};
+  std::atomic<uint64_t> negativeHits{0};
+};
+} // namespace XCache
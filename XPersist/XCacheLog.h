@@ -0,0 +1,754 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace XCache {
+// 日志记录类型；Clear清空之前的所有条目，没有key和value
+enum class LogRecordType : uint8_t { Put = 1, Remove = 2, Clear = 3 };
+
+// 日志记录头，后面紧跟key字节和value字节
+struct LogRecordHeader {
+  uint32_t checksum;  // 覆盖头部其余字段与负载的CRC32
+  uint32_t keySize;   // key字节数
+  uint32_t valueSize; // value字节数（Remove/Clear记录为0）
+  uint8_t type;       // LogRecordType
+  uint8_t reserved[3];
+  uint64_t lsn; // 日志序列号，单调递增
+};
+static_assert(sizeof(LogRecordHeader) == 24, "日志记录头必须紧凑");
+
+// 回放时交给上层的记录视图，key/value直接指向mmap区域，不做拷贝
+struct LogRecordView {
+  LogRecordType type;
+  uint64_t lsn;
+  std::string_view key;
+  std::string_view value;
+};
+
+enum class XDurability {
+  Async,      // 后台每commitInterval写入并fdatasync一个批次，写入者不等待，崩溃最多丢失一个批次
+  GroupCommit // put/remove返回前等待所在批次fdatasync完成
+};
+
+struct XLogOptions {
+  XDurability durability = XDurability::GroupCommit;
+  size_t segmentBytes = 64u << 20; // 单个日志段上限，超过后封存并切换新段
+  size_t maxBatchBytes = 1u << 20; // 组提交缓冲达到该大小立即刷盘
+  std::chrono::milliseconds commitInterval{2}; // Async模式下的最长攒批时间
+  size_t compactSegments = 4; // 封存段数量达到该值时触发检查点+压缩
+  std::chrono::milliseconds checkpointInterval{60000}; // 周期检查点间隔
+  // 检查点保留的最近写入条目上限，0表示不限；XPersistentCache在为0时取引擎容量
+  size_t checkpointMaxEntries = 0;
+};
+
+// 恢复统计：检查点条目 + 日志尾部记录，用于度量和约束恢复时间
+struct XRecoveryStats {
+  size_t checkpointEntries = 0;
+  size_t logRecords = 0;
+  size_t bytesReplayed = 0;
+  size_t tornBytes = 0; // 因崩溃写了一半而被截掉的尾部字节
+  double elapsedMs = 0;
+};
+
+namespace detail {
+inline const std::array<uint32_t, 256> &crcTable() {
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+inline uint32_t crc32(const void *data, size_t n, uint32_t crc = 0) {
+  const auto &table = crcTable();
+  const auto *p = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < n; ++i)
+    crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+inline uint32_t recordChecksum(const LogRecordHeader &h, const char *payload) {
+  uint32_t crc = crc32(reinterpret_cast<const char *>(&h) + sizeof(uint32_t),
+                       sizeof(LogRecordHeader) - sizeof(uint32_t));
+  return crc32(payload, size_t(h.keySize) + h.valueSize, crc);
+}
+
+// 只读mmap一个文件并按顺序回放其中的记录
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      length = static_cast<size_t>(st.st_size);
+      void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        addr = static_cast<const char *>(p);
+        ::madvise(const_cast<char *>(addr), length, MADV_SEQUENTIAL);
+      } else {
+        length = 0;
+      }
+    }
+  }
+
+  ~MappedFile() {
+    if (addr)
+      ::munmap(const_cast<char *>(addr), length);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return addr; }
+  size_t size() const { return length; }
+
+private:
+  int fd = -1;
+  const char *addr = nullptr;
+  size_t length = 0;
+};
+
+// 从[data, data+size)顺序解析记录，遇到截断或校验失败即停止，返回有效字节数
+template <typename Fn>
+size_t replayRecords(const char *data, size_t size, Fn &&fn) {
+  size_t offset = 0;
+  while (offset + sizeof(LogRecordHeader) <= size) {
+    LogRecordHeader h;
+    std::memcpy(&h, data + offset, sizeof(h));
+    size_t payload = size_t(h.keySize) + h.valueSize;
+    if (h.type != uint8_t(LogRecordType::Put) &&
+        h.type != uint8_t(LogRecordType::Remove) &&
+        h.type != uint8_t(LogRecordType::Clear))
+      break;
+    if (payload > size - offset - sizeof(h))
+      break;
+    const char *p = data + offset + sizeof(h);
+    if (recordChecksum(h, p) != h.checksum)
+      break;
+    fn(LogRecordView{LogRecordType(h.type), h.lsn,
+                     std::string_view(p, h.keySize),
+                     std::string_view(p + h.keySize, h.valueSize)});
+    offset += sizeof(h) + payload;
+  }
+  return offset;
+}
+
+inline void writeAll(int fd, const char *data, size_t n) {
+  while (n > 0) {
+    ssize_t w = ::write(fd, data, n);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("XCacheLog: write failed: " +
+                               std::string(std::strerror(errno)));
+    }
+    data += w;
+    n -= static_cast<size_t>(w);
+  }
+}
+
+inline void syncData(int fd) {
+  if (::fdatasync(fd) != 0)
+    throw std::runtime_error("XCacheLog: fdatasync failed: " +
+                             std::string(std::strerror(errno)));
+}
+
+inline void syncDirectory(const std::string &dir) {
+  int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd >= 0) {
+    ::fsync(fd);
+    ::close(fd);
+  }
+}
+} // namespace detail
+
+// 追加写日志 + 周期检查点 + 后台压缩
+// 目录布局：
+//   log-<seq>.xlog         日志段，只追加
+//   checkpoint-<lsn>.xckp  检查点，覆盖lsn及之前的所有记录
+class XCacheLog {
+  static constexpr uint64_t kCheckpointMagic = 0x31304B5043584358ull; // XCXCPK01
+  static constexpr uint64_t kCheckpointEnd = 0x444E454B50435858ull;   // XXCPKEND
+
+  struct CheckpointHeader {
+    uint64_t magic;
+    uint64_t lsn;
+  };
+  struct CheckpointTrailer {
+    uint64_t magic;
+    uint64_t count;
+  };
+
+public:
+  XCacheLog(std::string dir, XLogOptions options = XLogOptions())
+      : dir(std::move(dir)), options(options) {
+    std::filesystem::create_directories(this->dir);
+  }
+
+  ~XCacheLog() { close(); }
+
+  XCacheLog(const XCacheLog &) = delete;
+  XCacheLog &operator=(const XCacheLog &) = delete;
+
+  // 从最新检查点和其后的日志尾部重建状态，必须在start()之前调用
+  template <typename Apply> XRecoveryStats recover(Apply &&apply) {
+    XRecoveryStats stats;
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<uint64_t> checkpoints = listFiles("checkpoint-", ".xckp");
+    std::vector<uint64_t> segments = listFiles("log-", ".xlog");
+
+    // 从新到旧寻找第一个完整的检查点
+    for (auto it = checkpoints.rbegin(); it != checkpoints.rend(); ++it) {
+      size_t entries = 0;
+      if (loadCheckpoint(checkpointPath(*it), apply, entries, stats)) {
+        checkpointLsn = *it;
+        stats.checkpointEntries = entries;
+        break;
+      }
+    }
+    // 旧检查点（以及被新检查点淘汰的）直接清理
+    for (uint64_t lsn : checkpoints) {
+      if (lsn != checkpointLsn)
+        std::filesystem::remove(checkpointPath(lsn));
+    }
+
+    uint64_t maxLsn = checkpointLsn;
+    bool torn = false;
+    for (uint64_t seq : segments) {
+      std::string path = segmentPath(seq);
+      if (torn) {
+        // 截断点之后的段不可能是完整写入的结果，丢弃
+        stats.tornBytes += std::filesystem::file_size(path);
+        std::filesystem::remove(path);
+        continue;
+      }
+      size_t valid;
+      size_t fileSize;
+      {
+        detail::MappedFile file(path);
+        fileSize = file.size();
+        valid = detail::replayRecords(
+            file.data(), file.size(), [&](const LogRecordView &rec) {
+              if (rec.lsn <= checkpointLsn)
+                return;
+              apply(rec);
+              maxLsn = std::max(maxLsn, rec.lsn);
+              stats.logRecords++;
+            });
+      }
+      stats.bytesReplayed += valid;
+      if (valid < fileSize) {
+        // 崩溃时写了一半的尾部记录，截掉以保证后续追加的一致性
+        stats.tornBytes += fileSize - valid;
+        if (::truncate(path.c_str(), static_cast<off_t>(valid)) != 0)
+          throw std::runtime_error("XCacheLog: cannot truncate " + path);
+        torn = true;
+      }
+      sealed.push_back(seq);
+      nextSeq = seq + 1;
+    }
+
+    nextLsn = maxLsn + 1;
+    durableLsn = maxLsn;
+    lastLsn = maxLsn;
+    recovered = true;
+    stats.elapsedMs = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - begin)
+                          .count();
+    return stats;
+  }
+
+  // 打开新的活动段并启动刷盘、压缩后台线程
+  void start() {
+    if (!recovered)
+      recover([](const LogRecordView &) {});
+    std::lock_guard<std::mutex> lock(mtx);
+    openSegment();
+    flusher = std::thread([this] { flushLoop(); });
+    compactor = std::thread([this] { compactLoop(); });
+  }
+
+  // 追加一条记录，fill(keyDst, valueDst)负责直接写入负载，返回分配的LSN。
+  // 后台写盘、刷盘或压缩失败后，append/waitDurable/sync/checkpoint都抛出该错误
+  template <typename Fill>
+  uint64_t append(LogRecordType type, uint32_t keySize, uint32_t valueSize,
+                  Fill &&fill) {
+    std::unique_lock<std::mutex> lock(mtx);
+    // 缓冲区过大时反压，等待刷盘线程追上
+    durableCv.wait(lock, [&] {
+      return buffer.size() < options.maxBatchBytes * 4 || stopping || failure;
+    });
+    throwIfFailedLocked();
+    size_t offset = buffer.size();
+    size_t payload = size_t(keySize) + valueSize;
+    buffer.resize(offset + sizeof(LogRecordHeader) + payload);
+    char *p = buffer.data() + offset + sizeof(LogRecordHeader);
+    fill(p, p + keySize);
+
+    LogRecordHeader h{};
+    h.keySize = keySize;
+    h.valueSize = valueSize;
+    h.type = uint8_t(type);
+    h.lsn = nextLsn++;
+    h.checksum = detail::recordChecksum(h, p);
+    std::memcpy(buffer.data() + offset, &h, sizeof(h));
+    lastLsn = h.lsn;
+
+    if (offset == 0 || buffer.size() >= options.maxBatchBytes)
+      flushCv.notify_one();
+    return h.lsn;
+  }
+
+  // 组提交：等待lsn所在的批次落盘
+  void waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (durableLsn >= lsn)
+      return;
+    waiters++;
+    flushCv.notify_one();
+    durableCv.wait(lock,
+                   [&] { return durableLsn >= lsn || stopping || failure; });
+    waiters--;
+    if (durableLsn < lsn)
+      throwIfFailedLocked();
+  }
+
+  // 等待所有已追加的记录写入并fdatasync
+  void sync() {
+    uint64_t target;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      target = lastLsn;
+    }
+    waitDurable(target);
+  }
+
+  // 立即封存活动段并同步生成检查点
+  void checkpoint() {
+    std::unique_lock<std::mutex> lock(mtx);
+    flushLocked(lock);
+    throwIfFailedLocked();
+    if (activeBytes > 0)
+      rotateLocked();
+    lock.unlock();
+    std::lock_guard<std::mutex> compactLock(compactMtx);
+    compactOnce();
+  }
+
+  // 刷出并fdatasync剩余记录后停止后台线程；不抛出，此前的写盘错误由append等报告
+  void close() {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      if (stopping || fd < 0) {
+        stopping = true;
+        return;
+      }
+      while (!buffer.empty() && !failure)
+        flushLocked(lock);
+      stopping = true;
+    }
+    flushCv.notify_all();
+    durableCv.notify_all();
+    compactCv.notify_all();
+    if (flusher.joinable())
+      flusher.join();
+    if (compactor.joinable())
+      compactor.join();
+    std::lock_guard<std::mutex> lock(mtx);
+    ::close(fd);
+    fd = -1;
+  }
+
+  uint64_t getDurableLsn() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return durableLsn;
+  }
+
+  uint64_t getCheckpointLsn() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return checkpointLsn;
+  }
+
+  size_t getSealedSegments() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return sealed.size();
+  }
+
+private:
+  std::string segmentPath(uint64_t seq) const {
+    return dir + "/log-" + hex(seq) + ".xlog";
+  }
+
+  std::string checkpointPath(uint64_t lsn) const {
+    return dir + "/checkpoint-" + hex(lsn) + ".xckp";
+  }
+
+  static std::string hex(uint64_t v) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)v);
+    return buf;
+  }
+
+  std::vector<uint64_t> listFiles(const std::string &prefix,
+                                  const std::string &suffix) const {
+    std::vector<uint64_t> ids;
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+      std::string name = entry.path().filename().string();
+      if (name.size() != prefix.size() + 16 + suffix.size() ||
+          name.compare(0, prefix.size(), prefix) != 0 ||
+          name.compare(name.size() - suffix.size(), suffix.size(), suffix) !=
+              0)
+        continue;
+      ids.push_back(
+          std::stoull(name.substr(prefix.size(), 16), nullptr, 16));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  }
+
+  // 检查点只有在头尾标记完整时才有效（写临时文件后rename，保证原子性）
+  template <typename Apply>
+  bool loadCheckpoint(const std::string &path, Apply &apply, size_t &entries,
+                      XRecoveryStats &stats) {
+    detail::MappedFile file(path);
+    if (file.size() < sizeof(CheckpointHeader) + sizeof(CheckpointTrailer))
+      return false;
+    CheckpointHeader header;
+    CheckpointTrailer trailer;
+    std::memcpy(&header, file.data(), sizeof(header));
+    std::memcpy(&trailer,
+                file.data() + file.size() - sizeof(CheckpointTrailer),
+                sizeof(trailer));
+    if (header.magic != kCheckpointMagic || trailer.magic != kCheckpointEnd)
+      return false;
+    size_t bodySize =
+        file.size() - sizeof(CheckpointHeader) - sizeof(CheckpointTrailer);
+    // 检查点经fsync后才rename到正式文件名，尾标记完整即意味着内容完整，
+    // 这里单遍回放，仅在逐条CRC校验失败时报告损坏
+    size_t count = 0;
+    size_t valid = detail::replayRecords(
+        file.data() + sizeof(CheckpointHeader), bodySize,
+        [&](const LogRecordView &rec) {
+          apply(rec);
+          count++;
+        });
+    if (valid != bodySize || count != trailer.count)
+      throw std::runtime_error("XCacheLog: corrupted checkpoint " + path);
+    entries = count;
+    stats.bytesReplayed += bodySize;
+    return true;
+  }
+
+  void openSegment() {
+    uint64_t seq = nextSeq++;
+    std::string path = segmentPath(seq);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("XCacheLog: cannot open " + path);
+    activeSeq = seq;
+    activeBytes = 0;
+    detail::syncDirectory(dir);
+  }
+
+  void rotateLocked() {
+    detail::syncData(fd);
+    ::close(fd);
+    sealed.push_back(activeSeq);
+    openSegment();
+    if (sealed.size() >= options.compactSegments)
+      compactCv.notify_one();
+  }
+
+  // 把缓冲区写入活动段并fdatasync，两种持久化模式下durableLsn都只在落盘后推进；
+  // 调用方持有mtx，写盘期间释放锁以便继续追加。失败时记入failure，不抛出
+  void flushLocked(std::unique_lock<std::mutex> &lock) {
+    durableCv.wait(lock, [&] { return !flushing; });
+    if (buffer.empty() || failure)
+      return;
+    std::vector<char> batch;
+    batch.swap(spare);
+    batch.swap(buffer);
+    uint64_t batchLsn = lastLsn;
+    int batchFd = fd;
+    flushing = true;
+    lock.unlock();
+
+    std::exception_ptr error;
+    try {
+      detail::writeAll(batchFd, batch.data(), batch.size());
+      detail::syncData(batchFd);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    flushing = false;
+    size_t written = batch.size();
+    batch.clear();
+    spare.swap(batch);
+    if (error) {
+      failure = error;
+    } else {
+      activeBytes += written;
+      durableLsn = batchLsn;
+      if (activeBytes >= options.segmentBytes)
+        rotateOrFailLocked();
+    }
+    durableCv.notify_all();
+  }
+
+  void rotateOrFailLocked() {
+    try {
+      rotateLocked();
+    } catch (...) {
+      failure = std::current_exception();
+    }
+  }
+
+  void throwIfFailedLocked() const {
+    if (failure)
+      std::rethrow_exception(failure);
+  }
+
+  void flushLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping && !failure) {
+      flushCv.wait(lock, [&] { return stopping || !buffer.empty(); });
+      if (stopping)
+        break;
+      // 有人在等待落盘时立即提交，刷盘期间到来的记录自然并入下一批
+      if (waiters == 0 && buffer.size() < options.maxBatchBytes) {
+        flushCv.wait_for(lock, options.commitInterval, [&] {
+          return stopping || waiters > 0 ||
+                 buffer.size() >= options.maxBatchBytes;
+        });
+      }
+      flushLocked(lock);
+    }
+  }
+
+  // 压缩失败（写检查点、删除旧文件出错）同样记入failure并退出
+  void compactLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping && !failure) {
+      compactCv.wait_for(lock, options.checkpointInterval, [&] {
+        return stopping || failure ||
+               sealed.size() >= options.compactSegments;
+      });
+      if (stopping || failure)
+        break;
+      // 周期检查点：活动段有数据时先封存
+      if (sealed.size() < options.compactSegments) {
+        if (activeBytes == 0 && buffer.empty())
+          continue;
+        flushLocked(lock);
+        if (failure)
+          break;
+        if (activeBytes > 0)
+          rotateOrFailLocked();
+        if (failure)
+          break;
+      }
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        std::lock_guard<std::mutex> compactLock(compactMtx);
+        compactOnce();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error) {
+        failure = error;
+        durableCv.notify_all();
+      }
+    }
+  }
+
+  // 合并旧检查点与已封存段，写出新检查点后删除被覆盖的文件
+  void compactOnce() {
+    std::vector<uint64_t> inputs;
+    uint64_t baseLsn;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      inputs = sealed;
+      baseLsn = checkpointLsn;
+    }
+    if (inputs.empty())
+      return;
+
+    // 按最近写入顺序维护存活条目，超出上限时丢弃最久未写入的
+    std::list<std::string> order;
+    std::unordered_map<std::string_view,
+                       std::pair<std::string, std::list<std::string>::iterator>>
+        live;
+    uint64_t newLsn = baseLsn;
+    auto applyRecord = [&](const LogRecordView &rec) {
+      newLsn = std::max(newLsn, rec.lsn);
+      if (rec.type == LogRecordType::Clear) {
+        live.clear();
+        order.clear();
+        return;
+      }
+      auto it = live.find(rec.key);
+      if (it != live.end()) {
+        auto pos = it->second.second;
+        live.erase(it);
+        order.erase(pos);
+      }
+      if (rec.type == LogRecordType::Put) {
+        order.emplace_back(rec.key);
+        live.emplace(std::string_view(order.back()),
+                     std::make_pair(std::string(rec.value),
+                                    std::prev(order.end())));
+        if (options.checkpointMaxEntries > 0 &&
+            live.size() > options.checkpointMaxEntries) {
+          live.erase(std::string_view(order.front()));
+          order.pop_front();
+        }
+      }
+    };
+
+    if (baseLsn > 0) {
+      detail::MappedFile file(checkpointPath(baseLsn));
+      if (file.size() > sizeof(CheckpointHeader) + sizeof(CheckpointTrailer))
+        detail::replayRecords(file.data() + sizeof(CheckpointHeader),
+                              file.size() - sizeof(CheckpointHeader) -
+                                  sizeof(CheckpointTrailer),
+                              applyRecord);
+    }
+    for (uint64_t seq : inputs) {
+      detail::MappedFile file(segmentPath(seq));
+      detail::replayRecords(file.data(), file.size(),
+                            [&](const LogRecordView &rec) {
+                              if (rec.lsn > baseLsn)
+                                applyRecord(rec);
+                            });
+    }
+
+    std::string tmpPath = dir + "/checkpoint.tmp";
+    int out = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                     0644);
+    if (out < 0)
+      return;
+    try {
+      writeCheckpoint(out, newLsn, order, live);
+    } catch (...) {
+      ::close(out);
+      std::filesystem::remove(tmpPath);
+      throw;
+    }
+    ::close(out);
+    std::filesystem::rename(tmpPath, checkpointPath(newLsn));
+    detail::syncDirectory(dir);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (baseLsn > 0 && baseLsn != newLsn)
+      std::filesystem::remove(checkpointPath(baseLsn));
+    for (uint64_t seq : inputs)
+      std::filesystem::remove(segmentPath(seq));
+    sealed.erase(sealed.begin(), sealed.begin() + inputs.size());
+    checkpointLsn = newLsn;
+  }
+
+  // 把存活条目按写入顺序写成检查点并fsync
+  template <typename Live>
+  void writeCheckpoint(int out, uint64_t newLsn,
+                       const std::list<std::string> &order, const Live &live) {
+    std::vector<char> chunk;
+    CheckpointHeader header{kCheckpointMagic, newLsn};
+    chunk.insert(chunk.end(), reinterpret_cast<const char *>(&header),
+                 reinterpret_cast<const char *>(&header) + sizeof(header));
+    for (const std::string &key : order) {
+      const std::string &value = live.find(std::string_view(key))->second.first;
+      LogRecordHeader h{};
+      h.keySize = static_cast<uint32_t>(key.size());
+      h.valueSize = static_cast<uint32_t>(value.size());
+      h.type = uint8_t(LogRecordType::Put);
+      h.lsn = newLsn;
+      size_t offset = chunk.size();
+      chunk.resize(offset + sizeof(h) + key.size() + value.size());
+      char *p = chunk.data() + offset + sizeof(h);
+      std::memcpy(p, key.data(), key.size());
+      std::memcpy(p + key.size(), value.data(), value.size());
+      h.checksum = detail::recordChecksum(h, p);
+      std::memcpy(chunk.data() + offset, &h, sizeof(h));
+      if (chunk.size() >= (4u << 20)) {
+        detail::writeAll(out, chunk.data(), chunk.size());
+        chunk.clear();
+      }
+    }
+    CheckpointTrailer trailer{kCheckpointEnd, order.size()};
+    chunk.insert(chunk.end(), reinterpret_cast<const char *>(&trailer),
+                 reinterpret_cast<const char *>(&trailer) + sizeof(trailer));
+    detail::writeAll(out, chunk.data(), chunk.size());
+    if (::fsync(out) != 0)
+      throw std::runtime_error("XCacheLog: fsync failed: " +
+                               std::string(std::strerror(errno)));
+  }
+
+  std::string dir;
+  XLogOptions options;
+
+  std::mutex mtx;
+  std::condition_variable flushCv;
+  std::condition_variable durableCv;
+  std::condition_variable compactCv;
+  std::mutex compactMtx; // 保证同一时刻只有一个压缩在运行
+
+  std::vector<char> buffer; // 等待组提交的记录
+  std::vector<char> spare;  // 与buffer交替使用，避免反复分配
+  uint64_t nextLsn = 1;
+  uint64_t lastLsn = 0;
+  uint64_t durableLsn = 0;
+  uint64_t checkpointLsn = 0;
+  size_t waiters = 0;
+  bool flushing = false;
+  bool stopping = false;
+  bool recovered = false;
+  std::exception_ptr failure; // 后台线程的第一个写盘/压缩错误，此后不再写盘
+
+  int fd = -1;
+  uint64_t activeSeq = 0;
+  uint64_t nextSeq = 1;
+  size_t activeBytes = 0;
+  std::vector<uint64_t> sealed; // 已封存、尚未并入检查点的段
+
+  std::thread flusher;
+  std::thread compactor;
+};
+} // namespace XCache
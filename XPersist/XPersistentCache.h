@@ -0,0 +1,192 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "../XCachePolicy.h"
+#include "../XLRUCache.h"
+#include "../XSerializer.h"
+#include "XCacheLog.h"
+
+namespace XCache {
+namespace detail {
+template <typename Engine, typename = void>
+struct HasCapacity : std::false_type {};
+
+template <typename Engine>
+struct HasCapacity<Engine,
+                   std::void_t<decltype(std::declval<const Engine &>().getCapacity())>>
+    : std::true_type {};
+} // namespace detail
+
+// 持久化缓存：所有写操作先追加到日志，再作用到底层淘汰引擎
+// 重启时由最新检查点+日志尾部重建，Engine需提供put/get/remove/clear
+template <typename Key, typename Value, typename Engine = XLRUCache<Key, Value>>
+class XPersistentCache : public XCachePolicy<Key, Value> {
+  static_assert(isSerializable<Key> && isSerializable<Value>,
+                "XPersistentCache: Key/Value需要可用的Serializer");
+
+public:
+  XPersistentCache(const std::string &dir, std::unique_ptr<Engine> engine,
+                   XLogOptions options = XLogOptions())
+      : engine(std::move(engine)), log(dir, boundCheckpoint(options, *this->engine)),
+        durability(options.durability) {
+    // 回放时复用同一对Key/Value对象解码，避免逐条分配
+    Key key{};
+    Value value{};
+    recoveryStats = log.recover([&](const LogRecordView &rec) {
+      if (rec.type == LogRecordType::Clear) {
+        this->engine->clear();
+        return;
+      }
+      if (!deserialize(rec.key, key))
+        throw std::runtime_error("XPersistentCache: key解码失败");
+      if (rec.type == LogRecordType::Remove) {
+        this->engine->remove(key);
+        return;
+      }
+      if (!deserialize(rec.value, value))
+        throw std::runtime_error("XPersistentCache: value解码失败");
+      this->engine->put(key, value);
+    });
+    log.start();
+  }
+
+  ~XPersistentCache() override { log.close(); }
+
+  void put(Key key, Value value) override {
+    uint64_t lsn;
+    {
+      // 保证日志顺序与引擎中的生效顺序一致
+      std::lock_guard<std::mutex> lock(mtx);
+      // 直接序列化进日志缓冲区，不产生中间拷贝
+      lsn = log.append(LogRecordType::Put,
+                       static_cast<uint32_t>(serializedSize(key)),
+                       static_cast<uint32_t>(serializedSize(value)),
+                       [&](char *keyDst, char *valueDst) {
+                         serializeTo(key, keyDst);
+                         serializeTo(value, valueDst);
+                       });
+      engine->put(key, value);
+    }
+    if (durability == XDurability::GroupCommit)
+      log.waitDurable(lsn);
+  }
+
+  bool get(Key key, Value &value) override { return engine->get(key, value); }
+
+  Value get(Key key) override {
+    Value value{};
+    get(key, value);
+    return value;
+  }
+
+  void remove(Key key) override {
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      lsn = log.append(LogRecordType::Remove,
+                       static_cast<uint32_t>(serializedSize(key)), 0,
+                       [&](char *keyDst, char *) { serializeTo(key, keyDst); });
+      engine->remove(key);
+    }
+    if (durability == XDurability::GroupCommit)
+      log.waitDurable(lsn);
+  }
+
+  // 只在确实删除时记Remove记录；判断与记日志都在mtx内，与其他写入保持日志顺序
+  bool removeIf(Key key,
+                const typename XCachePolicy<Key, Value>::RemovePred &pred) override {
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (!engine->removeIf(key, pred))
+        return false;
+      lsn = log.append(LogRecordType::Remove,
+                       static_cast<uint32_t>(serializedSize(key)), 0,
+                       [&](char *keyDst, char *) { serializeTo(key, keyDst); });
+    }
+    if (durability == XDurability::GroupCommit)
+      log.waitDurable(lsn);
+    return true;
+  }
+
+  // 记一条Clear记录，压缩时丢弃它之前的所有条目；引擎的clear为O(1)，仍在锁内完成以保持日志顺序
+  void clear() override {
+    uint64_t lsn;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      lsn = log.append(LogRecordType::Clear, 0, 0, [](char *, char *) {});
+      engine->clear();
+    }
+    if (durability == XDurability::GroupCommit)
+      log.waitDurable(lsn);
+  }
+
+  // 写回时把结果作为一条put记入日志，与引擎的更新在同一把锁内完成
+  Value modify(Key key,
+               const typename XCachePolicy<Key, Value>::ModifyFn &fn) override {
+    uint64_t lsn;
+    Value value;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      bool wrote = false;
+      value = engine->modify(key, [&](Value &v, bool present) {
+        wrote = fn(v, present);
+        return wrote;
+      });
+      if (!wrote)
+        return value;
+      lsn = log.append(LogRecordType::Put,
+                       static_cast<uint32_t>(serializedSize(key)),
+                       static_cast<uint32_t>(serializedSize(value)),
+                       [&](char *keyDst, char *valueDst) {
+                         serializeTo(key, keyDst);
+                         serializeTo(value, valueDst);
+                       });
+    }
+    if (durability == XDurability::GroupCommit)
+      log.waitDurable(lsn);
+    return value;
+  }
+
+  // 只读，不写日志
+  bool peek(Key key, Value &value) const override {
+    return engine->peek(key, value);
+  }
+  bool contains(Key key) const override { return engine->contains(key); }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    engine->setEvictionStats(std::move(stats));
+  }
+
+  // 强制生成检查点并压缩已封存的日志段
+  void checkpoint() { log.checkpoint(); }
+
+  // 等待所有已写入的记录落盘
+  void sync() { log.sync(); }
+
+  const XRecoveryStats &getRecoveryStats() const { return recoveryStats; }
+
+  Engine &getEngine() { return *engine; }
+
+private:
+  // 检查点最多保留引擎容量个条目：更早写入的条目在引擎中已被淘汰，恢复后也会被挤出
+  static XLogOptions boundCheckpoint(XLogOptions options, const Engine &engine) {
+    if constexpr (detail::HasCapacity<Engine>::value) {
+      if (options.checkpointMaxEntries == 0)
+        options.checkpointMaxEntries = engine.getCapacity();
+    }
+    return options;
+  }
+
+  std::unique_ptr<Engine> engine;
+  XCacheLog log;
+  XDurability durability;
+  XRecoveryStats recoveryStats;
+  std::mutex mtx;
+};
+} // namespace XCache
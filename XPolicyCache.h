@@ -0,0 +1,695 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "XCachePolicy.h"
+#include "XReclaimer.h"
+
+// 编译期组合的缓存：索引、淘汰、准入、加锁、统计、标签六个组件各自独立，按模板参数拼装。
+// 不继承XCachePolicy（只用XComputeOps提供compute/merge），没有虚函数，通过具体类型调用时各组件的函数都可以内联；
+// 需要按名称动态选择时再包一层适配器。
+//
+// 组件约定（均为普通类，按(容量, resource)、resource、容量之一构造或默认构造）：
+//   Index<Key, Entry>  find(key) -> Entry*、emplace(key, slot) -> Entry*（以key和slot构造条目，条目由索引持有，
+//                      地址在删除前不变）、erase(key)、size()
+//   Eviction           Hook为嵌入每个条目的侵入式字段；onInsert/onAccess/onRemove(Entry*)维护顺序，
+//                      victim<Entry>()返回下一个应被淘汰的条目（不移除）
+//   Admission          record(key)记录一次访问，admit(candidate, victim)决定新条目能否替换victim
+//   Locking            Guard(locking)在作用域内持独占锁，SharedGuard(locking)供peek/contains使用
+//   Stats              onHit/onMiss/onInsert/onEvict/onReject(key)
+//   Tagging            Hook嵌入每个条目；onRemove(Entry*)在条目删除或淘汰时解除它的标签
+namespace XCache {
+// 条目直接存放在哈希表节点中，每个条目只有一次分配
+template <typename Key, typename Entry> class XHashIndex {
+public:
+  XHashIndex(size_t capacity, std::pmr::memory_resource *resource)
+      : map(resource) {
+    map.reserve(capacity);
+  }
+
+  Entry *find(const Key &key) {
+    auto it = map.find(key);
+    return it == map.end() ? nullptr : &it->second;
+  }
+
+  const Entry *find(const Key &key) const {
+    auto it = map.find(key);
+    return it == map.end() ? nullptr : &it->second;
+  }
+
+  template <typename Value> Entry *emplace(const Key &key, Value &&value) {
+    return &map.try_emplace(key, key, std::forward<Value>(value)).first->second;
+  }
+
+  void erase(const Key &key) { map.erase(key); }
+  size_t size() const { return map.size(); }
+
+private:
+  std::pmr::unordered_map<Key, Entry> map;
+};
+
+// 侵入式双向链表，节点即条目本身，不额外分配
+struct XListHook {
+  XListHook *prev = nullptr;
+  XListHook *next = nullptr;
+};
+
+class XHookList {
+public:
+  XHookList() { head.prev = head.next = &head; }
+  XHookList(const XHookList &) = delete;
+  XHookList &operator=(const XHookList &) = delete;
+
+  bool empty() const { return head.next == &head; }
+  XListHook *front() const { return head.next; }
+
+  void pushBack(XListHook *node) {
+    node->prev = head.prev;
+    node->next = &head;
+    head.prev->next = node;
+    head.prev = node;
+  }
+
+  static void unlink(XListHook *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+  }
+
+private:
+  XListHook head;
+};
+
+// LRU：访问时移到链表尾部，淘汰链表头部
+class XLruEviction {
+public:
+  using Hook = XListHook;
+
+  template <typename Entry> void onInsert(Entry *entry) { list.pushBack(entry); }
+  template <typename Entry> void onAccess(Entry *entry) {
+    XHookList::unlink(entry);
+    list.pushBack(entry);
+  }
+  template <typename Entry> void onRemove(Entry *entry) {
+    XHookList::unlink(entry);
+  }
+  template <typename Entry> Entry *victim() {
+    return list.empty() ? nullptr : static_cast<Entry *>(list.front());
+  }
+
+private:
+  XHookList list;
+};
+
+// LFU：按访问次数分桶，同频率内按LRU淘汰
+class XLfuEviction {
+public:
+  struct Hook : XListHook {
+    uint32_t freq = 1;
+  };
+
+  explicit XLfuEviction(std::pmr::memory_resource *resource)
+      : buckets(resource) {}
+
+  template <typename Entry> void onInsert(Entry *entry) {
+    entry->freq = 1;
+    buckets[1].pushBack(entry);
+  }
+  template <typename Entry> void onAccess(Entry *entry) {
+    unlink(entry);
+    if (entry->freq < UINT32_MAX)
+      entry->freq++;
+    buckets[entry->freq].pushBack(entry);
+  }
+  template <typename Entry> void onRemove(Entry *entry) { unlink(entry); }
+  template <typename Entry> Entry *victim() {
+    return buckets.empty()
+               ? nullptr
+               : static_cast<Entry *>(
+                     static_cast<Hook *>(buckets.begin()->second.front()));
+  }
+
+private:
+  void unlink(Hook *entry) {
+    XHookList::unlink(entry);
+    auto it = buckets.find(entry->freq);
+    if (it->second.empty())
+      buckets.erase(it);
+  }
+
+  std::pmr::map<uint32_t, XHookList> buckets;
+};
+
+// 总是接纳新条目
+struct XAlwaysAdmit {
+  template <typename Key> void record(const Key &) {}
+  template <typename Key> bool admit(const Key &, const Key &) { return true; }
+};
+
+// TinyLFU准入：Count-Min Sketch估计访问频率，新条目只有比淘汰候选更常被访问才能进入。
+// 记录次数达到容量的10倍时所有计数减半，使频率随时间衰减
+class XTinyLfuAdmission {
+public:
+  XTinyLfuAdmission(size_t capacity, std::pmr::memory_resource *resource)
+      : sampleSize(std::max<size_t>(capacity, 16) * 10), table(resource) {
+    size_t width = 64;
+    while (width < capacity * 4)
+      width <<= 1;
+    mask = width - 1;
+    table.assign(kDepth * width, 0);
+  }
+
+  template <typename Key> void record(const Key &key) {
+    uint64_t h = std::hash<Key>()(key);
+    for (size_t i = 0; i < kDepth; ++i) {
+      uint8_t &counter = table[i * (mask + 1) + index(h, i)];
+      if (counter < 15)
+        counter++;
+    }
+    if (++samples >= sampleSize)
+      halve();
+  }
+
+  template <typename Key> bool admit(const Key &candidate, const Key &victim) {
+    return frequency(candidate) > frequency(victim);
+  }
+
+  template <typename Key> uint32_t frequency(const Key &key) const {
+    uint64_t h = std::hash<Key>()(key);
+    uint32_t minCount = UINT32_MAX;
+    for (size_t i = 0; i < kDepth; ++i)
+      minCount = std::min<uint32_t>(minCount,
+                                    table[i * (mask + 1) + index(h, i)]);
+    return minCount;
+  }
+
+private:
+  static constexpr size_t kDepth = 4;
+
+  size_t index(uint64_t h, size_t row) const {
+    static const uint64_t seeds[kDepth] = {
+        0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull,
+        0xD6E8FEB86659FD93ull};
+    uint64_t x = (h + seeds[row]) * 0xFF51AFD7ED558CCDull;
+    return (x ^ (x >> 32)) & mask;
+  }
+
+  void halve() {
+    for (uint8_t &counter : table)
+      counter >>= 1;
+    samples /= 2;
+  }
+
+  size_t sampleSize;
+  size_t samples = 0;
+  size_t mask = 0;
+  std::pmr::vector<uint8_t> table;
+};
+
+// 只读查询同样独占，换来最便宜的写路径
+struct XMutexLocking {
+  std::mutex mtx;
+
+  struct Guard {
+    explicit Guard(XMutexLocking &locking) : lock(locking.mtx) {}
+    std::lock_guard<std::mutex> lock;
+  };
+  using SharedGuard = Guard;
+};
+
+// 读写锁：peek/contains之间可以并发
+struct XSharedMutexLocking {
+  std::shared_mutex mtx;
+
+  struct Guard {
+    explicit Guard(XSharedMutexLocking &locking) : lock(locking.mtx) {}
+    std::lock_guard<std::shared_mutex> lock;
+  };
+  struct SharedGuard {
+    explicit SharedGuard(XSharedMutexLocking &locking) : lock(locking.mtx) {}
+    std::shared_lock<std::shared_mutex> lock;
+  };
+};
+
+// 单线程使用或由调用方保证互斥
+struct XNoLocking {
+  struct Guard {
+    explicit Guard(XNoLocking &) {}
+  };
+  using SharedGuard = Guard;
+};
+
+struct XNoStats {
+  template <typename Key> void onHit(const Key &) {}
+  template <typename Key> void onMiss(const Key &) {}
+  template <typename Key> void onInsert(const Key &) {}
+  template <typename Key> void onEvict(const Key &) {}
+  template <typename Key> void onReject(const Key &) {}
+};
+
+// 计数在缓存的锁内更新，读取时需自行保证没有并发写入
+struct XCounterStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t inserts = 0;
+  uint64_t evictions = 0;
+  uint64_t rejections = 0;
+
+  template <typename Key> void onHit(const Key &) { hits++; }
+  template <typename Key> void onMiss(const Key &) { misses++; }
+  template <typename Key> void onInsert(const Key &) { inserts++; }
+  template <typename Key> void onEvict(const Key &) { evictions++; }
+  template <typename Key> void onReject(const Key &) { rejections++; }
+};
+
+// 不支持标签
+struct XNoTagging {
+  struct Hook {};
+  template <typename Entry> void onRemove(Entry *) {}
+};
+
+// 标签倒排索引：每个标签一条侵入式链表，链接节点放在条目自己的数组里（每个标签一个），
+// 不为每个标签复制一份key集合。条目删除或淘汰时逐个解除链接，标签的链表空了就删除标签。
+// 批量失效时在链表末尾放一个标记，从头删到标记为止，期间新加上该标签的条目排在标记之后不受影响
+template <typename Tag = std::string> class XTagIndex {
+  using TagNode = std::pair<const Tag, XHookList>;
+
+public:
+  struct Link : XListHook {
+    TagNode *tag = nullptr;
+    void *owner = nullptr; // 所属条目，扫描标记为空
+  };
+
+  struct Hook {
+    Link *tagLinks = nullptr;
+    uint32_t tagCount = 0;
+  };
+
+  explicit XTagIndex(std::pmr::memory_resource *resource)
+      : resource(resource), tags(resource) {}
+
+  // 替换条目的标签
+  template <typename Entry, typename Tags>
+  void setTags(Entry *entry, const Tags &entryTags) {
+    onRemove(entry);
+    size_t count = std::distance(std::begin(entryTags), std::end(entryTags));
+    if (count == 0)
+      return;
+    Link *links = static_cast<Link *>(
+        resource->allocate(sizeof(Link) * count, alignof(Link)));
+    size_t i = 0;
+    for (const Tag &tag : entryTags) {
+      Link *link = new (&links[i++]) Link();
+      link->tag = &*tags.try_emplace(tag).first;
+      link->owner = entry;
+      link->tag->second.pushBack(link);
+    }
+    entry->tagLinks = links;
+    entry->tagCount = static_cast<uint32_t>(count);
+  }
+
+  template <typename Entry> void onRemove(Entry *entry) {
+    if (!entry->tagLinks)
+      return;
+    for (uint32_t i = 0; i < entry->tagCount; ++i)
+      unlink(&entry->tagLinks[i]);
+    resource->deallocate(entry->tagLinks, sizeof(Link) * entry->tagCount,
+                         alignof(Link));
+    entry->tagLinks = nullptr;
+    entry->tagCount = 0;
+  }
+
+  // 在标签链表末尾放入标记，标签不存在时返回false
+  bool beginScan(const Tag &tag, Link &marker) {
+    auto it = tags.find(tag);
+    if (it == tags.end())
+      return false;
+    marker.tag = &*it;
+    marker.owner = nullptr;
+    it->second.pushBack(&marker);
+    return true;
+  }
+
+  // 标记之前的第一个条目，到达标记时返回nullptr；其他扫描的标记跳过
+  template <typename Entry> Entry *nextInScan(const Link &marker) const {
+    for (XListHook *node = marker.tag->second.front(); node != &marker;
+         node = node->next) {
+      if (void *owner = static_cast<Link *>(node)->owner)
+        return static_cast<Entry *>(owner);
+    }
+    return nullptr;
+  }
+
+  void endScan(Link &marker) { unlink(&marker); }
+
+  size_t tagCount() const { return tags.size(); }
+
+private:
+  void unlink(Link *link) {
+    TagNode *tag = link->tag;
+    XHookList::unlink(link);
+    if (tag->second.empty())
+      tags.erase(tag->first);
+  }
+
+  std::pmr::memory_resource *resource;
+  std::pmr::unordered_map<Tag, XHookList> tags;
+};
+
+// 条目中存放value的位置。value不超过一条缓存行时内联在条目里；更大的value单独从resource分配，
+// 条目（哈希表节点）只留下链接、key和指针。代价是插入多一次分配，读写value多一次间接访问
+template <typename Value, bool Cold = (sizeof(Value) > 64)> class XValueSlot {
+public:
+  XValueSlot(Value value, std::pmr::memory_resource *)
+      : value(std::move(value)) {}
+
+  Value &get() { return value; }
+  const Value &get() const { return value; }
+
+private:
+  Value value;
+};
+
+template <typename Value> class XValueSlot<Value, true> {
+public:
+  XValueSlot(Value value, std::pmr::memory_resource *resource)
+      : resource(resource) {
+    void *block = resource->allocate(sizeof(Value), alignof(Value));
+    try {
+      cold = new (block) Value(std::move(value));
+    } catch (...) {
+      resource->deallocate(block, sizeof(Value), alignof(Value));
+      throw;
+    }
+  }
+
+  XValueSlot(XValueSlot &&other) noexcept
+      : resource(other.resource), cold(std::exchange(other.cold, nullptr)) {}
+  XValueSlot(const XValueSlot &) = delete;
+  XValueSlot &operator=(const XValueSlot &) = delete;
+
+  ~XValueSlot() {
+    if (!cold)
+      return;
+    cold->~Value();
+    resource->deallocate(cold, sizeof(Value), alignof(Value));
+  }
+
+  Value &get() { return *cold; }
+  const Value &get() const { return *cold; }
+
+private:
+  std::pmr::memory_resource *resource;
+  Value *cold;
+};
+
+template <typename Key, typename Value,
+          template <typename, typename> class Index = XHashIndex,
+          typename Eviction = XLruEviction, typename Admission = XAlwaysAdmit,
+          typename Locking = XMutexLocking, typename Stats = XNoStats,
+          typename Tagging = XNoTagging>
+class XPolicyCache
+    : public XComputeOps<XPolicyCache<Key, Value, Index, Eviction, Admission,
+                                      Locking, Stats, Tagging>,
+                         Key, Value> {
+  using Slot = XValueSlot<Value>;
+
+  // 淘汰与标签的钩子在前，之后是key；大value只在slot里留一个指针，见XValueSlot
+  struct Entry : Eviction::Hook, Tagging::Hook {
+    Entry(const Key &key, Slot &&slot) : key(key), slot(std::move(slot)) {}
+    Value &value() { return slot.get(); }
+    const Value &value() const { return slot.get(); }
+    Key key;
+    Slot slot;
+  };
+
+public:
+  // resource见XMemoryResource.h
+  explicit XPolicyCache(
+      size_t capacity,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : capacityLimit(capacity), resource(resource),
+        state(std::make_shared<State>(capacity, resource)),
+        admission(make<Admission>(capacity, resource)) {}
+
+  ~XPolicyCache() {
+    state.reset();
+    if (retiredAny)
+      reclaimer.drain(); // 后台释放完成前resource不能销毁
+  }
+
+  XPolicyCache(const XPolicyCache &) = delete;
+  XPolicyCache &operator=(const XPolicyCache &) = delete;
+
+  void put(Key key, Value value) {
+    if (capacityLimit == 0)
+      return;
+    typename Locking::Guard guard(locking);
+    admission.record(key);
+    if (Entry *entry = state->index.find(key)) {
+      entry->value() = std::move(value);
+      state->eviction.onAccess(entry);
+      return;
+    }
+    insert(key, std::move(value));
+  }
+
+  // 写入并把条目的标签替换为tags（需要Tagging组件，如XTagIndex）；不带标签的put保留原有标签
+  template <typename Tags> void put(Key key, Value value, const Tags &tags) {
+    if (capacityLimit == 0)
+      return;
+    typename Locking::Guard guard(locking);
+    admission.record(key);
+    Entry *entry = state->index.find(key);
+    if (entry) {
+      entry->value() = std::move(value);
+      state->eviction.onAccess(entry);
+    } else {
+      entry = insert(key, std::move(value));
+    }
+    if (entry)
+      state->tagging.setTags(entry, tags);
+  }
+
+  // 删除带有tag的所有条目，每批最多batchSize个，批之间释放锁；返回删除的条目数。
+  // 调用开始之后才加上该标签（或重新设置了标签）的条目不受影响；批之间被clear时提前结束
+  template <typename Tag>
+  size_t invalidateTag(const Tag &tag, size_t batchSize = 256) {
+    typename Tagging::Link marker;
+    std::shared_ptr<State> scanned; // 标记挂在这份组件的链表上，扫描结束前不能被释放
+    {
+      typename Locking::Guard guard(locking);
+      if (!state->tagging.beginScan(tag, marker))
+        return 0;
+      scanned = state;
+    }
+    size_t removed = 0;
+    for (bool done = false; !done;) {
+      typename Locking::Guard guard(locking);
+      if (scanned != state) {
+        // 旧组件只剩这里和XReclaimer的引用，无需加锁
+        scanned->tagging.endScan(marker);
+        reclaimer.retire(std::move(scanned), resource);
+        break;
+      }
+      for (size_t n = 0; n < std::max<size_t>(batchSize, 1); ++n) {
+        Entry *entry = state->tagging.template nextInScan<Entry>(marker);
+        if (!entry) {
+          state->tagging.endScan(marker);
+          done = true;
+          break;
+        }
+        removeEntry(entry);
+        removed++;
+      }
+    }
+    return removed;
+  }
+
+  // 原子读改写，语义见XComputeOps
+  template <typename Fn> Value modify(Key key, Fn &&fn) {
+    typename Locking::Guard guard(locking);
+    admission.record(key);
+    if (Entry *entry = state->index.find(key)) {
+      Value value = entry->value();
+      if (fn(value, true))
+        entry->value() = value;
+      state->eviction.onAccess(entry);
+      stats.onHit(key);
+      return value;
+    }
+    stats.onMiss(key);
+    Value value{};
+    if (fn(value, false) && capacityLimit != 0)
+      insert(key, value);
+    return value;
+  }
+
+  bool get(Key key, Value &value) {
+    typename Locking::Guard guard(locking);
+    admission.record(key);
+    Entry *entry = state->index.find(key);
+    if (!entry) {
+      stats.onMiss(key);
+      return false;
+    }
+    state->eviction.onAccess(entry);
+    value = entry->value();
+    stats.onHit(key);
+    return true;
+  }
+
+  Value get(Key key) {
+    Value value{};
+    get(key, value);
+    return value;
+  }
+
+  void remove(Key key) {
+    typename Locking::Guard guard(locking);
+    if (Entry *entry = state->index.find(key))
+      removeEntry(entry);
+  }
+
+  template <typename Pred> bool removeIf(Key key, const Pred &pred) {
+    typename Locking::Guard guard(locking);
+    Entry *entry = state->index.find(key);
+    if (!entry || !pred(static_cast<const Value &>(entry->value())))
+      return false;
+    removeEntry(entry);
+    return true;
+  }
+
+  // 不记录到准入sketch，不调整淘汰顺序，不计入统计
+  bool peek(Key key, Value &value) const {
+    typename Locking::SharedGuard guard(locking);
+    const Entry *entry = state->index.find(key);
+    if (!entry)
+      return false;
+    value = entry->value();
+    return true;
+  }
+
+  bool contains(Key key) const {
+    typename Locking::SharedGuard guard(locking);
+    return state->index.find(key) != nullptr;
+  }
+
+  size_t size() {
+    typename Locking::Guard guard(locking);
+    return state->index.size();
+  }
+
+  // 新的索引、淘汰与标签组件在锁外构造，锁内只交换指针，旧条目由XReclaimer在后台释放；
+  // 准入sketch与统计保留
+  void clear() {
+    std::shared_ptr<State> old = std::make_shared<State>(capacityLimit, resource);
+    {
+      typename Locking::Guard guard(locking);
+      std::swap(state, old);
+      retiredAny = true;
+    }
+    reclaimer.retire(std::move(old), resource);
+  }
+
+  size_t capacity() const { return capacityLimit; }
+  const Stats &getStats() const { return stats; }
+  const Tagging &getTagging() const { return state->tagging; }
+
+private:
+  // 随clear整体替换的组件
+  struct State {
+    State(size_t capacity, std::pmr::memory_resource *resource)
+        : index(make<Index<Key, Entry>>(capacity, resource)),
+          eviction(make<Eviction>(capacity, resource)),
+          tagging(make<Tagging>(capacity, resource)) {}
+
+    ~State() {
+      // 标签链接数组不归索引管理，先逐个归还
+      if constexpr (!std::is_same_v<Tagging, XNoTagging>) {
+        while (Entry *entry = eviction.template victim<Entry>()) {
+          eviction.onRemove(entry);
+          tagging.onRemove(entry);
+        }
+      }
+    }
+
+    Index<Key, Entry> index;
+    Eviction eviction;
+    Tagging tagging;
+  };
+
+  // 调用方持锁且key不存在；被准入拒绝时返回nullptr
+  Entry *insert(const Key &key, Value value) {
+    if (state->index.size() >= capacityLimit) {
+      Entry *victim = state->eviction.template victim<Entry>();
+      if (!admission.admit(key, victim->key)) {
+        stats.onReject(key);
+        return nullptr;
+      }
+      stats.onEvict(victim->key);
+      removeEntry(victim);
+    }
+    Entry *entry = state->index.emplace(key, Slot(std::move(value), resource));
+    state->eviction.onInsert(entry);
+    stats.onInsert(key);
+    return entry;
+  }
+
+  void removeEntry(Entry *entry) {
+    state->eviction.onRemove(entry);
+    state->tagging.onRemove(entry);
+    state->index.erase(Key(entry->key));
+  }
+
+  // 按组件支持的构造函数传入容量和resource
+  template <typename Component>
+  static Component make(size_t capacity, std::pmr::memory_resource *resource) {
+    if constexpr (std::is_constructible_v<Component, size_t,
+                                          std::pmr::memory_resource *>)
+      return Component(capacity, resource);
+    else if constexpr (std::is_constructible_v<Component,
+                                               std::pmr::memory_resource *>)
+      return Component(resource);
+    else if constexpr (std::is_constructible_v<Component, size_t>)
+      return Component(capacity);
+    else
+      return Component();
+  }
+
+  size_t capacityLimit;
+  std::pmr::memory_resource *resource;
+  std::shared_ptr<State> state; // invalidateTag扫描期间另持一份引用
+  Admission admission;
+  mutable Locking locking;
+  Stats stats;
+  bool retiredAny = false; // 是否有交给XReclaimer的旧组件
+  XReclaimer &reclaimer = XReclaimer::instance(); // 构造时创建，见XReclaimer.h
+};
+
+// 常用组合
+template <typename Key, typename Value>
+using XPolicyLRUCache = XPolicyCache<Key, Value>;
+
+template <typename Key, typename Value>
+using XPolicyLFUCache = XPolicyCache<Key, Value, XHashIndex, XLfuEviction>;
+
+// LRU淘汰 + TinyLFU准入（不带window的W-TinyLFU）
+template <typename Key, typename Value>
+using XPolicyTinyLFUCache =
+    XPolicyCache<Key, Value, XHashIndex, XLruEviction, XTinyLfuAdmission>;
+} // namespace XCache
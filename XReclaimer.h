@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+
+#include "XMemoryResource.h"
+
+// 后台释放：各引擎的clear()在锁内只把旧的数据结构换成空的，旧结构交给这里，
+// 由一个后台线程析构，千万级条目的释放不再占用缓存的锁。
+// 旧结构从引擎的memory_resource分配，只有resource线程安全（isThreadSafeResource，见XMemoryResource.h）
+// 时才交给后台线程，否则在调用retire的线程上直接释放，不与使用unsynchronized_pool_resource等的引擎竞争；
+// 调用过clear的引擎析构时调用drain，等待释放完成后resource才能销毁。
+// 引擎在构造时就取得instance()（成员reclaimer），XReclaimer先于引擎构造完成，
+// 因而在引擎之后析构：缓存是全局或静态对象时，退出阶段的drain不会碰到已销毁的XReclaimer
+namespace XCache {
+class XReclaimer {
+public:
+  static XReclaimer &instance() {
+    static XReclaimer reclaimer;
+    return reclaimer;
+  }
+
+  XReclaimer(const XReclaimer &) = delete;
+  XReclaimer &operator=(const XReclaimer &) = delete;
+
+  ~XReclaimer() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
+    }
+    workCv.notify_one();
+    worker.join();
+  }
+
+  // garbage从resource分配；resource线程安全时最后一个引用在后台线程释放，否则就地释放
+  void retire(std::shared_ptr<void> garbage,
+              std::pmr::memory_resource *resource) {
+    if (!garbage)
+      return;
+    if (!isThreadSafeResource(resource)) {
+      garbage.reset();
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      queue.push_back(std::move(garbage));
+      retired++;
+    }
+    workCv.notify_one();
+  }
+
+  // 等待此前提交的所有结构释放完成
+  void drain() {
+    std::unique_lock<std::mutex> lock(mtx);
+    uint64_t target = retired;
+    idleCv.wait(lock, [&] { return released >= target; });
+  }
+
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return static_cast<size_t>(retired - released);
+  }
+
+private:
+  XReclaimer() : worker([this] { run(); }) {}
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+      workCv.wait(lock, [&] { return stopping || !queue.empty(); });
+      if (queue.empty())
+        return; // stopping且已处理完
+      std::shared_ptr<void> garbage = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      garbage.reset();
+      lock.lock();
+      released++;
+      idleCv.notify_all();
+    }
+  }
+
+  mutable std::mutex mtx;
+  std::condition_variable workCv;
+  std::condition_variable idleCv;
+  std::deque<std::shared_ptr<void>> queue;
+  uint64_t retired = 0;
+  uint64_t released = 0;
+  bool stopping = false;
+  std::thread worker;
+};
+} // namespace XCache
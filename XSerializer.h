@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace XCache {
+// Key/Value序列化特征
+// 持久化、分层存储、共享内存、快照都通过它把Key/Value转换为字节。
+// 自定义类型只需特化Serializer<T>并提供：
+//   static size_t size(const T &v);                       // 编码后的字节数
+//   static void write(const T &v, char *dst);             // 写入size(v)个字节
+//   static bool read(std::string_view bytes, T &out);     // 解码，格式错误返回false
+// 可选提供 static std::string_view view(const T &v)，返回与write等价的连续字节，
+// 此时调用方可以直接引用原对象的内存而不做任何拷贝。
+template <typename T, typename Enable = void> struct Serializer;
+
+// 可平凡拷贝类型：按内存表示直接读写
+template <typename T>
+struct Serializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+  static constexpr bool kFixedSize = true;
+
+  static size_t size(const T &) { return sizeof(T); }
+
+  static std::string_view view(const T &v) {
+    return std::string_view(reinterpret_cast<const char *>(&v), sizeof(T));
+  }
+
+  static void write(const T &v, char *dst) { std::memcpy(dst, &v, sizeof(T)); }
+
+  static bool read(std::string_view bytes, T &out) {
+    if (bytes.size() != sizeof(T))
+      return false;
+    std::memcpy(&out, bytes.data(), sizeof(T));
+    return true;
+  }
+};
+
+// std::string：负载就是字符串本身，长度由外层记录格式携带
+template <> struct Serializer<std::string> {
+  static constexpr bool kFixedSize = false;
+
+  static size_t size(const std::string &v) { return v.size(); }
+
+  static std::string_view view(const std::string &v) { return v; }
+
+  static void write(const std::string &v, char *dst) {
+    std::memcpy(dst, v.data(), v.size());
+  }
+
+  static bool read(std::string_view bytes, std::string &out) {
+    out.assign(bytes.data(), bytes.size()); // 复用out已有的容量
+    return true;
+  }
+};
+
+// 元素可平凡拷贝的std::vector：连续内存直接视为字节
+template <typename T>
+struct Serializer<std::vector<T>,
+                  std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+  static constexpr bool kFixedSize = false;
+
+  static size_t size(const std::vector<T> &v) { return v.size() * sizeof(T); }
+
+  static std::string_view view(const std::vector<T> &v) {
+    return std::string_view(reinterpret_cast<const char *>(v.data()),
+                            v.size() * sizeof(T));
+  }
+
+  static void write(const std::vector<T> &v, char *dst) {
+    if (!v.empty())
+      std::memcpy(dst, v.data(), v.size() * sizeof(T));
+  }
+
+  static bool read(std::string_view bytes, std::vector<T> &out) {
+    if (bytes.size() % sizeof(T) != 0)
+      return false;
+    out.resize(bytes.size() / sizeof(T));
+    if (!out.empty())
+      std::memcpy(out.data(), bytes.data(), bytes.size());
+    return true;
+  }
+};
+
+// std::pair：第一个元素前写入32位长度，用于组合键（如命名空间+key）
+template <typename A, typename B>
+struct Serializer<std::pair<A, B>,
+                  std::enable_if_t<!std::is_trivially_copyable<
+                      std::pair<A, B>>::value>> {
+  static constexpr bool kFixedSize = false;
+
+  static size_t size(const std::pair<A, B> &v) {
+    return sizeof(uint32_t) + Serializer<A>::size(v.first) +
+           Serializer<B>::size(v.second);
+  }
+
+  static void write(const std::pair<A, B> &v, char *dst) {
+    uint32_t firstSize = static_cast<uint32_t>(Serializer<A>::size(v.first));
+    std::memcpy(dst, &firstSize, sizeof(firstSize));
+    Serializer<A>::write(v.first, dst + sizeof(firstSize));
+    Serializer<B>::write(v.second, dst + sizeof(firstSize) + firstSize);
+  }
+
+  static bool read(std::string_view bytes, std::pair<A, B> &out) {
+    uint32_t firstSize;
+    if (bytes.size() < sizeof(firstSize))
+      return false;
+    std::memcpy(&firstSize, bytes.data(), sizeof(firstSize));
+    bytes.remove_prefix(sizeof(firstSize));
+    if (bytes.size() < firstSize)
+      return false;
+    return Serializer<A>::read(bytes.substr(0, firstSize), out.first) &&
+           Serializer<B>::read(bytes.substr(firstSize), out.second);
+  }
+};
+
+namespace detail {
+template <typename T, typename = void>
+struct IsSerializable : std::false_type {};
+
+template <typename T>
+struct IsSerializable<
+    T, std::void_t<decltype(Serializer<T>::size(std::declval<const T &>())),
+                   decltype(Serializer<T>::write(std::declval<const T &>(),
+                                                 std::declval<char *>())),
+                   decltype(Serializer<T>::read(std::declval<std::string_view>(),
+                                                std::declval<T &>()))>>
+    : std::true_type {};
+
+template <typename T, typename = void> struct HasView : std::false_type {};
+
+template <typename T>
+struct HasView<T, std::void_t<decltype(Serializer<T>::view(
+                      std::declval<const T &>()))>> : std::true_type {};
+} // namespace detail
+
+// T是否有可用的Serializer（内置类型或用户特化）
+template <typename T>
+constexpr bool isSerializable = detail::IsSerializable<T>::value;
+
+// T是否支持零拷贝视图
+template <typename T>
+constexpr bool hasSerializedView = detail::HasView<T>::value;
+
+template <typename T> size_t serializedSize(const T &v) {
+  return Serializer<T>::size(v);
+}
+
+// 写入dst，有零拷贝视图时走单次memcpy
+template <typename T> void serializeTo(const T &v, char *dst) {
+  if constexpr (hasSerializedView<T>) {
+    std::string_view bytes = Serializer<T>::view(v);
+    if (!bytes.empty())
+      std::memcpy(dst, bytes.data(), bytes.size());
+  } else {
+    Serializer<T>::write(v, dst);
+  }
+}
+
+// 追加到out末尾，out的容量在多次调用间复用
+template <typename T> void serializeAppend(const T &v, std::string &out) {
+  size_t offset = out.size();
+  out.resize(offset + Serializer<T>::size(v));
+  serializeTo(v, &out[offset]);
+}
+
+template <typename T> bool deserialize(std::string_view bytes, T &out) {
+  return Serializer<T>::read(bytes, out);
+}
+} // namespace XCache
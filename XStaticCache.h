@@ -0,0 +1,148 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "XCachePolicy.h"
+
+// 静态分派：热点调用处直接持有具体引擎类型，不经过XCachePolicy的虚表。
+// 引擎只需提供put(Key, Value)、get(Key, Value&)、remove(Key)，不要求继承任何基类；
+// 需要运行时按名称选择时再用XCachePolicyAdapter擦除类型
+namespace XCache {
+namespace detail {
+template <typename Engine, typename Key, typename Value, typename = void>
+struct IsCacheEngine : std::false_type {};
+
+template <typename Engine, typename Key, typename Value>
+struct IsCacheEngine<
+    Engine, Key, Value,
+    std::void_t<decltype(std::declval<Engine &>().put(std::declval<Key>(),
+                                                      std::declval<Value>())),
+                decltype(std::declval<Engine &>().remove(std::declval<Key>()))>>
+    : std::is_same<decltype(std::declval<Engine &>().get(
+                       std::declval<Key>(), std::declval<Value &>())),
+                   bool> {};
+
+template <typename Engine, typename = void>
+struct HasEvictionStats : std::false_type {};
+
+template <typename Engine>
+struct HasEvictionStats<
+    Engine, std::void_t<decltype(std::declval<Engine &>().setEvictionStats(
+                std::shared_ptr<XEvictionStats>()))>> : std::true_type {};
+} // namespace detail
+
+// Engine是否满足引擎接口（C++17下代替concept）
+template <typename Engine, typename Key, typename Value>
+inline constexpr bool isCacheEngine =
+    detail::IsCacheEngine<Engine, Key, Value>::value;
+
+// 持有具体引擎的外观。对象的动态类型就是Engine，所以用限定名调用（engine.Engine::get）
+// 与虚调用语义相同，但在编译期绑定，命中路径可以整体内联
+template <typename Key, typename Value, typename Engine>
+class XStaticCache
+    : public XComputeOps<XStaticCache<Key, Value, Engine>, Key, Value> {
+  static_assert(isCacheEngine<Engine, Key, Value>,
+                "XStaticCache: Engine需要提供put/get/remove");
+
+public:
+  template <typename... Args>
+  explicit XStaticCache(Args &&...args) : engine(std::forward<Args>(args)...) {}
+
+  void put(Key key, Value value) {
+    engine.Engine::put(std::move(key), std::move(value));
+  }
+
+  bool get(Key key, Value &value) {
+    return engine.Engine::get(std::move(key), value);
+  }
+
+  Value get(Key key) {
+    Value value{};
+    get(std::move(key), value);
+    return value;
+  }
+
+  void remove(Key key) { engine.Engine::remove(std::move(key)); }
+
+  template <typename Pred> bool removeIf(Key key, Pred &&pred) {
+    return engine.Engine::removeIf(std::move(key), std::forward<Pred>(pred));
+  }
+
+  bool peek(Key key, Value &value) const {
+    return engine.Engine::peek(std::move(key), value);
+  }
+  bool contains(Key key) const {
+    return engine.Engine::contains(std::move(key));
+  }
+
+  template <typename Fn> Value modify(Key key, Fn &&fn) {
+    return engine.Engine::modify(std::move(key), std::forward<Fn>(fn));
+  }
+
+  void clear() { engine.Engine::clear(); }
+
+  Engine &getEngine() { return engine; }
+
+private:
+  Engine engine;
+};
+
+// 类型擦除适配器：把任意满足引擎接口的类型（分片缓存、XPolicyCache等）包成XCachePolicy
+template <typename Key, typename Value, typename Engine>
+class XCachePolicyAdapter final : public XCachePolicy<Key, Value> {
+  static_assert(isCacheEngine<Engine, Key, Value>,
+                "XCachePolicyAdapter: Engine需要提供put/get/remove");
+
+public:
+  template <typename... Args>
+  explicit XCachePolicyAdapter(Args &&...args)
+      : engine(std::forward<Args>(args)...) {}
+
+  void put(Key key, Value value) override {
+    engine.put(std::move(key), std::move(value));
+  }
+  bool get(Key key, Value &value) override {
+    return engine.get(std::move(key), value);
+  }
+  Value get(Key key) override {
+    Value value{};
+    engine.get(std::move(key), value);
+    return value;
+  }
+  void remove(Key key) override { engine.remove(std::move(key)); }
+  bool removeIf(Key key,
+                const typename XCachePolicy<Key, Value>::RemovePred &pred) override {
+    return engine.removeIf(std::move(key), pred);
+  }
+  bool peek(Key key, Value &value) const override {
+    return engine.peek(std::move(key), value);
+  }
+  bool contains(Key key) const override {
+    return engine.contains(std::move(key));
+  }
+  Value modify(Key key,
+               const typename XCachePolicy<Key, Value>::ModifyFn &fn) override {
+    return engine.modify(std::move(key), fn);
+  }
+  void clear() override { engine.clear(); }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    if constexpr (detail::HasEvictionStats<Engine>::value)
+      engine.setEvictionStats(std::move(stats));
+  }
+
+  Engine &getEngine() { return engine; }
+
+private:
+  Engine engine;
+};
+
+// 便捷函数：构造引擎并擦除类型
+template <typename Key, typename Value, typename Engine, typename... Args>
+std::unique_ptr<XCachePolicy<Key, Value>> makeCachePolicyAdapter(Args &&...args) {
+  return std::make_unique<XCachePolicyAdapter<Key, Value, Engine>>(
+      std::forward<Args>(args)...);
+}
+} // namespace XCache
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// 编译期追踪钩子：各引擎的最后一个模板参数Tracer，在命中、未命中、插入、淘汰、
+// 晋升、准入判定和锁等待时调用Tracer的静态函数。默认的XNoopTracer全部为空内联函数，
+// 锁也退化为普通的lock/unlock，开启优化后不留下任何指令。
+//
+// 各引擎的事件含义：
+//   promote   LRU-K从历史队列进入主缓存；ARC从LRU部分转入LFU部分；
+//             W-TinyLFU中window淘汰出的条目进入主区（有空位或准入胜出）
+//   admission W-TinyLFU的频率比较，candidate为window淘汰出的条目，victim为主区最老条目
+//   evict     被挤出缓存的条目；ARC为任一部分移入幽灵表，W-TinyLFU为准入比较的败者
+//   lockWait  只在锁被占用时计时，未竞争的加锁路径与不追踪时相同
+namespace XCache {
+struct XNoopTracer {
+  static constexpr bool kEnabled = false;
+
+  template <typename Key> static void onHit(const void *, const Key &) {}
+  template <typename Key> static void onMiss(const void *, const Key &) {}
+  template <typename Key> static void onInsert(const void *, const Key &) {}
+  template <typename Key> static void onEvict(const void *, const Key &) {}
+  template <typename Key> static void onPromote(const void *, const Key &) {}
+  template <typename Key>
+  static void onAdmission(const void *, const Key &, const Key &, bool) {}
+  static void onLockWait(const void *, uint64_t) {}
+};
+
+// 带锁等待追踪的lock_guard：Tracer未开启时与std::lock_guard完全相同
+template <typename Tracer> class XTracedLock {
+public:
+  XTracedLock(std::mutex &mtx, const void *cache) : mtx(mtx) {
+    if constexpr (Tracer::kEnabled) {
+      if (!mtx.try_lock()) {
+        auto begin = std::chrono::steady_clock::now();
+        mtx.lock();
+        Tracer::onLockWait(
+            cache, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count());
+      }
+    } else {
+      (void)cache;
+      mtx.lock();
+    }
+  }
+
+  ~XTracedLock() { mtx.unlock(); }
+
+  XTracedLock(const XTracedLock &) = delete;
+  XTracedLock &operator=(const XTracedLock &) = delete;
+
+private:
+  std::mutex &mtx;
+};
+} // namespace XCache
+
+// USDT（SystemTap SDT）静态探针：探针处只有一条nop，参数描述写在.note.stapsdt段中，
+// bpftrace/perf/SystemTap按ELF note定位探针并在附加时把nop换成断点。
+// 与<sys/sdt.h>生成相同的note格式，不依赖systemtap-sdt-dev；目前只支持x86-64 ELF，
+// 其他平台下探针为空
+#if defined(__x86_64__) && defined(__ELF__)
+#define XCACHE_SDT_PROBE_(name, argfmt, ...)                                   \
+  __asm__ __volatile__(                                                        \
+      "990: nop\n"                                                             \
+      ".pushsection .note.stapsdt,\"?\",\"note\"\n"                            \
+      ".balign 4\n"                                                            \
+      ".4byte 992f-991f, 994f-993f, 3\n"                                       \
+      "991: .asciz \"stapsdt\"\n"                                              \
+      "992: .balign 4\n"                                                       \
+      "993: .8byte 990b\n"                                                     \
+      ".8byte _.stapsdt.base\n"                                                \
+      ".8byte 0\n"                                                             \
+      ".asciz \"xcache\"\n"                                                    \
+      ".asciz \"" #name "\"\n"                                                 \
+      ".asciz \"" argfmt "\"\n"                                                \
+      "994: .balign 4\n"                                                       \
+      ".popsection\n"                                                          \
+      ".ifndef _.stapsdt.base\n"                                               \
+      ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"  \
+      ".weak _.stapsdt.base\n"                                                 \
+      ".hidden _.stapsdt.base\n"                                               \
+      "_.stapsdt.base: .space 1\n"                                             \
+      ".size _.stapsdt.base, 1\n"                                              \
+      ".popsection\n"                                                          \
+      ".endif\n" ::__VA_ARGS__)
+#define XCACHE_PROBE2(name, x0, x1)                                            \
+  XCACHE_SDT_PROBE_(name, "8@%[a0] 8@%[a1]", [a0] "nor"(x0), [a1] "nor"(x1))
+#define XCACHE_PROBE4(name, x0, x1, x2, x3)                                    \
+  XCACHE_SDT_PROBE_(name, "8@%[a0] 8@%[a1] 8@%[a2] 8@%[a3]", [a0] "nor"(x0),  \
+                    [a1] "nor"(x1), [a2] "nor"(x2), [a3] "nor"(x3))
+#else
+#define XCACHE_PROBE2(name, x0, x1) ((void)(x0), (void)(x1))
+#define XCACHE_PROBE4(name, x0, x1, x2, x3)                                    \
+  ((void)(x0), (void)(x1), (void)(x2), (void)(x3))
+#endif
+
+namespace XCache {
+// USDT实现：provider为xcache，所有参数为64位无符号数，arg0为引擎地址（区分实例），
+// key以std::hash的结果给出。例如统计每个实例的未命中：
+//   bpftrace -e 'usdt:./app:xcache:miss { @[arg0] = count(); }'
+// 探针：hit/miss/insert/evict/promote(cache, keyHash)、
+//       admission(cache, candidateHash, victimHash, admitted)、lock_wait(cache, ns)。
+// 未附加时每个事件的开销是一次key哈希加一条nop
+struct XUsdtTracer {
+  static constexpr bool kEnabled = true;
+
+  template <typename Key> static void onHit(const void *cache, const Key &key) {
+    uint64_t c = addr(cache), h = hash(key);
+    XCACHE_PROBE2(hit, c, h);
+  }
+  template <typename Key>
+  static void onMiss(const void *cache, const Key &key) {
+    uint64_t c = addr(cache), h = hash(key);
+    XCACHE_PROBE2(miss, c, h);
+  }
+  template <typename Key>
+  static void onInsert(const void *cache, const Key &key) {
+    uint64_t c = addr(cache), h = hash(key);
+    XCACHE_PROBE2(insert, c, h);
+  }
+  template <typename Key>
+  static void onEvict(const void *cache, const Key &key) {
+    uint64_t c = addr(cache), h = hash(key);
+    XCACHE_PROBE2(evict, c, h);
+  }
+  template <typename Key>
+  static void onPromote(const void *cache, const Key &key) {
+    uint64_t c = addr(cache), h = hash(key);
+    XCACHE_PROBE2(promote, c, h);
+  }
+  template <typename Key>
+  static void onAdmission(const void *cache, const Key &candidate,
+                          const Key &victim, bool admitted) {
+    uint64_t c = addr(cache), ch = hash(candidate), vh = hash(victim),
+             a = admitted;
+    XCACHE_PROBE4(admission, c, ch, vh, a);
+  }
+  static void onLockWait(const void *cache, uint64_t nanos) {
+    uint64_t c = addr(cache);
+    XCACHE_PROBE2(lock_wait, c, nanos);
+  }
+
+private:
+  static uint64_t addr(const void *p) { return reinterpret_cast<uintptr_t>(p); }
+  template <typename Key> static uint64_t hash(const Key &key) {
+    return std::hash<Key>()(key);
+  }
+};
+} // namespace XCache
@@ -3,13 +3,19 @@
 #include <cmath>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <random>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "XCacheCursor.h"
 #include "XCachePolicy.h"
+#include "XEvictionStats.h"
 #include "XLRUCache.h"
+#include "XReclaimer.h"
+#include "XTracer.h"
 
 namespace XCache {
 // Count-Min Sketch频率估算器
@@ -20,7 +26,7 @@ private:
     Counter() : count(0) {}
   };
 
-  std::vector<std::vector<Counter>> counters;
+  std::pmr::vector<std::pmr::vector<Counter>> counters;
   std::vector<std::hash<Key>> hashFunctions;
   std::vector<uint64_t> hashSeeds;
   int width;
@@ -29,9 +35,11 @@ private:
   std::mutex mtx;
 
 public:
-  FrequencySketch(int width = 256, int depth = 4, size_t sampleSize = 10000)
-      : width(width), depth(depth), sampleSize(sampleSize) {
-    counters.resize(depth, std::vector<Counter>(width));
+  FrequencySketch(
+      int width = 256, int depth = 4, size_t sampleSize = 10000,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : counters(resource), width(width), depth(depth), sampleSize(sampleSize) {
+    counters.resize(depth, std::pmr::vector<Counter>(width, resource));
 
     // 创建不同的哈希函数
     std::random_device rd;
@@ -92,8 +100,8 @@ public:
   size_t getSampleSize() const { return sampleSize; }
 };
 
-// W-TinyLFU主缓存实现
-template <typename Key, typename Value>
+// W-TinyLFU主缓存实现；window与victim内部不追踪，事件由本层上报
+template <typename Key, typename Value, typename Tracer = XNoopTracer>
 class XWTinyLFUCache : public XCachePolicy<Key, Value> {
 private:
   // Window Cache - 处理新访问的条目
@@ -124,11 +132,35 @@ private:
   size_t operationCount = 0;  // 用于触发衰减的操作计数
 
   // 主锁
-  std::mutex mainMutex;
+  mutable std::mutex mainMutex;
+
+  std::pmr::memory_resource *resource;
+
+  std::shared_ptr<XEvictionStats> evictionStats; // 为空时不统计
+
+  uint64_t clears = 0;     // clear次数，游标据此发现遍历期间的清空
+  bool retiredAny = false; // 是否有交给XReclaimer的旧结构
+  XReclaimer &reclaimer = XReclaimer::instance(); // 构造时创建，见XReclaimer.h
 
 public:
-  XWTinyLFUCache(size_t capacity, double windowRatio = 0.01)
-      : totalCapacity(capacity), windowRatio(windowRatio) {
+  using ModifyFn = typename XCachePolicy<Key, Value>::ModifyFn;
+  using RemovePred = typename XCachePolicy<Key, Value>::RemovePred;
+  using Cursor = XCacheCursor<Key, Value, XWTinyLFUCache>;
+
+  // 游标位置：region为0时在window，1时在主区（victim），2时结束；
+  // epoch为开始遍历时的clear次数（clear换掉了两个区，区内的epoch无法察觉）
+  struct CursorPosition {
+    int region = 0;
+    typename XLRUCache<Key, Value>::CursorPosition lru;
+    uint64_t epoch = 0;
+    bool started = false;
+  };
+
+  // resource见XMemoryResource.h
+  XWTinyLFUCache(
+      size_t capacity, double windowRatio = 0.01,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : totalCapacity(capacity), windowRatio(windowRatio), resource(resource) {
     windowCapacity = static_cast<size_t>(capacity * windowRatio);
     victimCapacity = capacity - windowCapacity;
 
@@ -137,22 +169,24 @@ public:
     if (victimCapacity == 0)
       victimCapacity = capacity - 1;
 
-    windowCache = std::make_unique<XLRUCache<Key, Value>>(windowCapacity);
-    victimCache = std::make_unique<XLRUCache<Key, Value>>(victimCapacity);
+    windowCache =
+        std::make_unique<XLRUCache<Key, Value>>(windowCapacity, resource);
+    victimCache =
+        std::make_unique<XLRUCache<Key, Value>>(victimCapacity, resource);
 
-    // Frequency Sketch的宽度约为总容量的4倍
-    int sketchWidth = std::max(256, static_cast<int>(capacity * 4));
-    frequencySketch =
-        std::make_unique<FrequencySketch<Key>>(sketchWidth, 4, capacity);
+    frequencySketch = makeSketch();
   }
 
-  ~XWTinyLFUCache() override = default;
+  ~XWTinyLFUCache() override {
+    if (retiredAny)
+      reclaimer.drain(); // 后台释放完成前resource不能销毁
+  }
 
   void put(Key key, Value value) override {
     if (totalCapacity == 0)
       return;
 
-    std::lock_guard<std::mutex> lock(mainMutex);
+    XTracedLock<Tracer> lock(mainMutex, this);
 
     // 更新频率统计
     frequencySketch->increment(key);
@@ -180,13 +214,16 @@ public:
     // 新条目处理
     ensureWindowCapacity();
     windowCache->put(key, value);
+    Tracer::onInsert(this, key);
+    if (evictionStats)
+      evictionStats->onInsert(evictionKeyHash(key));
   }
 
   bool get(Key key, Value &value) override {
     if (totalCapacity == 0)
       return false;
 
-    std::lock_guard<std::mutex> lock(mainMutex);
+    XTracedLock<Tracer> lock(mainMutex, this);
 
     // 更新频率统计
     frequencySketch->increment(key);
@@ -194,6 +231,9 @@ public:
     // 先在Window Cache中查找
     if (windowCache->get(key, value)) {
       updateStats(true, true);
+      Tracer::onHit(this, key);
+      if (evictionStats)
+        evictionStats->onHit(evictionKeyHash(key));
       // 策略：留在Window，等它自然淘汰时再通过Admission进入Victim
       return true;
     }
@@ -201,6 +241,9 @@ public:
     // 再在Victim Cache中查找
     if (victimCache->get(key, value)) {
       updateStats(true, false);
+      Tracer::onHit(this, key);
+      if (evictionStats)
+        evictionStats->onHit(evictionKeyHash(key));
       // 不要移动到Window！
       // XLRUCache::get内部已经包含LRU提升逻辑（移到链表头部）
       // 所以这里什么都不用做，让热点数据安稳地待在Victim Cache里
@@ -208,6 +251,9 @@ public:
     }
 
     updateStats(false, false);
+    Tracer::onMiss(this, key);
+    if (evictionStats)
+      evictionStats->onMiss(evictionKeyHash(key));
     return false;
   }
 
@@ -217,10 +263,106 @@ public:
     return value;
   }
 
-  void remove(Key key) {
-    std::lock_guard<std::mutex> lock(mainMutex);
+  void remove(Key key) override {
+    XTracedLock<Tracer> lock(mainMutex, this);
     windowCache->remove(key);
     victimCache->remove(key);
+    if (evictionStats)
+      evictionStats->onRemove(evictionKeyHash(key));
+  }
+
+  bool removeIf(Key key, const RemovePred &pred) override {
+    XTracedLock<Tracer> lock(mainMutex, this);
+    bool removed = windowCache->removeIf(key, pred);
+    removed = victimCache->removeIf(key, pred) || removed;
+    if (removed && evictionStats)
+      evictionStats->onRemove(evictionKeyHash(key));
+    return removed;
+  }
+
+  // sketch只记录一次访问；已存在时在所在区原地更新，不存在时写回走与put相同的新条目路径
+  Value modify(Key key, const ModifyFn &fn) override {
+    if (totalCapacity == 0)
+      return Value{};
+
+    XTracedLock<Tracer> lock(mainMutex, this);
+    frequencySketch->increment(key);
+
+    bool found = false;
+    auto existing = [&](Value &value, bool present) {
+      found = present;
+      return present && fn(value, true);
+    };
+    Value result = windowCache->modify(key, existing);
+    bool inWindow = found;
+    if (!found)
+      result = victimCache->modify(key, existing);
+    if (found) {
+      updateStats(true, inWindow);
+      Tracer::onHit(this, key);
+      if (evictionStats)
+        evictionStats->onHit(evictionKeyHash(key));
+      return result;
+    }
+
+    updateStats(false, false);
+    Tracer::onMiss(this, key);
+    if (evictionStats)
+      evictionStats->onMiss(evictionKeyHash(key));
+    Value value{};
+    if (fn(value, false)) {
+      ensureWindowCapacity();
+      windowCache->put(key, value);
+      Tracer::onInsert(this, key);
+      if (evictionStats)
+        evictionStats->onInsert(evictionKeyHash(key));
+    }
+    return value;
+  }
+
+  // 不更新sketch与命中统计，window和主区的LRU顺序也不变
+  bool peek(Key key, Value &value) const override {
+    std::lock_guard<std::mutex> lock(mainMutex);
+    return windowCache->peek(key, value) || victimCache->peek(key, value);
+  }
+
+  bool contains(Key key) const override {
+    std::lock_guard<std::mutex> lock(mainMutex);
+    return windowCache->contains(key) || victimCache->contains(key);
+  }
+
+  // 先window再主区，每个区内从MRU到LRU，语义见XCacheCursor.h
+  Cursor cursor(size_t chunkSize = 1024) const {
+    return Cursor(*this, chunkSize);
+  }
+
+  // 在主锁内从position继续，window取完后在同一分块内接着取主区
+  bool cursorChunk(CursorPosition &position, size_t budget,
+                   std::vector<std::pair<Key, Value>> &out) const {
+    std::lock_guard<std::mutex> lock(mainMutex);
+    if (!position.started) {
+      position.started = true;
+      position.epoch = clears;
+    } else if (position.epoch != clears) {
+      position.region = 2; // 遍历期间被clear
+      return true;
+    }
+    while (position.region < 2 && budget > 0) {
+      const auto &region = position.region == 0 ? windowCache : victimCache;
+      size_t before = out.size();
+      if (!region->cursorChunk(position.lru, budget, out))
+        return false;
+      budget -= out.size() - before;
+      position.region++;
+      position.lru = {};
+    }
+    return position.region == 2;
+  }
+
+  // 准入比较中落败的一方计为淘汰（新条目被拒绝或victim中的候选被替换）
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    std::lock_guard<std::mutex> lock(mainMutex);
+    evictionStats = std::move(stats);
   }
 
   // 获取统计信息
@@ -276,15 +418,50 @@ public:
     operationCount = 0;
   }
 
+  // 新的window与主区在锁外构造，锁内只交换指针，旧的两个区由XReclaimer在后台释放。
+  // sketch保留：清空后重新写入的key仍按清空前的访问频率参与准入
+  void clear() override {
+    auto retired = std::make_shared<Regions>(
+        std::make_unique<XLRUCache<Key, Value>>(windowCapacity, resource),
+        std::make_unique<XLRUCache<Key, Value>>(victimCapacity, resource));
+    {
+      std::lock_guard<std::mutex> lock(mainMutex);
+      std::swap(windowCache, retired->first);
+      std::swap(victimCache, retired->second);
+      clears++;
+      retiredAny = true;
+      if (evictionStats)
+        evictionStats->onClear();
+    }
+    reclaimer.retire(std::move(retired), resource);
+  }
+
+  // clear之外把sketch也换成新的，并清零统计
   void reset() {
-    std::lock_guard<std::mutex> lock(mainMutex);
-    windowCache = std::make_unique<XLRUCache<Key, Value>>(windowCapacity);
-    victimCache = std::make_unique<XLRUCache<Key, Value>>(victimCapacity);
-    frequencySketch->reset();
+    std::unique_ptr<FrequencySketch<Key>> fresh = makeSketch();
+    std::shared_ptr<FrequencySketch<Key>> old;
+    {
+      std::lock_guard<std::mutex> lock(mainMutex);
+      old = std::move(frequencySketch);
+      frequencySketch = std::move(fresh);
+      retiredAny = true;
+    }
+    reclaimer.retire(std::move(old), resource);
+    clear();
     resetStats();
   }
 
 private:
+  using Regions = std::pair<std::unique_ptr<XLRUCache<Key, Value>>,
+                            std::unique_ptr<XLRUCache<Key, Value>>>;
+
+  std::unique_ptr<FrequencySketch<Key>> makeSketch() const {
+    // Frequency Sketch的宽度约为总容量的4倍
+    int sketchWidth = std::max(256, static_cast<int>(totalCapacity * 4));
+    return std::make_unique<FrequencySketch<Key>>(sketchWidth, 4,
+                                                  totalCapacity, resource);
+  }
+
   void ensureWindowCapacity() {
     // 如果Window Cache满了，将最老的条目移到Victim Cache
     if (windowCache->size() >= windowCapacity) {
@@ -312,6 +489,7 @@ private:
     // 如果Victim Cache不满，直接添加
     if (victimCache->size() < victimCapacity) {
       victimCache->put(newKey, newValue);
+      Tracer::onPromote(this, newKey);
       return;
     }
 
@@ -321,6 +499,7 @@ private:
     Value victimCandidateValue;
     if (!victimCache->get(victimCandidateKey, victimCandidateValue)) {
       victimCache->put(newKey, newValue);
+      Tracer::onPromote(this, newKey);
       return;
     }
 
@@ -329,14 +508,23 @@ private:
     uint32_t victimFreq = frequencySketch->frequency(victimCandidateKey);
 
     // W-TinyLFU核心逻辑：频率比较
-    if (newKeyFreq >= victimFreq) {
+    bool admitted = newKeyFreq >= victimFreq;
+    Tracer::onAdmission(this, newKey, victimCandidateKey, admitted);
+    if (admitted) {
       // 新条目频率更高或相等，替换旧条目
       victimCache->remove(victimCandidateKey);
       victimCache->put(newKey, newValue);
       admissionWins++;
+      Tracer::onEvict(this, victimCandidateKey);
+      Tracer::onPromote(this, newKey);
+      if (evictionStats)
+        evictionStats->onEvict(evictionKeyHash(victimCandidateKey));
     } else {
       // 旧条目频率更高，拒绝新条目
       admissionLosses++;
+      Tracer::onEvict(this, newKey);
+      if (evictionStats)
+        evictionStats->onEvict(evictionKeyHash(newKey));
       // 保留victimCandidateKey，不添加newKey
     }
   }
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 工作负载生成库：YCSB风格的key分布与分阶段混合负载，gtest与基准测试共用。
+// 所有序列由种子完全确定（只使用mt19937_64的原始输出，不依赖标准库分布的实现），
+// 并预先生成为数组，生成开销不计入计时
+namespace XCache {
+enum class XKeyDist {
+  Uniform,    // [base, base+keys)内均匀
+  Zipfian,    // Zipf分布，scrambled时热点打散到整个key空间
+  Latest,     // 越新插入的key越热，按insertRatio不断插入新key
+  Hotspot,    // hotFraction的key承担hotOpFraction的访问
+  Sequential, // 从base开始单调递增，不重复（一次性扫描）
+  Loop,       // 在[base, base+keys)内循环顺序访问
+};
+
+struct XKeySpec {
+  XKeyDist dist = XKeyDist::Uniform;
+  uint64_t keys = 1000;
+  uint64_t base = 0;
+  double theta = 0.99;        // Zipfian/Latest的偏斜参数，越大越集中
+  bool scrambled = true;      // Zipfian是否打散热点
+  double insertRatio = 0.05;  // Latest中插入新key的比例
+  double hotFraction = 0.2;   // Hotspot中热key占比
+  double hotOpFraction = 0.8; // Hotspot中访问热key的比例
+
+  static XKeySpec uniform(uint64_t keys, uint64_t base = 0) {
+    XKeySpec spec;
+    spec.keys = keys;
+    spec.base = base;
+    return spec;
+  }
+  static XKeySpec zipfian(uint64_t keys, double theta = 0.99,
+                          bool scrambled = true, uint64_t base = 0) {
+    XKeySpec spec = uniform(keys, base);
+    spec.dist = XKeyDist::Zipfian;
+    spec.theta = theta;
+    spec.scrambled = scrambled;
+    return spec;
+  }
+  static XKeySpec latest(uint64_t keys, double theta = 0.99,
+                         double insertRatio = 0.05, uint64_t base = 0) {
+    XKeySpec spec = uniform(keys, base);
+    spec.dist = XKeyDist::Latest;
+    spec.theta = theta;
+    spec.insertRatio = insertRatio;
+    return spec;
+  }
+  static XKeySpec hotspot(uint64_t keys, double hotFraction = 0.2,
+                          double hotOpFraction = 0.8, uint64_t base = 0) {
+    XKeySpec spec = uniform(keys, base);
+    spec.dist = XKeyDist::Hotspot;
+    spec.hotFraction = hotFraction;
+    spec.hotOpFraction = hotOpFraction;
+    return spec;
+  }
+  static XKeySpec sequential(uint64_t base = 0) {
+    XKeySpec spec = uniform(1, base);
+    spec.dist = XKeyDist::Sequential;
+    return spec;
+  }
+  static XKeySpec loop(uint64_t keys, uint64_t base = 0) {
+    XKeySpec spec = uniform(keys, base);
+    spec.dist = XKeyDist::Loop;
+    return spec;
+  }
+};
+
+namespace detail {
+// [0, n)内均匀，乘法取高位，避免取模偏差和标准库分布的实现差异
+inline uint64_t uniformBelow(std::mt19937_64 &rng, uint64_t n) {
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(rng()) * n) >> 64);
+}
+
+// [0, 1)内均匀
+inline double uniformReal(std::mt19937_64 &rng) {
+  return (rng() >> 11) * 0x1.0p-53;
+}
+
+// splitmix64的混合函数，用于打散Zipf的排名
+inline uint64_t scramble(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+} // namespace detail
+
+// YCSB的Zipfian生成器（Gray等人的算法），返回[0, n)的排名，0最热
+class XZipfian {
+public:
+  XZipfian(uint64_t n, double theta) : n(std::max<uint64_t>(n, 1)), theta(theta) {
+    zetan = zeta(this->n, theta);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1 - std::pow(2.0 / this->n, 1 - theta)) /
+          (1 - zeta(2, theta) / zetan);
+  }
+
+  uint64_t next(std::mt19937_64 &rng) const {
+    double u = detail::uniformReal(rng);
+    double uz = u * zetan;
+    if (uz < 1.0)
+      return 0;
+    if (uz < 1.0 + std::pow(0.5, theta))
+      return std::min<uint64_t>(1, n - 1);
+    return std::min<uint64_t>(
+        n - 1, static_cast<uint64_t>(n * std::pow(eta * u - eta + 1, alpha)));
+  }
+
+private:
+  static double zeta(uint64_t n, double theta) {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; ++i)
+      sum += 1.0 / std::pow(double(i), theta);
+    return sum;
+  }
+
+  uint64_t n;
+  double theta;
+  double zetan;
+  double alpha;
+  double eta;
+};
+
+// 按XKeySpec逐个产生key，内部状态（循环位置、最新key）随调用推进
+class XKeyGenerator {
+public:
+  explicit XKeyGenerator(const XKeySpec &spec)
+      : spec(spec), zipf(spec.dist == XKeyDist::Zipfian ||
+                                 spec.dist == XKeyDist::Latest
+                             ? spec.keys
+                             : 1,
+                         spec.theta),
+        latestHead(spec.keys) {
+    if (spec.keys == 0)
+      throw std::invalid_argument("workload key space must not be empty");
+    hotKeys = std::max<uint64_t>(
+        1, std::min<uint64_t>(spec.keys,
+                              std::llround(spec.keys * spec.hotFraction)));
+  }
+
+  uint64_t next(std::mt19937_64 &rng) {
+    switch (spec.dist) {
+    case XKeyDist::Uniform:
+      return spec.base + detail::uniformBelow(rng, spec.keys);
+    case XKeyDist::Zipfian: {
+      uint64_t rank = zipf.next(rng);
+      return spec.base +
+             (spec.scrambled ? detail::scramble(rank) % spec.keys : rank);
+    }
+    case XKeyDist::Latest:
+      if (detail::uniformReal(rng) < spec.insertRatio)
+        return spec.base + latestHead++;
+      return spec.base + latestHead - 1 -
+             std::min(zipf.next(rng), latestHead - 1);
+    case XKeyDist::Hotspot:
+      if (hotKeys == spec.keys ||
+          detail::uniformReal(rng) < spec.hotOpFraction)
+        return spec.base + detail::uniformBelow(rng, hotKeys);
+      return spec.base + hotKeys +
+             detail::uniformBelow(rng, spec.keys - hotKeys);
+    case XKeyDist::Sequential:
+      return spec.base + position++;
+    case XKeyDist::Loop:
+      return spec.base + position++ % spec.keys;
+    }
+    return spec.base;
+  }
+
+private:
+  XKeySpec spec;
+  XZipfian zipf;
+  uint64_t latestHead;
+  uint64_t hotKeys = 1;
+  uint64_t position = 0;
+};
+
+// 工作负载的一个阶段：若干key分布按权重混合，外加读比例
+struct XWorkloadPhase {
+  std::vector<std::pair<double, XKeySpec>> mix; // (权重, 分布)
+  size_t length = 0;
+  double readRatio = 1.0;
+
+  XWorkloadPhase() = default;
+  XWorkloadPhase(const XKeySpec &spec, size_t length, double readRatio = 1.0)
+      : mix{{1.0, spec}}, length(length), readRatio(readRatio) {}
+  XWorkloadPhase(std::vector<std::pair<double, XKeySpec>> mix, size_t length,
+                 double readRatio = 1.0)
+      : mix(std::move(mix)), length(length), readRatio(readRatio) {}
+};
+
+// 预先生成的操作序列
+struct XOpStream {
+  std::vector<uint64_t> keys;
+  std::vector<uint8_t> reads; // 1为get，0为put
+
+  size_t size() const { return keys.size(); }
+};
+
+// 按阶段顺序生成操作序列，同一种子总是得到同一序列
+inline XOpStream makeOpStream(const std::vector<XWorkloadPhase> &phases,
+                              uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  XOpStream stream;
+  size_t total = 0;
+  for (const XWorkloadPhase &phase : phases)
+    total += phase.length;
+  stream.keys.reserve(total);
+  stream.reads.reserve(total);
+
+  for (const XWorkloadPhase &phase : phases) {
+    if (phase.mix.empty())
+      throw std::invalid_argument("workload phase has no key distribution");
+    std::vector<XKeyGenerator> generators;
+    std::vector<double> cumulative;
+    double weight = 0;
+    for (const auto &part : phase.mix) {
+      generators.emplace_back(part.second);
+      weight += part.first;
+      cumulative.push_back(weight);
+    }
+    for (size_t i = 0; i < phase.length; ++i) {
+      size_t which = 0;
+      if (generators.size() > 1) {
+        double r = detail::uniformReal(rng) * weight;
+        which = std::upper_bound(cumulative.begin(), cumulative.end(), r) -
+                cumulative.begin();
+        which = std::min(which, generators.size() - 1);
+      }
+      stream.keys.push_back(generators[which].next(rng));
+      stream.reads.push_back(detail::uniformReal(rng) < phase.readRatio);
+    }
+  }
+  return stream;
+}
+
+// 只要key序列的便捷版本
+inline std::vector<uint64_t> makeKeyStream(const XKeySpec &spec, size_t length,
+                                           uint64_t seed) {
+  return makeOpStream({XWorkloadPhase(spec, length)}, seed).keys;
+}
+
+// 按名称构造分布：uniform | zipf | zipf-ordered | latest | hotspot | sequential | loop
+inline XKeySpec parseKeySpec(const std::string &name, uint64_t keys,
+                             double theta = 0.99) {
+  if (name == "uniform")
+    return XKeySpec::uniform(keys);
+  if (name == "zipf")
+    return XKeySpec::zipfian(keys, theta);
+  if (name == "zipf-ordered")
+    return XKeySpec::zipfian(keys, theta, false);
+  if (name == "latest")
+    return XKeySpec::latest(keys, theta);
+  if (name == "hotspot")
+    return XKeySpec::hotspot(keys);
+  if (name == "sequential")
+    return XKeySpec::sequential();
+  if (name == "loop")
+    return XKeySpec::loop(keys);
+  throw std::invalid_argument("unknown key distribution: " + name);
+}
+
+// 逗号分隔的多个分布名表示分阶段负载：每个分布一段，均分length
+inline std::vector<XWorkloadPhase>
+parseWorkload(const std::string &names, uint64_t keys, size_t length,
+              double readRatio, double theta = 0.99) {
+  std::vector<XKeySpec> specs;
+  std::stringstream ss(names);
+  std::string name;
+  while (std::getline(ss, name, ',')) {
+    if (!name.empty())
+      specs.push_back(parseKeySpec(name, keys, theta));
+  }
+  if (specs.empty())
+    throw std::invalid_argument("empty workload: " + names);
+  std::vector<XWorkloadPhase> phases;
+  for (size_t i = 0; i < specs.size(); ++i) {
+    size_t begin = length * i / specs.size();
+    size_t end = length * (i + 1) / specs.size();
+    phases.emplace_back(specs[i], end - begin, readRatio);
+  }
+  return phases;
+}
+} // namespace XCache
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// 基准测试公共工具：线程绑核、统计与置信区间（key分布见XWorkload.h）
+namespace XBench {
+// 把当前线程绑定到第index个CPU（按CPU数取模）
+inline void pinCurrentThread(size_t index) {
+  unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % cpus, &set);
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+}
+
+// 样本均值与95%置信区间半宽（t分布）
+struct SampleStats {
+  double mean = 0;
+  double stddev = 0;
+  double ci95 = 0;
+  size_t count = 0;
+};
+
+inline SampleStats summarize(const std::vector<double> &samples) {
+  static const double kT95[] = {0,     12.706, 4.303, 3.182, 2.776, 2.571,
+                                2.447, 2.365,  2.306, 2.262, 2.228, 2.201,
+                                2.179, 2.160,  2.145, 2.131, 2.120, 2.110,
+                                2.101, 2.093,  2.086, 2.080, 2.074, 2.069,
+                                2.064, 2.060,  2.056, 2.052, 2.048, 2.045,
+                                2.042};
+  SampleStats stats;
+  stats.count = samples.size();
+  if (samples.empty())
+    return stats;
+  for (double s : samples)
+    stats.mean += s;
+  stats.mean /= samples.size();
+  if (samples.size() < 2)
+    return stats;
+  double var = 0;
+  for (double s : samples)
+    var += (s - stats.mean) * (s - stats.mean);
+  stats.stddev = std::sqrt(var / (samples.size() - 1));
+  size_t df = samples.size() - 1;
+  double t = df < sizeof(kT95) / sizeof(kT95[0]) ? kT95[df] : 1.96;
+  stats.ci95 = t * stats.stddev / std::sqrt(double(samples.size()));
+  return stats;
+}
+} // namespace XBench
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// 基于perf_event_open的硬件计数器。每个事件单独打开，某个事件不可用（虚拟机、
+// perf_event_paranoid限制、CPU不支持）时只影响该事件，其余照常计数
+namespace XBench {
+enum PerfEvent {
+  kInstructions,
+  kCycles,
+  kLLCMisses,
+  kDTLBMisses,
+  kBranchMisses,
+  kPerfEventCount,
+};
+
+inline const char *perfEventName(int event) {
+  static const char *const names[kPerfEventCount] = {
+      "instructions", "cycles", "llc_misses", "dtlb_misses", "branch_misses"};
+  return names[event];
+}
+
+// 各事件的计数（已按多路复用比例换算），valid为false表示该事件不可用
+struct PerfSample {
+  std::array<double, kPerfEventCount> values{};
+  std::array<bool, kPerfEventCount> valid{};
+
+  bool any() const {
+    for (bool v : valid) {
+      if (v)
+        return true;
+    }
+    return false;
+  }
+
+  void merge(const PerfSample &other) {
+    for (int i = 0; i < kPerfEventCount; ++i) {
+      if (!other.valid[i])
+        continue;
+      values[i] += other.values[i];
+      valid[i] = true;
+    }
+  }
+};
+
+// 统计调用线程（用户态）的计数器，需在被测线程内构造与使用
+class PerfCounters {
+public:
+  PerfCounters() {
+    for (int i = 0; i < kPerfEventCount; ++i)
+      fds[i] = open(i);
+  }
+
+  ~PerfCounters() {
+    for (int fd : fds) {
+      if (fd >= 0)
+        ::close(fd);
+    }
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  void start() {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  void stop() {
+    for (int fd : fds) {
+      if (fd >= 0)
+        ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  PerfSample read() const {
+    PerfSample sample;
+    for (int i = 0; i < kPerfEventCount; ++i) {
+      uint64_t data[3]; // value, time_enabled, time_running
+      if (fds[i] < 0 || ::read(fds[i], data, sizeof(data)) != sizeof(data))
+        continue;
+      if (data[2] == 0)
+        continue; // 从未被调度到PMU上
+      sample.values[i] = double(data[0]) * double(data[1]) / double(data[2]);
+      sample.valid[i] = true;
+    }
+    return sample;
+  }
+
+  // 当前环境下是否至少有一个事件可用
+  static bool available() {
+    PerfCounters probe;
+    for (int fd : probe.fds) {
+      if (fd >= 0)
+        return true;
+    }
+    return false;
+  }
+
+private:
+  static int open(int event) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; // paranoid=2时也能打开
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+    case kInstructions:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case kCycles:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case kLLCMisses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_LL |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case kDTLBMisses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case kBranchMisses:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    default:
+      return -1;
+    }
+    return static_cast<int>(
+        ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+  }
+
+  std::array<int, kPerfEventCount> fds{};
+};
+} // namespace XBench
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../XLFUCache.h"
+#include "../XLRUCache.h"
+#include "../XPolicyCache.h"
+#include "../XStaticCache.h"
+#include "XBenchUtil.h"
+
+// 虚调用开销基准：同一个引擎分别经XCachePolicy指针（虚调用）和XStaticCache（静态分派）
+// 执行全命中的get，报告每次操作的纳秒数。容量小到能放进缓存，测的是调用路径而不是访存。
+// 用法：bench_dispatch [ops=4000000] [capacity=1024] [reps=10]
+using Key = uint64_t;
+using Value = uint64_t;
+using Policy = XCache::XCachePolicy<Key, Value>;
+
+namespace {
+// 读出的值写到这里，防止循环被优化掉
+volatile uint64_t gSink;
+
+// 不内联，编译器看不到指针的动态类型，无法把虚调用去虚化
+template <typename Engine>
+__attribute__((noinline)) std::unique_ptr<Policy> makeVirtual(size_t capacity) {
+  if constexpr (std::is_base_of_v<Policy, Engine>)
+    return std::make_unique<Engine>(static_cast<int>(capacity));
+  else
+    return XCache::makeCachePolicyAdapter<Key, Value, Engine>(capacity);
+}
+
+template <typename Cache>
+double runGets(Cache &cache, const std::vector<Key> &keys, uint64_t &sink) {
+  auto begin = std::chrono::steady_clock::now();
+  Value value = 0;
+  for (Key key : keys) {
+    cache.get(key, value);
+    sink += value;
+  }
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - begin)
+             .count() /
+         keys.size();
+}
+
+template <typename Engine>
+void compare(const char *name, size_t capacity, const std::vector<Key> &keys,
+             int reps) {
+  auto virtualCache = makeVirtual<Engine>(capacity);
+  XCache::XStaticCache<Key, Value, Engine> staticCache(capacity);
+  for (Key key = 0; key < capacity; ++key) {
+    virtualCache->put(key, key);
+    staticCache.put(key, key);
+  }
+
+  // 两种形式交替运行，频率漂移对二者的影响相同
+  uint64_t sink = 0;
+  std::vector<double> virtualNs, staticNs;
+  runGets(*virtualCache, keys, sink);
+  runGets(staticCache, keys, sink);
+  for (int rep = 0; rep < reps; ++rep) {
+    virtualNs.push_back(runGets(*virtualCache, keys, sink));
+    staticNs.push_back(runGets(staticCache, keys, sink));
+  }
+
+  auto v = XBench::summarize(virtualNs);
+  auto s = XBench::summarize(staticNs);
+  std::cout << std::left << std::setw(20) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(8) << v.mean << " ±"
+            << std::setw(5) << v.ci95 << std::setw(10) << s.mean << " ±"
+            << std::setw(5) << s.ci95 << std::setw(10) << v.mean - s.mean
+            << std::setw(9) << std::setprecision(1)
+            << (v.mean > 0 ? (v.mean - s.mean) / v.mean * 100 : 0) << "%"
+            << std::endl;
+  gSink = sink;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const size_t OPS = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+  const size_t CAPACITY =
+      std::max<size_t>(1, argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1024);
+  const int REPS = argc > 3 ? std::max(1, std::atoi(argv[3])) : 10;
+
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<Key> dist(0, CAPACITY - 1);
+  std::vector<Key> keys(OPS);
+  for (Key &key : keys)
+    key = dist(rng);
+
+  std::cout << std::left << std::setw(20) << "engine" << std::right
+            << std::setw(15) << "virtual ns/op" << std::setw(16)
+            << "static ns/op" << std::setw(10) << "saved" << std::setw(10)
+            << "saved%" << std::endl;
+  compare<XCache::XLRUCache<Key, Value>>("lru", CAPACITY, keys, REPS);
+  compare<XCache::XLFUCache<Key, Value>>("lfu", CAPACITY, keys, REPS);
+  compare<XCache::XPolicyLRUCache<Key, Value>>("policy-lru", CAPACITY, keys,
+                                               REPS);
+  compare<XCache::XPolicyCache<Key, Value, XCache::XHashIndex,
+                               XCache::XLruEviction, XCache::XAlwaysAdmit,
+                               XCache::XNoLocking>>("policy-lru-nolock",
+                                                    CAPACITY, keys, REPS);
+  return 0;
+}
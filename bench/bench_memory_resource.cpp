@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "../XCacheFactory.h"
+#include "../XMemoryResource.h"
+#include "../XPolicyCache.h"
+#include "../XStaticCache.h"
+#include "../XWorkload.h"
+
+// 内存来源对比：每个引擎分别从全局堆、unsynchronized/synchronized_pool_resource和
+// monotonic_buffer_resource分配，单线程跑同一条Zipf访问序列（未命中时写入），
+// 报告吞吐、向系统申请的峰值内存，以及销毁缓存并释放resource的耗时。
+// monotonic不回收淘汰的节点，峰值随淘汰次数增长，适合生命周期短、整体丢弃的缓存。
+// 用法：bench_memory_resource [ops=500000] [capacity=10000] [keys=100000]
+using Key = uint64_t;
+using Value = uint64_t;
+using Policy = XCache::XCachePolicy<Key, Value>;
+
+namespace {
+std::unique_ptr<Policy> makeEngine(const std::string &name, size_t capacity,
+                                   std::pmr::memory_resource *resource) {
+  if (name == "policy-lru")
+    return XCache::makeCachePolicyAdapter<Key, Value,
+                                          XCache::XPolicyLRUCache<Key, Value>>(
+        capacity, resource);
+  return XCache::makeCachePolicy<Key, Value>(name, capacity, resource);
+}
+
+std::unique_ptr<std::pmr::memory_resource>
+makeResource(const std::string &kind, std::pmr::memory_resource *upstream) {
+  if (kind == "unsync-pool")
+    return std::make_unique<std::pmr::unsynchronized_pool_resource>(upstream);
+  if (kind == "sync-pool")
+    return std::make_unique<std::pmr::synchronized_pool_resource>(upstream);
+  if (kind == "monotonic")
+    return std::make_unique<std::pmr::monotonic_buffer_resource>(upstream);
+  return nullptr; // heap：引擎直接使用upstream
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - begin)
+      .count();
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const size_t OPS = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+  const size_t CAPACITY =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000;
+  const uint64_t KEYS = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100000;
+
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(KEYS, 0.99), OPS)}, 1);
+
+  std::vector<std::string> engines = XCache::cachePolicyNames();
+  engines.push_back("policy-lru");
+  const std::vector<std::string> kinds = {"heap", "unsync-pool", "sync-pool",
+                                          "monotonic"};
+
+  std::cout << std::left << std::setw(12) << "engine" << std::setw(13)
+            << "resource" << std::right << std::setw(10) << "Mops/s"
+            << std::setw(12) << "peak MiB" << std::setw(14) << "teardown ms"
+            << std::endl;
+  for (const std::string &engine : engines) {
+    for (const std::string &kind : kinds) {
+      // 计数放在最底层，统计的是resource向系统申请的内存
+      XCache::XCountingResource counting(std::pmr::new_delete_resource());
+      auto resource = makeResource(kind, &counting);
+      auto cache =
+          makeEngine(engine, CAPACITY, resource ? resource.get() : &counting);
+
+      auto begin = std::chrono::steady_clock::now();
+      Value value;
+      for (Key key : stream.keys) {
+        if (!cache->get(key, value))
+          cache->put(key, key);
+      }
+      double runMs = elapsedMs(begin);
+
+      begin = std::chrono::steady_clock::now();
+      cache.reset();
+      resource.reset();
+      double teardownMs = elapsedMs(begin);
+
+      std::cout << std::left << std::setw(12) << engine << std::setw(13) << kind
+                << std::right << std::fixed << std::setprecision(2)
+                << std::setw(10) << (runMs > 0 ? OPS / runMs / 1000.0 : 0)
+                << std::setw(12) << counting.getPeakBytes() / 1048576.0
+                << std::setw(14) << teardownMs << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "../XCacheFactory.h"
+#include "../XMemoryResource.h"
+#include "../XNegativeCache.h"
+#include "../XWorkload.h"
+
+// 负缓存收益：Zipf访问中一部分key在后端不存在，统计XLoadingCache省掉的后端访问、
+// 被误判为不存在的已有key，以及过滤器为每个不存在key占用的内存；
+// 作为对比，给出用哨兵值把不存在的key缓存成完整LRU条目时每个条目的内存。
+// 用法：bench_negative_cache [ops=2000000] [capacity=10000] [keys=1000000]
+//       [absent%=40] [keysPerGeneration=100000] [falsePositiveRate=0.001]
+using Key = uint64_t;
+using Value = uint64_t;
+
+namespace {
+// 按key哈希决定后端是否存在，与Zipf的热度无关
+bool existsInBackend(Key key, unsigned absentPercent) {
+  uint64_t x = (key + 0x9E3779B97F4A7C15ull) * 0xBF58476D1CE4E5B9ull;
+  return (x >> 32) % 100 >= absentPercent;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const size_t OPS = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  const size_t CAPACITY =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000;
+  const uint64_t KEYS =
+      argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+  const unsigned ABSENT = argc > 4 ? std::atoi(argv[4]) : 40;
+  XCache::XNegativeCacheOptions options;
+  options.keysPerGeneration =
+      argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 100000;
+  options.falsePositiveRate = argc > 6 ? std::atof(argv[6]) : 0.001;
+
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(KEYS, 0.99), OPS)}, 1);
+
+  XCache::XLoadingCache<Key, Value> cache(
+      XCache::makeCachePolicy<Key, Value>("lru", CAPACITY),
+      [&](const Key &key, Value &value) {
+        if (!existsInBackend(key, ABSENT))
+          return false;
+        value = key;
+        return true;
+      },
+      options);
+
+  size_t absentLookups = 0, wrongAbsent = 0;
+  Value value;
+  for (Key key : stream.keys) {
+    bool exists = existsInBackend(key, ABSENT);
+    absentLookups += !exists;
+    if (!cache.get(key, value) && exists)
+      wrongAbsent++;
+  }
+
+  XCache::XLoadingStats stats = cache.getStats();
+  uint64_t withoutFilter = stats.loads + stats.negativeHits;
+  const auto &filter = cache.getFilter();
+  double bytesPerKey =
+      filter.memoryBytes() / (2.0 * std::max<size_t>(options.keysPerGeneration, 1));
+
+  // 哨兵方案：同样大小的LRU中每个条目（节点+哈希表）占用的内存
+  XCache::XCountingResource counting;
+  {
+    XCache::XLRUCache<Key, Value> sentinel(CAPACITY, &counting);
+    for (Key key = 0; key < CAPACITY; ++key)
+      sentinel.put(key, 0);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "sentinel entry bytes  "
+              << counting.getBytesInUse() / static_cast<double>(CAPACITY)
+              << std::endl;
+  }
+
+  std::cout << "lookups               " << OPS << std::endl;
+  std::cout << "absent lookups        " << absentLookups << " ("
+            << 100.0 * absentLookups / OPS << "%)" << std::endl;
+  std::cout << "backend calls         " << stats.loads << " (without filter "
+            << withoutFilter << ")" << std::endl;
+  std::cout << "backend calls avoided " << stats.negativeHits << " ("
+            << (withoutFilter ? 100.0 * stats.negativeHits / withoutFilter : 0)
+            << "%)" << std::endl;
+  std::cout << "wrongly absent        " << wrongAbsent << std::endl;
+  std::cout << "filter bytes          " << filter.memoryBytes() << " ("
+            << filter.hashCount() << " hashes)" << std::endl;
+  std::cout << "bytes per absent key  " << bytesPerKey << std::endl;
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../XCacheFactory.h"
+#include "../XPolicyCache.h"
+#include "../XStaticCache.h"
+#include "../XWorkload.h"
+#include "XPerfCounters.h"
+
+// 节点布局基准：value较大时，比较各引擎淘汰与提升的访存开销。
+// Zipf访问的key空间为容量的4倍，未命中时put，淘汰与链表调整频繁；
+// 每个引擎重复reps轮取最快的一轮，报告每次操作的纳秒数，硬件计数器可用时另报该轮每次操作的LLC/dTLB失效次数。
+// policy-lru/policy-lfu为XPolicyCache，超过一条缓存行的value放在条目之外（见XValueSlot）。
+// ARC的LFU部分按频率分桶的std::list删除是线性的，默认不参加。
+// 用法：bench_node_layout [ops=2000000] [capacity=100000] [reps=5] [policy=all]
+using Key = uint64_t;
+using Value = std::array<char, 256>;
+
+namespace {
+volatile char gSink;
+
+std::unique_ptr<XCache::XCachePolicy<Key, Value>>
+makeCache(const std::string &policy, size_t capacity) {
+  if (policy == "policy-lru")
+    return XCache::makeCachePolicyAdapter<Key, Value,
+                                          XCache::XPolicyLRUCache<Key, Value>>(
+        capacity);
+  if (policy == "policy-lfu")
+    return XCache::makeCachePolicyAdapter<Key, Value,
+                                          XCache::XPolicyLFUCache<Key, Value>>(
+        capacity);
+  return XCache::makeCachePolicy<Key, Value>(policy, capacity);
+}
+
+struct Round {
+  double ns = 0;
+  double hitRate = 0;
+  XBench::PerfSample perf;
+};
+
+Round runOnce(const std::string &policy, size_t capacity,
+              const XCache::XOpStream &stream) {
+  auto cache = makeCache(policy, capacity);
+  Value value{};
+  // 预热：先填满并让节点在堆上打散
+  for (size_t i = 0; i < stream.keys.size() / 4; ++i) {
+    Key key = stream.keys[i];
+    if (!cache->get(key, value))
+      cache->put(key, value);
+  }
+
+  XBench::PerfCounters counters;
+  uint64_t hits = 0;
+  auto begin = std::chrono::steady_clock::now();
+  counters.start();
+  for (Key key : stream.keys) {
+    if (cache->get(key, value)) {
+      hits++;
+      gSink = value[0];
+    } else {
+      value[0] = static_cast<char>(key);
+      cache->put(key, value);
+    }
+  }
+  counters.stop();
+  double ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - begin)
+                  .count() /
+              stream.keys.size();
+  return Round{ns, 100.0 * hits / stream.keys.size(), counters.read()};
+}
+
+void run(const std::string &policy, size_t capacity,
+         const XCache::XOpStream &stream, int reps) {
+  Round best;
+  for (int i = 0; i < reps; ++i) {
+    Round round = runOnce(policy, capacity, stream);
+    if (i == 0 || round.ns < best.ns)
+      best = round;
+  }
+  std::cout << std::left << std::setw(10) << policy << std::right
+            << std::setw(10) << best.ns << std::setw(9) << best.hitRate;
+  for (int event : {XBench::kLLCMisses, XBench::kDTLBMisses}) {
+    if (best.perf.valid[event])
+      std::cout << std::setw(14) << best.perf.values[event] / stream.keys.size();
+    else
+      std::cout << std::setw(14) << "n/a";
+  }
+  std::cout << std::endl;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const size_t OPS = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  const size_t CAPACITY =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+  const int REPS = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+  const std::string POLICY = argc > 4 ? argv[4] : "all";
+
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(CAPACITY * 4, 0.9),
+                              OPS)},
+      1);
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "policy       ns/op   hit%   llc_miss/op  dtlb_miss/op"
+            << std::endl;
+  std::vector<std::string> policies = XCache::cachePolicyNames();
+  policies.push_back("policy-lru");
+  policies.push_back("policy-lfu");
+  for (const std::string &policy : policies) {
+    if (POLICY == policy || (POLICY == "all" && policy != "arc"))
+      run(policy, CAPACITY, stream, REPS);
+  }
+  if (!XBench::PerfCounters::available())
+    std::cout << "(perf_event_open不可用，只报告耗时)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "../XPersist/XPersistentCache.h"
+
+// 恢复时间基准：写入N条记录后重启，分别度量“纯日志回放”和“检查点+日志尾部”的恢复耗时
+// 用法：bench_recovery [entries=10000000] [valueSize=32] [dir=/tmp/xcache_recovery]
+int main(int argc, char **argv) {
+  const size_t ENTRIES = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  const size_t VALUE_SIZE = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 32;
+  const std::string DIR = argc > 3 ? argv[3] : "/tmp/xcache_recovery";
+
+  using Cache = XCache::XPersistentCache<uint64_t, std::string>;
+  using Engine = XCache::XLRUCache<uint64_t, std::string>;
+
+  XCache::XLogOptions options;
+  options.durability = XCache::XDurability::Async;
+  options.segmentBytes = 256u << 20;
+  options.compactSegments = 1u << 30; // 基准中只在显式调用时生成检查点
+
+  auto open = [&] {
+    return std::make_unique<Cache>(
+        DIR, std::make_unique<Engine>(static_cast<int>(ENTRIES)), options);
+  };
+  auto report = [&](const char *name, const XCache::XRecoveryStats &stats) {
+    double total = double(stats.checkpointEntries + stats.logRecords);
+    std::cout << std::left << std::setw(24) << name << std::fixed
+              << std::setprecision(1) << stats.elapsedMs << " ms, "
+              << stats.checkpointEntries << " checkpoint entries + "
+              << stats.logRecords << " log records, "
+              << std::setprecision(2)
+              << (stats.elapsedMs > 0 ? total / stats.elapsedMs / 1000.0 : 0)
+              << " M entries/s, " << (stats.bytesReplayed >> 20) << " MiB"
+              << std::endl;
+  };
+
+  std::filesystem::remove_all(DIR);
+  std::string value(VALUE_SIZE, 'x');
+  {
+    auto cache = open();
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < ENTRIES; ++i) {
+      cache->put(i, value);
+    }
+    cache->sync();
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - begin)
+                    .count();
+    std::cout << "写入 " << ENTRIES << " 条记录: " << std::fixed
+              << std::setprecision(1) << ms << " ms" << std::endl;
+  }
+  {
+    auto cache = open();
+    report("日志回放", cache->getRecoveryStats());
+    cache->checkpoint();
+  }
+  {
+    auto cache = open();
+    report("检查点+日志尾部", cache->getRecoveryStats());
+  }
+  std::filesystem::remove_all(DIR);
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "../server/XCacheServer.h"
+#include "../server/XLoadGen.h"
+
+// 事件循环后端对比：同一进程内分别以epoll与io_uring启动服务，用回环压测客户端度量
+// 吞吐量与每批请求的p99延迟。连接数越多、流水线越浅，每请求的系统调用开销占比越高
+// 用法：bench_server_backends [connections=256] [pipeline=1] [seconds=3]
+//                             [serverThreads=2] [protocol=memcache]
+int main(int argc, char **argv) {
+  const size_t CONNECTIONS = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+  const size_t PIPELINE = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+  const double SECONDS = argc > 3 ? std::strtod(argv[3], nullptr) : 3;
+  const size_t SERVER_THREADS = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 2;
+  const std::string PROTOCOL = argc > 5 ? argv[5] : "memcache";
+  const size_t CLIENT_THREADS = 4;
+
+  std::cout << "connections=" << CONNECTIONS << " pipeline=" << PIPELINE
+            << " serverThreads=" << SERVER_THREADS << " protocol=" << PROTOCOL
+            << std::endl;
+  for (const char *backend : {"epoll", "io_uring"}) {
+    XCache::XServerOptions options;
+    options.host = "127.0.0.1";
+    options.port = 0;
+    options.threads = SERVER_THREADS;
+    options.protocol = PROTOCOL;
+    options.backend = backend;
+    options.capacity = 1000000;
+    XCache::XCacheServer server(options);
+    if (server.getBackend() != backend) {
+      std::cout << std::left << std::setw(10) << backend
+                << "不可用（内核不支持）" << std::endl;
+      continue;
+    }
+    server.start();
+
+    XCache::XLoadOptions load;
+    load.port = server.getPort();
+    load.protocol = PROTOCOL;
+    load.threads = CLIENT_THREADS;
+    load.connections = std::max<size_t>(1, CONNECTIONS / CLIENT_THREADS);
+    load.pipeline = PIPELINE;
+    load.seconds = SECONDS;
+    load.keys = 100000;
+    XCache::XLoadResult result = XCache::runLoad(load);
+    server.stop();
+
+    std::cout << std::left << std::setw(10) << backend << std::fixed
+              << std::setprecision(0) << result.requestsPerSec << " req/s, p50 "
+              << std::setprecision(1) << result.p50Us << " us, p99 "
+              << result.p99Us << " us, max " << result.maxUs << " us"
+              << std::endl;
+  }
+  return 0;
+}
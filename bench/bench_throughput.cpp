@@ -0,0 +1,515 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../XCacheFactory.h"
+#include "../XHistogram.h"
+#include "../XPolicyCache.h"
+#include "../XStaticCache.h"
+#include "../XTracer.h"
+#include "../XWorkload.h"
+#include "../sim/XTraceRecorder.h"
+#include "XBenchUtil.h"
+#include "XPerfCounters.h"
+
+// 多线程吞吐基准：每个引擎（含分片变体）在1/2/4/…/N线程下运行，线程绑核，
+// 预热后重复测量多轮，报告Mops/s均值与95%置信区间；--latency时另外按get/put分别统计
+// 每次操作的延迟分布（p50/p99/p99.9/max），LFU老化、sketch衰减等造成的停顿会体现在尾部；
+// --perf时用硬件计数器报告每次操作的指令数、周期数、LLC/dTLB/分支预测失效次数；
+// --tracer usdt换成带USDT探针的引擎，与默认的空Tracer对比即为探针本身的开销
+using Key = uint64_t;
+using Value = std::string;
+using Engine = XCache::XCachePolicy<Key, Value>;
+
+// 分片缓存与XPolicyCache没有继承XCachePolicy，用适配器包一层以便和其他引擎走同样的调用路径
+template <typename Concrete>
+using Adapted = XCache::XCachePolicyAdapter<Key, Value, Concrete>;
+
+struct Options {
+  std::vector<std::string> engines;
+  size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  double readRatio = 0.9;
+  std::string dist = "zipf";
+  double theta = 0.99;
+  size_t valueSize = 64;
+  uint64_t keys = 1000000;
+  size_t capacity = 100000;
+  int shards = 0; // 0表示按最大线程数
+  int warmupMs = 500;
+  int durationMs = 1000;
+  int reps = 5;
+  std::string format = "text";
+  bool pin = true;
+  bool latency = false;
+  bool perf = false;
+  std::string tracePath;   // 非空时用XTracedCache包装引擎，度量录制开销
+  std::string tracer = "noop"; // noop | usdt
+  double traceSample = 0.01;
+};
+
+struct Result {
+  std::string engine;
+  size_t threads = 0;
+  XBench::SampleStats mops;
+  XCache::XHistogram getLatency; // 纳秒，仅--latency时记录
+  XCache::XHistogram putLatency;
+  XBench::PerfSample perf; // 各轮各线程之和，仅--perf时记录
+  uint64_t perfOps = 0;
+};
+
+template <typename Tracer>
+static std::unique_ptr<Engine> makeTracedEngine(const std::string &name,
+                                                const Options &options) {
+  int shards = options.shards > 0 ? options.shards
+                                  : static_cast<int>(options.maxThreads);
+  if (name == "hash-lru")
+    return std::make_unique<
+        Adapted<XCache::XHashLRUCaches<Key, Value, Tracer>>>(
+        static_cast<int>(options.capacity), shards);
+  if (name == "hash-lfu")
+    return std::make_unique<
+        Adapted<XCache::XHashLFUCache<Key, Value, Tracer>>>(
+        options.capacity, shards);
+  if (name == "policy-lru")
+    return std::make_unique<Adapted<XCache::XPolicyLRUCache<Key, Value>>>(
+        options.capacity);
+  if (name == "policy-lfu")
+    return std::make_unique<Adapted<XCache::XPolicyLFUCache<Key, Value>>>(
+        options.capacity);
+  if (name == "policy-tinylfu")
+    return std::make_unique<
+        Adapted<XCache::XPolicyTinyLFUCache<Key, Value>>>(
+        options.capacity);
+  return XCache::makeCachePolicy<Key, Value, Tracer>(name, options.capacity);
+}
+
+static std::unique_ptr<Engine> makeEngine(const std::string &name,
+                                          const Options &options) {
+  if (options.tracer == "usdt")
+    return makeTracedEngine<XCache::XUsdtTracer>(name, options);
+  return makeTracedEngine<XCache::XNoopTracer>(name, options);
+}
+
+using OpStream = XCache::XOpStream;
+
+// 每个线程独立的预生成操作流（种子不同），测量循环中只做查表
+static std::vector<OpStream> makeStreams(const Options &options) {
+  const size_t LENGTH = 1u << 20;
+  std::vector<OpStream> streams;
+  for (size_t t = 0; t < options.maxThreads; ++t)
+    streams.push_back(XCache::makeOpStream(
+        XCache::parseWorkload(options.dist, options.keys, LENGTH,
+                              options.readRatio, options.theta),
+        1000 + t));
+  return streams;
+}
+
+// 测量循环；Latency为true时逐个操作计时并记录到直方图
+template <bool Latency>
+static uint64_t runOps(Engine &engine, const OpStream &stream, size_t start,
+                       const Value &value, const std::atomic<bool> &stop,
+                       XCache::XHistogram &getLatency,
+                       XCache::XHistogram &putLatency) {
+  using Clock = std::chrono::steady_clock;
+  const size_t MASK = stream.keys.size() - 1;
+  size_t i = start & MASK;
+  uint64_t done = 0;
+  Value out;
+  while (!stop.load(std::memory_order_relaxed)) {
+    for (int batch = 0; batch < 64; ++batch, i = (i + 1) & MASK) {
+      Clock::time_point begin;
+      if (Latency)
+        begin = Clock::now();
+      bool read = stream.reads[i];
+      if (read)
+        engine.get(stream.keys[i], out);
+      else
+        engine.put(stream.keys[i], value);
+      if (Latency) {
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Clock::now() - begin)
+                          .count();
+        (read ? getLatency : putLatency).record(ns);
+      }
+    }
+    done += 64;
+  }
+  return done;
+}
+
+// 以threads个线程运行ms毫秒，返回Mops/s；直方图非空时合并各线程的延迟分布，
+// result非空时累加各线程的硬件计数
+static double runPhase(Engine &engine, const std::vector<OpStream> &streams,
+                       size_t threads, int ms, const Options &options,
+                       XCache::XHistogram *getLatency = nullptr,
+                       XCache::XHistogram *putLatency = nullptr,
+                       Result *result = nullptr) {
+  std::atomic<size_t> ready{0};
+  std::atomic<bool> go{false};
+  std::atomic<bool> stop{false};
+  std::vector<uint64_t> ops(threads, 0);
+  // 每个线程一份直方图，记录时无需同步
+  std::vector<XCache::XHistogram> gets(getLatency ? threads : 0);
+  std::vector<XCache::XHistogram> puts(putLatency ? threads : 0);
+  std::vector<XBench::PerfSample> perf(threads);
+  std::vector<std::thread> workers;
+  const Value VALUE(options.valueSize, 'x');
+
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      if (options.pin)
+        XBench::pinCurrentThread(t);
+      // 各线程从不同位置开始，避免同一时刻访问相同的key
+      size_t start = t * 7919;
+      std::unique_ptr<XBench::PerfCounters> counters;
+      if (result)
+        counters = std::make_unique<XBench::PerfCounters>();
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      if (counters)
+        counters->start();
+      if (getLatency)
+        ops[t] = runOps<true>(engine, streams[t], start, VALUE, stop, gets[t],
+                              puts[t]);
+      else {
+        XCache::XHistogram unused;
+        ops[t] = runOps<false>(engine, streams[t], start, VALUE, stop, unused,
+                               unused);
+      }
+      if (counters) {
+        counters->stop();
+        perf[t] = counters->read();
+      }
+    });
+  }
+  while (ready.load() < threads)
+    std::this_thread::yield();
+  auto begin = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  stop.store(true);
+  for (auto &w : workers)
+    w.join();
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+          .count();
+  uint64_t total = 0;
+  for (uint64_t n : ops)
+    total += n;
+  for (size_t t = 0; t < gets.size(); ++t) {
+    getLatency->merge(gets[t]);
+    putLatency->merge(puts[t]);
+  }
+  if (result) {
+    for (const XBench::PerfSample &sample : perf)
+      result->perf.merge(sample);
+    result->perfOps += total;
+  }
+  return seconds > 0 ? total / seconds / 1e6 : 0;
+}
+
+static Result benchmark(const std::string &name, size_t threads,
+                        const std::vector<OpStream> &streams,
+                        const Options &options) {
+  std::unique_ptr<Engine> engine = makeEngine(name, options);
+  std::shared_ptr<XCache::XTraceRecorder> recorder;
+  if (!options.tracePath.empty()) {
+    XCache::XTraceRecorderOptions traceOptions;
+    traceOptions.sampleRate = options.traceSample;
+    recorder = std::make_shared<XCache::XTraceRecorder>(options.tracePath,
+                                                        traceOptions);
+    engine = std::make_unique<XCache::XTracedCache<Key, Value>>(
+        std::move(engine), recorder);
+  }
+  // 预填充到容量上限，读操作从一开始就能命中
+  const Value VALUE(options.valueSize, 'x');
+  for (uint64_t k = 0; k < std::min<uint64_t>(options.capacity, options.keys); ++k)
+    engine->put(k, VALUE);
+  if (options.warmupMs > 0)
+    runPhase(*engine, streams, threads, options.warmupMs, options);
+
+  Result result;
+  result.engine = name;
+  result.threads = threads;
+  std::vector<double> samples;
+  for (int r = 0; r < options.reps; ++r)
+    samples.push_back(runPhase(
+        *engine, streams, threads, options.durationMs, options,
+        options.latency ? &result.getLatency : nullptr,
+        options.latency ? &result.putLatency : nullptr,
+        options.perf ? &result : nullptr));
+  result.mops = XBench::summarize(samples);
+  return result;
+}
+
+static const double kPercentiles[] = {50, 99, 99.9};
+static const char *const kPercentileNames[] = {"p50", "p99", "p999"};
+static const char *const kPerfShortNames[] = {"instr/op", "cycles/op", "llc/op",
+                                              "dtlb/op", "brmiss/op"};
+
+// 每次操作的计数，事件不可用时返回false
+static bool perfPerOp(const Result &r, int event, double &value) {
+  if (!r.perf.valid[event] || r.perfOps == 0)
+    return false;
+  value = r.perf.values[event] / r.perfOps;
+  return true;
+}
+
+static void printHeader(const Options &options) {
+  if (options.format == "csv") {
+    std::cout << "engine,threads,dist,read_ratio,value_size,keys,capacity,"
+                 "reps,mops_mean,mops_stddev,mops_ci95";
+    if (options.latency) {
+      for (const char *op : {"get", "put"}) {
+        for (const char *name : kPercentileNames)
+          std::cout << ',' << op << '_' << name << "_ns";
+        std::cout << ',' << op << "_max_ns";
+      }
+    }
+    if (options.perf) {
+      for (int i = 0; i < XBench::kPerfEventCount; ++i)
+        std::cout << ',' << XBench::perfEventName(i) << "_per_op";
+    }
+    std::cout << std::endl;
+  } else if (options.format == "json") {
+    std::cout << "[" << std::endl;
+  } else {
+    std::cout << "dist=" << options.dist << " read_ratio=" << options.readRatio
+              << " value_size=" << options.valueSize
+              << " keys=" << options.keys << " capacity=" << options.capacity
+              << " reps=" << options.reps << std::endl;
+    std::cout << std::left << std::setw(16) << "engine" << std::right
+              << std::setw(8) << "threads" << std::setw(12) << "Mops/s"
+              << std::setw(12) << "±95%CI";
+    if (options.latency) {
+      // 延迟单位为纳秒
+      for (const char *op : {"get", "put"}) {
+        for (const char *name : kPercentileNames)
+          std::cout << std::setw(10) << (std::string(op) + "." + name);
+        std::cout << std::setw(10) << (std::string(op) + ".max");
+      }
+    }
+    if (options.perf) {
+      for (const char *name : kPerfShortNames)
+        std::cout << std::setw(11) << name;
+    }
+    std::cout << std::endl;
+  }
+}
+
+static void printResult(const Result &r, const Options &options, bool first) {
+  const XCache::XHistogram *latencies[] = {&r.getLatency, &r.putLatency};
+  if (options.format == "csv") {
+    std::cout << r.engine << ',' << r.threads << ",\"" << options.dist << "\","
+              << options.readRatio << ',' << options.valueSize << ','
+              << options.keys << ',' << options.capacity << ',' << r.mops.count
+              << ',' << r.mops.mean << ',' << r.mops.stddev << ','
+              << r.mops.ci95;
+    if (options.latency) {
+      for (const XCache::XHistogram *h : latencies) {
+        for (double p : kPercentiles)
+          std::cout << ',' << h->percentile(p);
+        std::cout << ',' << h->max();
+      }
+    }
+    if (options.perf) {
+      for (int i = 0; i < XBench::kPerfEventCount; ++i) {
+        double value;
+        std::cout << ',';
+        if (perfPerOp(r, i, value))
+          std::cout << value;
+      }
+    }
+    std::cout << std::endl;
+  } else if (options.format == "json") {
+    std::cout << (first ? "  " : " ,") << "{\"engine\":\"" << r.engine
+              << "\",\"threads\":" << r.threads << ",\"dist\":\""
+              << options.dist << "\",\"read_ratio\":" << options.readRatio
+              << ",\"value_size\":" << options.valueSize
+              << ",\"keys\":" << options.keys
+              << ",\"capacity\":" << options.capacity
+              << ",\"reps\":" << r.mops.count
+              << ",\"mops_mean\":" << r.mops.mean
+              << ",\"mops_stddev\":" << r.mops.stddev
+              << ",\"mops_ci95\":" << r.mops.ci95;
+    if (options.latency) {
+      const char *ops[] = {"get", "put"};
+      for (int i = 0; i < 2; ++i) {
+        std::cout << ",\"" << ops[i] << "_latency_ns\":{\"count\":"
+                  << latencies[i]->count();
+        for (int j = 0; j < 3; ++j)
+          std::cout << ",\"" << kPercentileNames[j]
+                    << "\":" << latencies[i]->percentile(kPercentiles[j]);
+        std::cout << ",\"max\":" << latencies[i]->max() << "}";
+      }
+    }
+    if (options.perf) {
+      for (int i = 0; i < XBench::kPerfEventCount; ++i) {
+        double value;
+        std::cout << ",\"" << XBench::perfEventName(i) << "_per_op\":";
+        if (perfPerOp(r, i, value))
+          std::cout << value;
+        else
+          std::cout << "null";
+      }
+    }
+    std::cout << "}" << std::endl;
+  } else {
+    std::cout << std::left << std::setw(16) << r.engine << std::right
+              << std::setw(8) << r.threads << std::fixed << std::setprecision(3)
+              << std::setw(12) << r.mops.mean << std::setw(12) << r.mops.ci95;
+    if (options.latency) {
+      for (const XCache::XHistogram *h : latencies) {
+        for (double p : kPercentiles)
+          std::cout << std::setw(10) << h->percentile(p);
+        std::cout << std::setw(10) << h->max();
+      }
+    }
+    if (options.perf) {
+      for (int i = 0; i < XBench::kPerfEventCount; ++i) {
+        double value;
+        if (perfPerOp(r, i, value))
+          std::cout << std::setw(11) << value;
+        else
+          std::cout << std::setw(11) << "n/a";
+      }
+    }
+    std::cout << std::endl;
+  }
+}
+
+static void usage(const char *prog) {
+  std::cout
+      << "用法: " << prog << " [选项]\n"
+      << "  --engines <list>      逗号分隔（默认全部策略及hash-lru,hash-lfu），\n"
+      << "                        另有组合式的policy-lru,policy-lfu,policy-tinylfu\n"
+      << "  --threads <n>         最大线程数，依次测1/2/4/…/n（默认每核一个）\n"
+      << "  --read-ratio <r>      get占比，其余为put（默认0.9）\n"
+      << "  --dist <list>         uniform|zipf|zipf-ordered|latest|hotspot|sequential|loop（默认zipf），\n"
+      << "                        逗号分隔多个时依次分阶段切换\n"
+      << "  --theta <t>           zipf偏斜参数（默认0.99）\n"
+      << "  --value-size <n>      值字节数（默认64）\n"
+      << "  --keys <n>            key空间大小（默认1000000）\n"
+      << "  --capacity <n>        缓存容量（默认100000）\n"
+      << "  --shards <n>          分片变体的分片数（默认等于最大线程数）\n"
+      << "  --warmup-ms <n>       每组配置的预热时长（默认500）\n"
+      << "  --duration-ms <n>     每轮测量时长（默认1000）\n"
+      << "  --reps <n>            测量轮数（默认5）\n"
+      << "  --format <name>       text|csv|json（默认text）\n"
+      << "  --latency             逐个操作计时，按get/put报告p50/p99/p99.9/max（纳秒）\n"
+      << "  --perf                用perf_event_open统计每次操作的指令、周期、LLC/dTLB/分支失效\n"
+      << "  --trace <file>        录制访问trace到file（每组配置覆盖写），用于度量录制开销\n"
+      << "  --trace-sample <r>    录制时按key哈希采样的比例（默认0.01）\n"
+      << "  --tracer <name>       noop|usdt，引擎的编译期追踪钩子（默认noop）\n"
+      << "  --no-pin              不绑定CPU\n";
+}
+
+static std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty())
+      items.push_back(item);
+  }
+  return items;
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  options.engines = XCache::cachePolicyNames();
+  options.engines.push_back("hash-lru");
+  options.engines.push_back("hash-lfu");
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--no-pin") {
+      options.pin = false;
+      continue;
+    }
+    if (arg == "--latency") {
+      options.latency = true;
+      continue;
+    }
+    if (arg == "--perf") {
+      options.perf = true;
+      continue;
+    }
+    if (arg == "--help" || i + 1 >= argc) {
+      usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--engines")
+      options.engines = splitList(value);
+    else if (arg == "--threads")
+      options.maxThreads = std::max<size_t>(1, std::stoul(value));
+    else if (arg == "--read-ratio")
+      options.readRatio = std::stod(value);
+    else if (arg == "--dist")
+      options.dist = value;
+    else if (arg == "--theta")
+      options.theta = std::stod(value);
+    else if (arg == "--value-size")
+      options.valueSize = std::stoul(value);
+    else if (arg == "--keys")
+      options.keys = std::max<uint64_t>(1, std::stoull(value));
+    else if (arg == "--capacity")
+      options.capacity = std::stoul(value);
+    else if (arg == "--shards")
+      options.shards = std::stoi(value);
+    else if (arg == "--warmup-ms")
+      options.warmupMs = std::stoi(value);
+    else if (arg == "--duration-ms")
+      options.durationMs = std::stoi(value);
+    else if (arg == "--reps")
+      options.reps = std::max(1, std::stoi(value));
+    else if (arg == "--format")
+      options.format = value;
+    else if (arg == "--trace")
+      options.tracePath = value;
+    else if (arg == "--trace-sample")
+      options.traceSample = std::stod(value);
+    else if (arg == "--tracer" && (value == "noop" || value == "usdt"))
+      options.tracer = value;
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  try {
+    if (options.perf && !XBench::PerfCounters::available())
+      std::cerr << "bench_throughput: 硬件计数器不可用（虚拟机或perf_event_paranoid限制），"
+                   "计数列输出n/a"
+                << std::endl;
+    std::vector<OpStream> streams = makeStreams(options);
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < options.maxThreads; t *= 2)
+      threadCounts.push_back(t);
+    threadCounts.push_back(options.maxThreads);
+
+    printHeader(options);
+    bool first = true;
+    for (const std::string &name : options.engines) {
+      for (size_t threads : threadCounts) {
+        printResult(benchmark(name, threads, streams, options), options, first);
+        first = false;
+      }
+    }
+    if (options.format == "json")
+      std::cout << "]" << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << "bench_throughput: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -1,15 +1,46 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "XArcCache/XArcCache.h"
+#include "XCacheFactory.h"
 #include "XCachePolicy.h"
+#include "XEvictionStats.h"
+#include "XHistogram.h"
 #include "XLFUCache.h"
 #include "XLRUCache.h"
+#include "XMemoryResource.h"
+#include "XNamespaceCache.h"
+#include "XNegativeCache.h"
+#include "XPersist/XPersistentCache.h"
+#include "XPolicyCache.h"
+#include "XReclaimer.h"
+#include "XSerializer.h"
+#include "XStaticCache.h"
 #include "XWTinyLFUCache.h"
+#include "XWorkload.h"
+#include "server/XCacheServer.h"
+#include "sim/XSimulator.h"
+#include "sim/XTrace.h"
+#include "sim/XTraceRecorder.h"
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 class Timer {
 public:
@@ -104,13 +135,18 @@ TEST_F(CacheTest, CapacityLimit) {
 
 // 热点数据访问测试
 TEST_F(CacheTest, HotDataAccess) {
-  const int CAPACITY = 20;
   const int OPERATIONS = 10000; // 减少操作次数以便测试
   const int HOT_KEYS = 20;
   const int COLD_KEYS = 1000;
 
-  std::random_device rd;
-  std::mt19937 gen(rd());
+  // 70%访问落在20个热点key上，30%为put
+  XCache::XOpStream ops = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(
+          XCache::XKeySpec::hotspot(HOT_KEYS + COLD_KEYS,
+                                    double(HOT_KEYS) / (HOT_KEYS + COLD_KEYS),
+                                    0.7),
+          OPERATIONS, 0.7)},
+      1);
 
   for (int cache_idx = 0; cache_idx < 6; ++cache_idx) {
     // 预热缓存
@@ -122,16 +158,8 @@ TEST_F(CacheTest, HotDataAccess) {
     int get_operations = 0;
 
     for (int op = 0; op < OPERATIONS; ++op) {
-      bool isPut = (gen() % 100 < 30);
-      int key;
-
-      if (gen() % 100 < 70) {
-        key = gen() % HOT_KEYS; // 热点数据
-      } else {
-        key = HOT_KEYS + (gen() % COLD_KEYS); // 冷数据
-      }
-
-      if (isPut) {
+      int key = static_cast<int>(ops.keys[op]);
+      if (!ops.reads[op]) {
         caches[cache_idx]->put(key, "value" + std::to_string(key) + "_v" +
                                         std::to_string(op % 100));
       } else {
@@ -151,12 +179,17 @@ TEST_F(CacheTest, HotDataAccess) {
 
 // 循环扫描测试
 TEST_F(CacheTest, LoopPattern) {
-  const int CAPACITY = 50;
   const int LOOP_SIZE = 500;
   const int OPERATIONS = 5000; // 减少操作次数
 
-  std::random_device rd;
-  std::mt19937 gen(rd());
+  // 60%顺序扫描，30%随机跳跃，10%访问范围外数据；20%为put
+  XCache::XOpStream ops = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(
+          {{0.6, XCache::XKeySpec::loop(LOOP_SIZE)},
+           {0.3, XCache::XKeySpec::uniform(LOOP_SIZE)},
+           {0.1, XCache::XKeySpec::uniform(LOOP_SIZE, LOOP_SIZE)}},
+          OPERATIONS, 0.8)},
+      2);
 
   for (int cache_idx = 0; cache_idx < 6; ++cache_idx) {
     // 预热
@@ -166,22 +199,10 @@ TEST_F(CacheTest, LoopPattern) {
 
     int hits = 0;
     int get_operations = 0;
-    int current_pos = 0;
 
     for (int op = 0; op < OPERATIONS; ++op) {
-      bool isPut = (gen() % 100 < 20);
-      int key;
-
-      if (op % 100 < 60) { // 60%顺序扫描
-        key = current_pos;
-        current_pos = (current_pos + 1) % LOOP_SIZE;
-      } else if (op % 100 < 90) { // 30%随机跳跃
-        key = gen() % LOOP_SIZE;
-      } else { // 10%访问范围外数据
-        key = LOOP_SIZE + (gen() % LOOP_SIZE);
-      }
-
-      if (isPut) {
+      int key = static_cast<int>(ops.keys[op]);
+      if (!ops.reads[op]) {
         caches[cache_idx]->put(key, "loop" + std::to_string(key) + "_v" +
                                         std::to_string(op % 100));
       } else {
@@ -202,12 +223,21 @@ TEST_F(CacheTest, LoopPattern) {
 
 // 工作负载变化测试
 TEST_F(CacheTest, WorkloadShift) {
-  const int CAPACITY = 30;
   const int OPERATIONS = 2000; // 减少操作次数
   const int PHASE_LENGTH = OPERATIONS / 5;
 
-  std::random_device rd;
-  std::mt19937 gen(rd());
+  using XCache::XKeySpec;
+  // 五个阶段：极小热点、大范围随机、循环扫描、局部性区域、分层混合
+  XCache::XOpStream ops = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XKeySpec::uniform(5), PHASE_LENGTH, 0.85),
+       XCache::XWorkloadPhase(XKeySpec::uniform(400), PHASE_LENGTH, 0.70),
+       XCache::XWorkloadPhase(XKeySpec::loop(100), PHASE_LENGTH, 0.90),
+       XCache::XWorkloadPhase(XKeySpec::uniform(15, 15), PHASE_LENGTH, 0.75),
+       XCache::XWorkloadPhase({{0.4, XKeySpec::uniform(5)},
+                               {0.3, XKeySpec::uniform(45, 5)},
+                               {0.3, XKeySpec::uniform(350, 50)}},
+                              PHASE_LENGTH, 0.80)},
+      3);
 
   for (int cache_idx = 0; cache_idx < 6; ++cache_idx) {
     // 预热
@@ -220,52 +250,8 @@ TEST_F(CacheTest, WorkloadShift) {
 
     for (int op = 0; op < OPERATIONS; ++op) {
       int phase = op / PHASE_LENGTH;
-      int putProbability;
-
-      switch (phase) {
-      case 0:
-        putProbability = 15;
-        break;
-      case 1:
-        putProbability = 30;
-        break;
-      case 2:
-        putProbability = 10;
-        break;
-      case 3:
-        putProbability = 25;
-        break;
-      case 4:
-        putProbability = 20;
-        break;
-      default:
-        putProbability = 20;
-      }
-
-      bool isPut = (gen() % 100 < putProbability);
-      int key;
-
-      if (op < PHASE_LENGTH) {
-        key = gen() % 5;
-      } else if (op < PHASE_LENGTH * 2) {
-        key = gen() % 400;
-      } else if (op < PHASE_LENGTH * 3) {
-        key = (op - PHASE_LENGTH * 2) % 100;
-      } else if (op < PHASE_LENGTH * 4) {
-        int locality = (op / 800) % 5;
-        key = locality * 15 + (gen() % 15);
-      } else {
-        int r = gen() % 100;
-        if (r < 40) {
-          key = gen() % 5;
-        } else if (r < 70) {
-          key = 5 + (gen() % 45);
-        } else {
-          key = 50 + (gen() % 350);
-        }
-      }
-
-      if (isPut) {
+      int key = static_cast<int>(ops.keys[op]);
+      if (!ops.reads[op]) {
         caches[cache_idx]->put(key, "value" + std::to_string(key) + "_p" +
                                         std::to_string(phase));
       } else {
@@ -348,6 +334,1905 @@ TEST_P(CacheParamTest, DifferentCapacities) {
 INSTANTIATE_TEST_SUITE_P(CacheCapacities, CacheParamTest,
                          ::testing::Values(10, 50, 100));
 
+// 工作负载库：同一种子得到同一序列，各分布形状符合预期
+TEST(WorkloadTest, DeterministicDistributions) {
+  using XCache::XKeySpec;
+  auto zipf = XCache::makeKeyStream(XKeySpec::zipfian(10000), 100000, 7);
+  EXPECT_EQ(zipf, XCache::makeKeyStream(XKeySpec::zipfian(10000), 100000, 7));
+  EXPECT_NE(zipf, XCache::makeKeyStream(XKeySpec::zipfian(10000), 100000, 8));
+
+  // 偏斜越大，最热的1%的key承担的访问越多
+  auto topShare = [](const std::vector<uint64_t> &keys) {
+    std::unordered_map<uint64_t, size_t> freq;
+    for (uint64_t k : keys)
+      freq[k]++;
+    std::vector<size_t> counts;
+    for (auto &kv : freq)
+      counts.push_back(kv.second);
+    std::sort(counts.rbegin(), counts.rend());
+    size_t top = 0;
+    for (size_t i = 0; i < std::min<size_t>(100, counts.size()); ++i)
+      top += counts[i];
+    return double(top) / keys.size();
+  };
+  double skewed = topShare(zipf);
+  double mild = topShare(
+      XCache::makeKeyStream(XKeySpec::zipfian(10000, 0.5), 100000, 7));
+  double flat =
+      topShare(XCache::makeKeyStream(XKeySpec::uniform(10000), 100000, 7));
+  EXPECT_GT(skewed, 0.4);
+  EXPECT_GT(skewed, mild);
+  EXPECT_GT(mild, flat);
+  for (uint64_t k : zipf)
+    ASSERT_LT(k, 10000u);
+
+  // scrambled把热点打散，未打散时最热的是排名0
+  auto ordered = XCache::makeKeyStream(
+      XKeySpec::zipfian(10000, 0.99, false), 10000, 7);
+  EXPECT_GT(std::count(ordered.begin(), ordered.end(), 0u), 500);
+
+  auto hot = XCache::makeKeyStream(XKeySpec::hotspot(1000, 0.1, 0.9), 100000, 1);
+  double hotShare =
+      std::count_if(hot.begin(), hot.end(), [](uint64_t k) { return k < 100; }) /
+      double(hot.size());
+  EXPECT_NEAR(hotShare, 0.9, 0.01);
+
+  auto loop = XCache::makeKeyStream(XKeySpec::loop(3, 10), 7, 1);
+  EXPECT_EQ(loop, (std::vector<uint64_t>{10, 11, 12, 10, 11, 12, 10}));
+  auto scan = XCache::makeKeyStream(XKeySpec::sequential(5), 4, 1);
+  EXPECT_EQ(scan, (std::vector<uint64_t>{5, 6, 7, 8}));
+
+  // latest：新key不断插入，访问集中在最近的key上
+  auto latest = XCache::makeKeyStream(XKeySpec::latest(1000), 20000, 1);
+  EXPECT_GT(*std::max_element(latest.begin(), latest.end()), 1500u);
+  EXPECT_GT(latest.back(), 1000u);
+
+  // 分阶段：各阶段长度与读比例分别生效
+  XCache::XOpStream ops = XCache::makeOpStream(
+      XCache::parseWorkload("uniform,loop", 50, 1000, 0.5), 9);
+  ASSERT_EQ(ops.size(), 1000u);
+  EXPECT_EQ(ops.keys[500], 0u);
+  EXPECT_EQ(ops.keys[501], 1u);
+  size_t reads = std::count(ops.reads.begin(), ops.reads.end(), 1);
+  EXPECT_NEAR(reads / 1000.0, 0.5, 0.06);
+  EXPECT_THROW(XCache::parseKeySpec("gauss", 10), std::invalid_argument);
+}
+
+// 对数分桶直方图：百分位误差在子桶精度内，合并结果与单个实例一致
+TEST(HistogramTest, PercentilesAndMerge) {
+  XCache::XHistogram a, b, all;
+  for (uint64_t v = 1; v <= 100000; ++v) {
+    (v % 2 ? a : b).record(v);
+    all.record(v);
+  }
+  a.merge(b);
+  for (double p : {50.0, 99.0, 99.9}) {
+    uint64_t exact = static_cast<uint64_t>(p * 1000);
+    EXPECT_EQ(a.percentile(p), all.percentile(p));
+    EXPECT_GE(a.percentile(p), exact);
+    EXPECT_LE(a.percentile(p), exact + exact / XCache::XHistogram::kSubCount);
+  }
+  EXPECT_EQ(a.count(), 100000u);
+  EXPECT_EQ(a.max(), 100000u);
+  EXPECT_EQ(a.min(), 1u);
+  EXPECT_DOUBLE_EQ(a.mean(), 50000.5);
+  EXPECT_EQ(a.percentile(100), 100000u);
+
+  // 小值精确，极大值不越界
+  XCache::XHistogram small;
+  small.record(0);
+  small.record(7);
+  EXPECT_EQ(small.percentile(50), 0u);
+  EXPECT_EQ(small.percentile(100), 7u);
+  EXPECT_LT(XCache::XHistogram::bucketOf(UINT64_MAX),
+            XCache::XHistogram::kBuckets);
+}
+
+// 淘汰统计：按访问次数计时，淘汰年龄、命中数与再请求间隔可精确验证
+TEST(EvictionStatsTest, AgeHitsAndRerequest) {
+  auto stats = std::make_shared<XCache::XEvictionStats>(
+      16, XCache::XEvictionClock::Accesses);
+  XCache::XLRUCache<int, int> lru(2);
+  lru.setEvictionStats(stats);
+  int value;
+  lru.put(1, 1);
+  lru.put(2, 2);
+  EXPECT_TRUE(lru.get(1, value)); // 访问1
+  lru.put(3, 3);                  // 淘汰2：年龄1，零命中
+  EXPECT_FALSE(lru.get(2, value)); // 访问2，淘汰后隔1次访问被再请求
+  EXPECT_TRUE(lru.get(1, value));  // 访问3
+  lru.put(2, 2);                   // 淘汰3：年龄2
+  lru.remove(1);                   // 显式删除不计入
+  EXPECT_EQ(stats->getEvictions(), 2u);
+  EXPECT_EQ(stats->getZeroHitEvictions(), 2u);
+  EXPECT_EQ(stats->getAgeAtEviction().min(), 1u);
+  EXPECT_EQ(stats->getAgeAtEviction().max(), 2u);
+  EXPECT_EQ(stats->getRerequests(), 1u);
+  EXPECT_EQ(stats->getEvictionToRerequest().max(), 1u);
+
+  // 所有引擎都上报淘汰，循环访问超过容量时被淘汰的key会再被请求
+  XCache::XOpStream stream =
+      XCache::makeOpStream({XCache::XWorkloadPhase(
+                               XCache::XKeySpec::zipfian(2000, 0.9), 50000)},
+                           4);
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    auto policyStats = std::make_shared<XCache::XEvictionStats>(
+        4096, XCache::XEvictionClock::Accesses);
+    auto cache = XCache::makeCachePolicy<uint64_t, int>(name, 200);
+    cache->setEvictionStats(policyStats);
+    for (uint64_t key : stream.keys) {
+      if (!cache->get(key, value))
+        cache->put(key, 1);
+    }
+    EXPECT_GT(policyStats->getEvictions(), 0u) << name;
+    EXPECT_GT(policyStats->getRerequests(), 0u) << name;
+    EXPECT_LE(policyStats->getZeroHitEvictions(), policyStats->getEvictions())
+        << name;
+
+    // clear丢弃驻留记录，不计为淘汰
+    uint64_t evictions = policyStats->getEvictions();
+    EXPECT_GT(policyStats->getResidentCount(), 0u) << name;
+    cache->clear();
+    EXPECT_EQ(policyStats->getResidentCount(), 0u) << name;
+    EXPECT_EQ(policyStats->getEvictions(), evictions) << name;
+  }
+}
+
+// 使用缓存的同时挂接或关闭统计：所有引擎都在锁内或原子地替换统计对象
+TEST(EvictionStatsTest, SwapWhileInUse) {
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    auto cache = XCache::makeCachePolicy<int, int>(name, 64);
+    std::atomic<bool> done{false};
+    std::thread swapper([&] {
+      while (!done.load()) {
+        cache->setEvictionStats(std::make_shared<XCache::XEvictionStats>());
+        cache->setEvictionStats(nullptr);
+      }
+    });
+    for (int i = 0; i < 20000; ++i) {
+      cache->put(i % 200, i);
+      cache->get(i % 150);
+      if (i % 7 == 0)
+        cache->remove(i % 100);
+    }
+    done = true;
+    swapper.join();
+    cache->put(1000, 1);
+    EXPECT_EQ(cache->get(1000), 1) << name;
+  }
+}
+
+// 计数用的Tracer，验证各引擎在正确的位置回调
+struct CountingTracer {
+  static constexpr bool kEnabled = true;
+  static inline uint64_t hits, misses, inserts, evicts, promotes, admissions;
+
+  static void reset() { hits = misses = inserts = evicts = promotes = admissions = 0; }
+  template <typename Key> static void onHit(const void *, const Key &) { hits++; }
+  template <typename Key> static void onMiss(const void *, const Key &) { misses++; }
+  template <typename Key> static void onInsert(const void *, const Key &) { inserts++; }
+  template <typename Key> static void onEvict(const void *, const Key &) { evicts++; }
+  template <typename Key> static void onPromote(const void *, const Key &) { promotes++; }
+  template <typename Key>
+  static void onAdmission(const void *, const Key &, const Key &, bool) {
+    admissions++;
+  }
+  static void onLockWait(const void *, uint64_t) {}
+};
+
+TEST(TracerTest, HooksFireForAllEngines) {
+  CountingTracer::reset();
+  XCache::XLRUCache<int, int, CountingTracer> lru(2);
+  int value;
+  lru.put(1, 1);
+  lru.put(2, 2);
+  lru.put(3, 3); // 淘汰1
+  EXPECT_FALSE(lru.get(1, value));
+  EXPECT_TRUE(lru.get(3, value));
+  EXPECT_EQ(CountingTracer::inserts, 3u);
+  EXPECT_EQ(CountingTracer::evicts, 1u);
+  EXPECT_EQ(CountingTracer::hits, 1u);
+  EXPECT_EQ(CountingTracer::misses, 1u);
+
+  // LRU-K第K次访问时从历史队列晋升
+  CountingTracer::reset();
+  XCache::XLRUKCache<int, int, CountingTracer> lruk(4, 2);
+  lruk.put(7, 7);
+  EXPECT_EQ(CountingTracer::promotes, 0u);
+  EXPECT_TRUE(lruk.get(7, value));
+  EXPECT_EQ(CountingTracer::promotes, 1u);
+
+  // 命中与未命中的回调次数与返回值一致；W-TinyLFU满了之后每次window淘汰都有准入判定
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(500, 0.9), 5000)}, 5);
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    CountingTracer::reset();
+    auto cache =
+        XCache::makeCachePolicy<uint64_t, int, CountingTracer>(name, 50);
+    uint64_t hits = 0, misses = 0;
+    for (uint64_t key : stream.keys) {
+      if (cache->get(key, value)) {
+        hits++;
+      } else {
+        misses++;
+        cache->put(key, 1);
+      }
+    }
+    if (name != "lru-k") { // LRU-K晋升时返回true，但主缓存先报告了一次未命中
+      EXPECT_EQ(CountingTracer::hits, hits) << name;
+      EXPECT_EQ(CountingTracer::misses, misses) << name;
+    }
+    EXPECT_GT(CountingTracer::inserts, 0u) << name;
+    EXPECT_GT(CountingTracer::evicts, 0u) << name;
+    if (name == "arc" || name == "w-tinylfu") {
+      EXPECT_GT(CountingTracer::promotes, 0u) << name;
+    }
+    if (name == "w-tinylfu") {
+      EXPECT_GT(CountingTracer::admissions, 0u) << name;
+    }
+  }
+}
+
+// 组合式缓存：没有虚函数；LRU组合与XLRUCache命中完全一致，LFU淘汰最少访问的条目，
+// TinyLFU准入拒绝只出现一次的key
+TEST(PolicyCacheTest, ComposedEngines) {
+  static_assert(!std::is_polymorphic_v<XCache::XPolicyLRUCache<int, int>>);
+
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(1000, 0.9), 20000)}, 6);
+  XCache::XLRUCache<uint64_t, int> reference(100);
+  XCache::XPolicyCache<uint64_t, int, XCache::XHashIndex, XCache::XLruEviction,
+                       XCache::XAlwaysAdmit, XCache::XNoLocking,
+                       XCache::XCounterStats>
+      composed(100);
+  int value;
+  uint64_t referenceHits = 0;
+  for (uint64_t key : stream.keys) {
+    bool hit = reference.get(key, value);
+    EXPECT_EQ(composed.get(key, value), hit);
+    referenceHits += hit;
+    if (!hit) {
+      reference.put(key, 1);
+      composed.put(key, 1);
+    }
+  }
+  EXPECT_EQ(composed.getStats().hits, referenceHits);
+  EXPECT_EQ(composed.getStats().evictions,
+            composed.getStats().inserts - composed.size());
+
+  XCache::XPolicyLFUCache<int, int> lfu(2);
+  lfu.put(1, 1);
+  lfu.put(2, 2);
+  EXPECT_TRUE(lfu.get(1, value));
+  EXPECT_TRUE(lfu.get(1, value));
+  lfu.put(3, 3); // 淘汰访问最少的2
+  EXPECT_FALSE(lfu.get(2, value));
+  EXPECT_TRUE(lfu.get(1, value));
+  EXPECT_TRUE(lfu.get(3, value));
+  lfu.remove(3);
+  EXPECT_EQ(lfu.size(), 1u);
+
+  // 热key反复访问后，一次性扫描的key无法挤掉它们
+  XCache::XPolicyTinyLFUCache<int, int> tiny(10);
+  for (int round = 0; round < 5; ++round) {
+    for (int key = 0; key < 10; ++key) {
+      if (!tiny.get(key, value))
+        tiny.put(key, key);
+    }
+  }
+  for (int key = 1000; key < 1100; ++key)
+    tiny.put(key, key);
+  int hot = 0;
+  for (int key = 0; key < 10; ++key)
+    hot += tiny.get(key, value);
+  EXPECT_EQ(hot, 10);
+}
+
+// 按标签批量失效：只删除带该标签的条目；淘汰与删除会解除标签，空标签随之消失
+TEST(PolicyCacheTest, TagInvalidation) {
+  using Tagged =
+      XCache::XPolicyCache<int, int, XCache::XHashIndex, XCache::XLruEviction,
+                           XCache::XAlwaysAdmit, XCache::XMutexLocking,
+                           XCache::XNoStats, XCache::XTagIndex<std::string>>;
+  using Tags = std::vector<std::string>;
+  XCache::XCountingResource counting;
+  {
+    Tagged cache(100, &counting);
+    for (int key = 0; key < 60; ++key) {
+      Tags tags = {"product:" + std::to_string(key % 3)};
+      if (key % 2 == 0)
+        tags.push_back("even");
+      cache.put(key, key, tags);
+    }
+    cache.put(1000, 1000); // 不带标签
+    EXPECT_EQ(cache.getTagging().tagCount(), 4u);
+
+    EXPECT_EQ(cache.invalidateTag(std::string("product:1"), 3), 20u);
+    int value;
+    for (int key = 0; key < 60; ++key)
+      EXPECT_EQ(cache.contains(key), key % 3 != 1) << key;
+    EXPECT_TRUE(cache.get(1000, value));
+    EXPECT_EQ(cache.getTagging().tagCount(), 3u);
+
+    // 重新设置标签后不再属于原标签
+    cache.put(0, 0, Tags{"fresh"});
+    EXPECT_EQ(cache.invalidateTag(std::string("even"), 4), 19u);
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_EQ(cache.invalidateTag(std::string("missing")), 0u);
+
+    // 删除最后一个带标签的条目后标签被移除
+    cache.remove(0);
+    EXPECT_EQ(cache.invalidateTag(std::string("fresh")), 0u);
+
+    // 淘汰的条目解除标签
+    Tagged small(2);
+    small.put(1, 1, Tags{"a"});
+    small.put(2, 2, Tags{"b"});
+    small.put(3, 3, Tags{"b"});
+    EXPECT_EQ(small.getTagging().tagCount(), 1u);
+    EXPECT_EQ(small.invalidateTag(std::string("b"), 1), 2u);
+    EXPECT_EQ(small.size(), 0u);
+
+    // 失效与并发写入：调用前已带标签的条目全部删除，其间新写入的不受影响
+    for (int key = 0; key < 100; ++key)
+      cache.put(key, key, Tags{"bulk"});
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+      for (int key = 100; !stop; key = key < 10000 ? key + 1 : 100)
+        cache.put(key, key, Tags{"bulk"});
+    });
+    size_t removed = cache.invalidateTag(std::string("bulk"), 8);
+    stop = true;
+    writer.join();
+    EXPECT_GE(removed, 100u);
+    for (int key = 0; key < 100; ++key)
+      EXPECT_FALSE(cache.contains(key)) << key;
+  }
+  EXPECT_EQ(counting.getBytesInUse(), 0u); // 链接数组全部归还
+}
+
+// 静态分派与虚调用结果一致；适配器把非XCachePolicy引擎接入运行时选择的代码
+TEST(StaticCacheTest, MatchesVirtualDispatch) {
+  static_assert(XCache::isCacheEngine<XCache::XLRUCache<int, int>, int, int>);
+  static_assert(XCache::isCacheEngine<XCache::XPolicyLRUCache<int, int>, int, int>);
+  static_assert(!XCache::isCacheEngine<std::vector<int>, int, int>);
+
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(500, 0.9), 10000)}, 7);
+  XCache::XStaticCache<uint64_t, int, XCache::XLFUCache<uint64_t, int>>
+      direct(50);
+  std::unique_ptr<XCache::XCachePolicy<uint64_t, int>> virtualLfu =
+      std::make_unique<XCache::XLFUCache<uint64_t, int>>(50);
+  int a, b;
+  for (uint64_t key : stream.keys) {
+    bool hit = direct.get(key, a);
+    ASSERT_EQ(virtualLfu->get(key, b), hit);
+    if (hit)
+      EXPECT_EQ(a, b);
+    else {
+      direct.put(key, int(key));
+      virtualLfu->put(key, int(key));
+    }
+  }
+
+  auto adapted =
+      XCache::makeCachePolicyAdapter<int, int, XCache::XPolicyLRUCache<int, int>>(
+          2);
+  adapted->put(1, 10);
+  adapted->put(2, 20);
+  EXPECT_EQ(adapted->get(1), 10);
+  adapted->put(3, 30); // 淘汰最久未用的2
+  EXPECT_FALSE(adapted->get(2, a));
+  adapted->remove(1);
+  EXPECT_FALSE(adapted->get(1, a));
+  EXPECT_EQ(adapted->get(3), 30);
+}
+
+// 所有引擎的内存都经过传入的resource：运行中有分配，销毁后全部归还；
+// 默认resource换成null_memory_resource，漏传resource的pmr容器会直接抛出bad_alloc
+TEST(MemoryResourceTest, EnginesAllocateFromResource) {
+  struct DefaultResourceGuard {
+    std::pmr::memory_resource *previous =
+        std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    ~DefaultResourceGuard() { std::pmr::set_default_resource(previous); }
+  } guard;
+
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(2000, 0.9), 20000)}, 8);
+  auto run = [&](XCache::XCachePolicy<uint64_t, int> &cache) {
+    int value;
+    for (uint64_t key : stream.keys) {
+      if (!cache.get(key, value))
+        cache.put(key, int(key));
+    }
+    cache.remove(stream.keys.front());
+  };
+
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    XCache::XCountingResource counting(std::pmr::new_delete_resource());
+    {
+      auto cache = XCache::makeCachePolicy<uint64_t, int>(name, 200, &counting);
+      run(*cache);
+      EXPECT_GT(counting.getBytesInUse(), 0u) << name;
+    }
+    EXPECT_EQ(counting.getBytesInUse(), 0u) << name;
+    EXPECT_GT(counting.getPeakBytes(), 0u) << name;
+  }
+
+  XCache::XCountingResource counting(std::pmr::new_delete_resource());
+  {
+    XCache::XCachePolicyAdapter<uint64_t, int,
+                                XCache::XPolicyTinyLFUCache<uint64_t, int>>
+        cache(200, &counting);
+    run(cache);
+    EXPECT_GT(counting.getAllocations(), 0u);
+  }
+  EXPECT_EQ(counting.getBytesInUse(), 0u);
+
+  // 超过一条缓存行的value放在条目之外，同样从resource分配，删除、淘汰和clear时归还
+  using Large = std::array<char, 256>;
+  XCache::XCountingResource coldCounting(std::pmr::new_delete_resource());
+  {
+    XCache::XPolicyLRUCache<int, Large> cache(50, &coldCounting);
+    Large value{};
+    for (int key = 0; key < 100; ++key) {
+      value[0] = static_cast<char>(key);
+      cache.put(key, value);
+    }
+    EXPECT_GE(coldCounting.getBytesInUse(), 50 * sizeof(Large));
+    ASSERT_TRUE(cache.get(99, value));
+    EXPECT_EQ(value[0], static_cast<char>(99));
+    cache.modify(99, [](Large &v, bool) {
+      v[1] = 'x';
+      return true;
+    });
+    EXPECT_EQ(cache.get(99)[1], 'x');
+    cache.remove(98);
+    EXPECT_FALSE(cache.contains(98));
+    cache.clear();
+  }
+  EXPECT_EQ(coldCounting.getBytesInUse(), 0u);
+
+  // 单调分配器：淘汰的节点不回收，与全局堆的命中结果相同
+  std::pmr::monotonic_buffer_resource arena(std::pmr::new_delete_resource());
+  XCache::XLRUCache<uint64_t, int> pooled(100, &arena);
+  XCache::XLRUCache<uint64_t, int> heap(100, std::pmr::new_delete_resource());
+  int a, b;
+  for (uint64_t key : stream.keys) {
+    bool hit = pooled.get(key, a);
+    ASSERT_EQ(heap.get(key, b), hit);
+    if (!hit) {
+      pooled.put(key, 1);
+      heap.put(key, 1);
+    }
+  }
+}
+
+// peek/contains不改变策略状态：穿插大量peek的引擎与不peek的引擎命中序列完全相同
+TEST(PeekTest, DoesNotDisturbPolicy) {
+  XCache::XOpStream stream = XCache::makeOpStream(
+      {XCache::XWorkloadPhase(XCache::XKeySpec::zipfian(1000, 0.9), 20000)}, 9);
+  std::mt19937_64 rng(3);
+  std::uniform_int_distribution<uint64_t> probe(0, 999);
+
+  auto check = [&](XCache::XCachePolicy<uint64_t, int> &plain,
+                   XCache::XCachePolicy<uint64_t, int> &peeked,
+                   const std::string &name) {
+    int a, b;
+    for (uint64_t key : stream.keys) {
+      for (int i = 0; i < 3; ++i) {
+        uint64_t other = probe(rng);
+        bool found = peeked.peek(other, b);
+        ASSERT_EQ(peeked.contains(other), found) << name;
+        if (found) {
+          ASSERT_EQ(b, int(other)) << name;
+        }
+      }
+      bool hit = plain.get(key, a);
+      ASSERT_EQ(peeked.get(key, b), hit) << name;
+      if (!hit) {
+        plain.put(key, int(key));
+        peeked.put(key, int(key));
+      }
+    }
+  };
+
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    if (name == "w-tinylfu")
+      continue; // sketch的哈希种子随机，两个实例的准入结果不可比，单独检查
+    auto plain = XCache::makeCachePolicy<uint64_t, int>(name, 100);
+    auto peeked = XCache::makeCachePolicy<uint64_t, int>(name, 100);
+    check(*plain, *peeked, name);
+  }
+  XCache::XCachePolicyAdapter<uint64_t, int,
+                              XCache::XPolicyTinyLFUCache<uint64_t, int>>
+      plainTiny(100), peekedTiny(100);
+  check(plainTiny, peekedTiny, "policy-tinylfu");
+
+  XCache::XWTinyLFUCache<uint64_t, int> tiny(100);
+  for (uint64_t key = 0; key < 200; ++key)
+    tiny.put(key, int(key));
+  size_t accesses = tiny.getAccessCount();
+  int value;
+  int resident = 0;
+  for (uint64_t key = 0; key < 200; ++key) {
+    if (tiny.peek(key, value)) {
+      EXPECT_EQ(value, int(key));
+      EXPECT_TRUE(tiny.contains(key));
+      resident++;
+    }
+  }
+  EXPECT_GT(resident, 0);
+  EXPECT_EQ(tiny.getAccessCount(), accesses);
+
+  // peek与写入并发
+  XCache::XHashLRUCaches<int, int> sharded(1000, 4);
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int i = 0; i < 20000; ++i)
+      sharded.put(i % 2000, i % 2000);
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 2; ++t) {
+    readers.emplace_back([&] {
+      int v;
+      while (!done) {
+        for (int key = 0; key < 2000; key += 7) {
+          if (sharded.peek(key, v)) {
+            EXPECT_EQ(v, key);
+          }
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto &reader : readers)
+    reader.join();
+}
+
+// merge在引擎锁内读改写：并发累加不丢失更新；compute/computeIfAbsent的返回值与存储一致
+TEST(ComputeTest, AtomicMergeAndCompute) {
+  auto plus = [](const int &old, const int &delta) { return old + delta; };
+  const int kThreads = 4, kRounds = 500, kKeys = 10;
+  auto hammer = [&](auto &cache) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&] {
+        for (int i = 0; i < kRounds * kKeys; ++i)
+          cache.merge(i % kKeys, 1, plus);
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+  };
+
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    auto cache = XCache::makeCachePolicy<int, int>(name, 100);
+    hammer(*cache);
+    for (int key = 0; key < kKeys; ++key) {
+      int value = 0;
+      EXPECT_TRUE(cache->peek(key, value)) << name;
+      EXPECT_EQ(value, kThreads * kRounds) << name << " key " << key;
+    }
+
+    EXPECT_EQ(cache->computeIfAbsent(1000, [] { return 7; }), 7) << name;
+    EXPECT_EQ(cache->computeIfAbsent(1000, [] { return 8; }), 7) << name;
+    EXPECT_EQ(cache->compute(1000, [](const int *old) { return old ? *old * 2 : -1; }),
+              14)
+        << name;
+    int value = 0;
+    EXPECT_TRUE(cache->get(1000, value)) << name;
+    EXPECT_EQ(value, 14) << name;
+  }
+
+  XCache::XHashLRUCaches<int, int> sharded(100, 4);
+  hammer(sharded);
+  XCache::XPolicyLFUCache<int, int> composed(100);
+  hammer(composed);
+  for (int key = 0; key < kKeys; ++key) {
+    EXPECT_EQ(sharded.get(key), kThreads * kRounds);
+    EXPECT_EQ(composed.get(key), kThreads * kRounds);
+  }
+
+  // 未写回时与一次get相同：不存在的key不会被插入
+  XCache::XLRUCache<int, int> lru(2);
+  EXPECT_EQ(lru.modify(5, [](int &, bool present) { return present; }), 0);
+  EXPECT_FALSE(lru.contains(5));
+  // 更新与get一样刷新LRU顺序
+  lru.put(1, 1);
+  lru.put(2, 2);
+  lru.merge(1, 10, plus);
+  lru.put(3, 3);
+  EXPECT_FALSE(lru.contains(2));
+  EXPECT_EQ(lru.get(1), 11);
+
+  // fn返回false时对已有值的修改不写回
+  auto discard = [](int &value, bool) {
+    value = -1;
+    return false;
+  };
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    auto cache = XCache::makeCachePolicy<int, int>(name, 10);
+    for (int i = 0; i < 3; ++i)
+      cache->put(7, 70);
+    EXPECT_EQ(cache->modify(7, discard), -1) << name;
+    EXPECT_EQ(cache->get(7), 70) << name;
+  }
+  XCache::XPolicyLRUCache<int, int> policyLru(10);
+  policyLru.put(7, 70);
+  policyLru.modify(7, discard);
+  EXPECT_EQ(policyLru.get(7), 70);
+}
+
+// 游标按策略顺序遍历；分块之间有读写时，未被触碰的条目恰好返回一次
+TEST(CursorTest, PolicyOrderAndWeakConsistency) {
+  auto keysOf = [](auto cursor) {
+    std::vector<int> keys;
+    int key, value;
+    while (cursor.next(key, value)) {
+      EXPECT_EQ(value, key * 10);
+      keys.push_back(key);
+    }
+    return keys;
+  };
+
+  XCache::XLRUCache<int, int> lru(10);
+  for (int key = 1; key <= 5; ++key)
+    lru.put(key, key * 10);
+  lru.get(2);
+  EXPECT_EQ(keysOf(lru.cursor(2)), (std::vector<int>{2, 5, 4, 3, 1}));
+  EXPECT_EQ(lru.getOldestKey(), 1); // 遍历不调整顺序
+
+  XCache::XLFUCache<int, int> lfu(10);
+  for (int key = 1; key <= 4; ++key)
+    lfu.put(key, key * 10);
+  for (int i = 0; i < 3; ++i)
+    lfu.get(3);
+  lfu.get(1);
+  lfu.get(4);
+  EXPECT_EQ(keysOf(lfu.cursor(1)), (std::vector<int>{3, 4, 1, 2}));
+
+  // window容量为10：最近写入的10个在window，其余在主区
+  XCache::XWTinyLFUCache<int, int> tiny(100, 0.1);
+  for (int key = 1; key <= 30; ++key)
+    tiny.put(key, key * 10);
+  std::vector<int> tinyKeys = keysOf(tiny.cursor(3));
+  ASSERT_EQ(tinyKeys.size(), 30u);
+  EXPECT_EQ(std::vector<int>(tinyKeys.begin(), tinyKeys.begin() + 10),
+            (std::vector<int>{30, 29, 28, 27, 26, 25, 24, 23, 22, 21}));
+  EXPECT_EQ(tinyKeys[10], 20);
+
+  // 每个分块之间访问、删除和写入一部分条目
+  auto churn = [&](auto &cache) {
+    const int kKeys = 1000;
+    for (int key = 0; key < kKeys; ++key)
+      cache.put(key, key * 10);
+    std::mt19937 rng(7);
+    std::set<int> touched;
+    std::vector<int> seen;
+    auto cursor = cache.cursor(16);
+    std::vector<std::pair<int, int>> chunk;
+    while (cursor.nextChunk(chunk) > 0) {
+      for (int i = 0; i < 5; ++i) {
+        int key = rng() % kKeys;
+        touched.insert(key);
+        if (i == 0)
+          cache.remove(key);
+        else
+          cache.get(key);
+      }
+      cache.put(kKeys + static_cast<int>(chunk.size()), 0);
+    }
+    for (const auto &entry : chunk)
+      seen.push_back(entry.first);
+    std::set<int> unique(seen.begin(), seen.end());
+    EXPECT_EQ(unique.size(), seen.size());
+    for (int key = 0; key < kKeys; ++key) {
+      if (!touched.count(key)) {
+        EXPECT_TRUE(unique.count(key)) << key;
+      }
+    }
+  };
+  XCache::XLRUCache<int, int> bigLru(2000);
+  churn(bigLru);
+  XCache::XLFUCache<int, int> bigLfu(2000);
+  churn(bigLfu);
+
+  // 位置节点被访问后重新定位：跳过已返回的节点计入budget，单个分块不会走完已返回的部分
+  XCache::XLRUCache<int, int> restartLru(100);
+  for (int key = 0; key < 100; ++key)
+    restartLru.put(key, key);
+  XCache::XLRUCache<int, int>::CursorPosition position;
+  std::vector<std::pair<int, int>> out;
+  EXPECT_FALSE(restartLru.cursorChunk(position, 50, out));
+  EXPECT_EQ(out.back().first, 50);
+  restartLru.get(49);
+  out.clear();
+  EXPECT_FALSE(restartLru.cursorChunk(position, 4, out));
+  EXPECT_TRUE(out.empty());
+  while (!restartLru.cursorChunk(position, 4, out)) {
+  }
+  ASSERT_EQ(out.size(), 49u);
+  EXPECT_EQ(out.front().first, 48);
+  EXPECT_EQ(out.back().first, 0);
+}
+
+// 后端确认不存在的key由负缓存拦下；put之后不再被当作不存在，轮换两代后过期
+TEST(NegativeCacheTest, SkipsBackendForAbsentKeys) {
+  std::unordered_map<int, int> backend = {{1, 10}, {2, 20}};
+  int backendCalls = 0;
+  auto loader = [&](const int &key, int &value) {
+    ++backendCalls;
+    auto it = backend.find(key);
+    if (it == backend.end())
+      return false;
+    value = it->second;
+    return true;
+  };
+  XCache::XNegativeCacheOptions options;
+  options.keysPerGeneration = 4;
+  XCache::XLoadingCache<int, int> cache(
+      XCache::makeCachePolicy<int, int>("lru", 2), loader, options);
+
+  EXPECT_EQ(cache.get(1), 10);
+  EXPECT_EQ(cache.get(1), 10);
+  EXPECT_EQ(backendCalls, 1);
+
+  int value = 0;
+  EXPECT_FALSE(cache.get(100, value));
+  EXPECT_FALSE(cache.get(100, value));
+  EXPECT_EQ(backendCalls, 2);
+  EXPECT_EQ(cache.getStats().negativeHits, 1u);
+  EXPECT_EQ(cache.getStats().absentLoads, 1u);
+
+  // 写入后即使被淘汰，也会重新访问后端而不是返回不存在
+  backend[100] = 1000;
+  cache.put(100, 1000);
+  cache.put(3, 30);
+  cache.put(4, 40);
+  EXPECT_FALSE(cache.contains(100));
+  EXPECT_TRUE(cache.get(100, value));
+  EXPECT_EQ(value, 1000);
+
+  // loader执行期间被写入时不记录不存在
+  bool racing = true;
+  XCache::XLoadingCache<int, int> *self = nullptr;
+  XCache::XLoadingCache<int, int> racy(
+      XCache::makeCachePolicy<int, int>("lru", 2),
+      [&](const int &key, int &) {
+        if (racing) {
+          racing = false;
+          self->put(key, 7);
+        }
+        return false;
+      });
+  self = &racy;
+  EXPECT_FALSE(racy.get(5, value));
+  racy.remove(5);
+  EXPECT_FALSE(racy.get(5, value));
+  EXPECT_EQ(racy.getStats().loads, 2u);
+
+  // 每代4个key：写满两代后最早的key过期，重新访问后端
+  for (int key = 200; key < 208; ++key)
+    cache.get(key, value);
+  int before = backendCalls;
+  cache.get(200, value);
+  EXPECT_EQ(backendCalls, before + 1);
+  cache.get(207, value);
+  EXPECT_EQ(backendCalls, before + 1);
+
+  // 误判率接近目标
+  XCache::XNegativeCacheOptions big;
+  big.keysPerGeneration = 100000;
+  big.falsePositiveRate = 0.01;
+  XCache::XNegativeFilter<int> filter(big);
+  for (int key = 0; key < 50000; ++key)
+    filter.add(key, filter.version(key));
+  int falsePositives = 0;
+  for (int key = 1000000; key < 1100000; ++key)
+    falsePositives += filter.mayContain(key);
+  EXPECT_LT(falsePositives, 2000);
+  for (int key = 0; key < 50000; ++key)
+    EXPECT_TRUE(filter.mayContain(key));
+}
+
+// 命名空间代数加一后，该命名空间的条目全部失效，其他命名空间不受影响
+TEST(NamespaceCacheTest, GenerationBumpInvalidatesNamespace) {
+  using Entry = XCache::XGenerationEntry<int>;
+  auto tenantOf = [](const std::string &key) {
+    return key.substr(0, key.find(':'));
+  };
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    XCache::XNamespaceCache<std::string, int> cache(
+        XCache::makeCachePolicy<std::string, Entry>(name, 100), tenantOf);
+    for (int i = 0; i < 10; ++i) {
+      cache.put("a:" + std::to_string(i), i);
+      cache.put("b:" + std::to_string(i), i);
+    }
+    EXPECT_EQ(cache.invalidateNamespace("a"), 1u) << name;
+
+    int value = 0;
+    EXPECT_FALSE(cache.contains("a:1")) << name;
+    EXPECT_FALSE(cache.get("a:1", value)) << name;
+    EXPECT_FALSE(cache.getEngine().contains("a:1")) << name; // get时回收
+    if (name != "lru-k") { // LRU-K只put一次的条目还在历史表中
+      EXPECT_TRUE(cache.getEngine().contains("a:2")) << name; // 未访问的仍在引擎中
+    }
+    EXPECT_TRUE(cache.get("b:1", value)) << name;
+    EXPECT_EQ(value, 1) << name;
+
+    // 失效条目对modify表现为不存在；写入后属于新一代
+    EXPECT_EQ(cache.merge("a:2", 5, [](int old, int delta) { return old + delta; }),
+              5)
+        << name;
+    cache.put("a:3", 30);
+    EXPECT_TRUE(cache.get("a:3", value)) << name;
+    EXPECT_EQ(value, 30) << name;
+    EXPECT_EQ(cache.getStaleReclaimed(), 1u) << name;
+
+    // 回收只删除仍失效的条目：并发put已写入新一代时条件不成立
+    auto stale = [](const Entry &stored) { return stored.generation != 1; };
+    EXPECT_FALSE(cache.getEngine().removeIf("a:3", stale)) << name;
+    EXPECT_TRUE(cache.get("a:3", value)) << name;
+    EXPECT_TRUE(cache.removeIf("b:2", [](int v) { return v == 2; })) << name;
+    EXPECT_FALSE(cache.contains("b:2")) << name;
+    EXPECT_FALSE(cache.removeIf("b:3", [](int v) { return v == 0; })) << name;
+    EXPECT_FALSE(cache.removeIf("a:4", [](int) { return true; })) << name;
+  }
+}
+
+// clear在锁内只交换出空的结构，旧条目由XReclaimer在后台归还给resource
+TEST(ClearTest, SwapsInEmptyStructures) {
+  for (const std::string &name : XCache::cachePolicyNames()) {
+    XCache::XCountingResource counting(std::pmr::new_delete_resource());
+    {
+      auto cache = XCache::makeCachePolicy<int, int>(name, 200, &counting);
+      size_t baseline = counting.getBytesInUse();
+      for (int round = 0; round < 3; ++round) {
+        for (int key = 0; key < 500; ++key) {
+          cache->put(key, key);
+          cache->get(key);
+          cache->get(key);
+        }
+        EXPECT_GT(counting.getBytesInUse(), baseline) << name;
+        cache->clear();
+        for (int key = 0; key < 500; ++key)
+          EXPECT_FALSE(cache->contains(key)) << name << " " << key;
+        XCache::XReclaimer::instance().drain();
+        EXPECT_EQ(counting.getBytesInUse(), baseline) << name;
+      }
+      // 清空后照常工作
+      for (int key = 0; key < 5; ++key) {
+        cache->put(key, key * 10);
+        cache->put(key, key * 10);
+      }
+      EXPECT_EQ(cache->get(3), 30) << name;
+    }
+    EXPECT_EQ(counting.getBytesInUse(), 0u) << name;
+  }
+
+  // 遍历期间被clear，游标直接结束
+  XCache::XLRUCache<int, int> lru(100);
+  XCache::XLFUCache<int, int> lfu(100);
+  XCache::XWTinyLFUCache<int, int> tiny(100, 0.1);
+  auto checkCursor = [](auto &cache) {
+    for (int key = 0; key < 50; ++key)
+      cache.put(key, key);
+    auto cursor = cache.cursor(8);
+    std::vector<std::pair<int, int>> chunk;
+    EXPECT_EQ(cursor.nextChunk(chunk), 8u);
+    cache.clear();
+    cache.put(1000, 1000);
+    EXPECT_EQ(cursor.nextChunk(chunk), 0u);
+    EXPECT_TRUE(cursor.done());
+  };
+  checkCursor(lru);
+  checkCursor(lfu);
+  checkCursor(tiny);
+
+  // XPolicyCache：标签随条目一起换掉，扫描中的invalidateTag遇到clear提前结束
+  using Tagged =
+      XCache::XPolicyCache<int, int, XCache::XHashIndex, XCache::XLruEviction,
+                           XCache::XAlwaysAdmit, XCache::XMutexLocking,
+                           XCache::XNoStats, XCache::XTagIndex<std::string>>;
+  XCache::XCountingResource counting(std::pmr::new_delete_resource());
+  {
+    Tagged tagged(100, &counting);
+    for (int key = 0; key < 50; ++key)
+      tagged.put(key, key, std::vector<std::string>{"t"});
+    tagged.clear();
+    EXPECT_EQ(tagged.size(), 0u);
+    EXPECT_EQ(tagged.getTagging().tagCount(), 0u);
+    EXPECT_EQ(tagged.invalidateTag(std::string("t")), 0u);
+
+    for (int key = 0; key < 5000; ++key)
+      tagged.put(key % 100, key, std::vector<std::string>{"t"});
+    std::thread clearer([&] { tagged.clear(); });
+    tagged.invalidateTag(std::string("t"), 1);
+    clearer.join();
+    EXPECT_EQ(tagged.size(), 0u);
+  }
+  EXPECT_EQ(counting.getBytesInUse(), 0u);
+
+  // 包装层转发给引擎
+  XCache::XLoadingCache<int, int> loading(
+      XCache::makeCachePolicy<int, int>("lru", 10),
+      [](const int &, int &) { return false; });
+  loading.put(1, 1);
+  loading.clear();
+  EXPECT_FALSE(loading.contains(1));
+  XCache::XHashLRUCaches<int, int> sharded(100, 4);
+  sharded.put(1, 1);
+  sharded.clear();
+  int value;
+  EXPECT_FALSE(sharded.get(1, value));
+}
+
+// unsynchronized_pool_resource不能在后台线程归还：clear在调用线程上释放，返回时内存已经还给resource
+TEST(ClearTest, UnsynchronizedResourceReleasesInline) {
+  std::pmr::unsynchronized_pool_resource pool;
+  std::pmr::synchronized_pool_resource syncPool;
+  XCache::XCountingResource overSync(&syncPool);
+  EXPECT_FALSE(XCache::isThreadSafeResource(&pool));
+  EXPECT_TRUE(XCache::isThreadSafeResource(&syncPool));
+  EXPECT_TRUE(XCache::isThreadSafeResource(&overSync));
+  EXPECT_TRUE(XCache::isThreadSafeResource(std::pmr::new_delete_resource()));
+
+  std::vector<std::string> names = XCache::cachePolicyNames();
+  names.push_back("policy-lru");
+  for (const std::string &name : names) {
+    XCache::XCountingResource counting(&pool);
+    EXPECT_FALSE(XCache::isThreadSafeResource(&counting));
+    {
+      std::unique_ptr<XCache::XCachePolicy<int, int>> cache;
+      if (name == "policy-lru")
+        cache = XCache::makeCachePolicyAdapter<int, int,
+                                               XCache::XPolicyLRUCache<int, int>>(
+            200, &counting);
+      else
+        cache = XCache::makeCachePolicy<int, int>(name, 200, &counting);
+      size_t baseline = counting.getBytesInUse();
+      for (int round = 0; round < 3; ++round) {
+        for (int key = 0; key < 500; ++key) {
+          cache->put(key, key);
+          cache->get(key);
+        }
+        EXPECT_GT(counting.getBytesInUse(), baseline) << name;
+        cache->clear();
+        EXPECT_EQ(counting.getBytesInUse(), baseline) << name;
+        EXPECT_FALSE(cache->contains(1)) << name;
+      }
+    }
+    EXPECT_EQ(counting.getBytesInUse(), 0u) << name;
+  }
+}
+
+// 分片缓存在多线程并发读写下保持一致
+TEST(ShardedCacheTest, ConcurrentPutGet) {
+  XCache::XHashLRUCaches<int, int> lru(4000, 4);
+  XCache::XHashLFUCache<int, int> lfu(4000, 4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = t * 1000; i < (t + 1) * 1000; ++i) {
+        lru.put(i, i * 2);
+        lfu.put(i, i * 3);
+        int value = 0;
+        lru.get(i, value);
+        lfu.get(i, value);
+      }
+    });
+  }
+  for (auto &th : threads)
+    th.join();
+
+  // 容量向上取整到分片，4000个key不会被淘汰
+  for (int i = 0; i < 4000; i += 97) {
+    EXPECT_EQ(lru.get(i), i * 2);
+    EXPECT_EQ(lfu.get(i), i * 3);
+  }
+  lru.remove(0);
+  lfu.remove(0);
+  int value = 0;
+  EXPECT_FALSE(lru.get(0, value));
+  EXPECT_FALSE(lfu.get(0, value));
+}
+
+// 序列化测试用的自定义类型，通过特化Serializer接入
+struct UserProfile {
+  std::string name;
+  int age = 0;
+};
+
+namespace XCache {
+template <> struct Serializer<UserProfile> {
+  static size_t size(const UserProfile &v) {
+    return sizeof(int) + v.name.size();
+  }
+  static void write(const UserProfile &v, char *dst) {
+    std::memcpy(dst, &v.age, sizeof(int));
+    std::memcpy(dst + sizeof(int), v.name.data(), v.name.size());
+  }
+  static bool read(std::string_view bytes, UserProfile &out) {
+    if (bytes.size() < sizeof(int))
+      return false;
+    std::memcpy(&out.age, bytes.data(), sizeof(int));
+    out.name.assign(bytes.data() + sizeof(int), bytes.size() - sizeof(int));
+    return true;
+  }
+};
+} // namespace XCache
+
+TEST(SerializerTest, BuiltinAndUserTypes) {
+  static_assert(XCache::isSerializable<int>);
+  static_assert(XCache::isSerializable<std::string>);
+  static_assert(XCache::hasSerializedView<int>);
+  static_assert(XCache::hasSerializedView<std::string>);
+  static_assert(XCache::isSerializable<UserProfile>);
+  static_assert(!XCache::hasSerializedView<UserProfile>);
+  static_assert(!XCache::isSerializable<std::vector<std::string>>);
+
+  // 零拷贝视图直接指向原对象的内存
+  std::string text = "hello";
+  EXPECT_EQ(XCache::Serializer<std::string>::view(text).data(), text.data());
+  int number = 42;
+  EXPECT_EQ(XCache::Serializer<int>::view(number).data(),
+            reinterpret_cast<const char *>(&number));
+
+  std::string buffer;
+  XCache::serializeAppend(number, buffer);
+  int decodedNumber = 0;
+  ASSERT_TRUE(XCache::deserialize(buffer, decodedNumber));
+  EXPECT_EQ(decodedNumber, 42);
+  EXPECT_FALSE(XCache::deserialize(std::string_view("abc"), decodedNumber));
+
+  std::vector<double> samples = {1.5, 2.5, 3.5};
+  buffer.clear();
+  XCache::serializeAppend(samples, buffer);
+  std::vector<double> decodedSamples;
+  ASSERT_TRUE(XCache::deserialize(buffer, decodedSamples));
+  EXPECT_EQ(decodedSamples, samples);
+
+  std::pair<std::string, int> composite{"tenant", 7};
+  buffer.clear();
+  XCache::serializeAppend(composite, buffer);
+  std::pair<std::string, int> decodedComposite;
+  ASSERT_TRUE(XCache::deserialize(buffer, decodedComposite));
+  EXPECT_EQ(decodedComposite, composite);
+
+  UserProfile profile{"alice", 30};
+  buffer.clear();
+  XCache::serializeAppend(profile, buffer);
+  UserProfile decodedProfile;
+  ASSERT_TRUE(XCache::deserialize(buffer, decodedProfile));
+  EXPECT_EQ(decodedProfile.name, "alice");
+  EXPECT_EQ(decodedProfile.age, 30);
+}
+
+// 持久化缓存测试
+class PersistentCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir = std::filesystem::path(::testing::TempDir()) /
+          ("xcache_persist_" +
+           std::string(
+               ::testing::UnitTest::GetInstance()->current_test_info()->name()));
+    std::filesystem::remove_all(dir);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir); }
+
+  using PersistentLRU = XCache::XPersistentCache<int, std::string>;
+
+  std::unique_ptr<PersistentLRU> open(XCache::XLogOptions options,
+                                      int capacity = 10000) {
+    return std::make_unique<PersistentLRU>(
+        dir.string(),
+        std::make_unique<XCache::XLRUCache<int, std::string>>(capacity),
+        options);
+  }
+
+  std::filesystem::path dir;
+};
+
+TEST_F(PersistentCacheTest, RecoverFromLog) {
+  XCache::XLogOptions options;
+  {
+    auto cache = open(options);
+    for (int i = 0; i < 500; ++i) {
+      cache->put(i, "value" + std::to_string(i));
+    }
+    cache->put(7, "updated");
+    cache->remove(8);
+  }
+
+  auto cache = open(options);
+  EXPECT_EQ(cache->getRecoveryStats().logRecords, 502u);
+  std::string result;
+  ASSERT_TRUE(cache->get(0, result));
+  EXPECT_EQ(result, "value0");
+  ASSERT_TRUE(cache->get(7, result));
+  EXPECT_EQ(result, "updated");
+  EXPECT_FALSE(cache->get(8, result));
+  ASSERT_TRUE(cache->get(499, result));
+  EXPECT_EQ(result, "value499");
+}
+
+TEST_F(PersistentCacheTest, TornTailIsTruncated) {
+  XCache::XLogOptions options;
+  options.durability = XCache::XDurability::Async;
+  {
+    auto cache = open(options);
+    for (int i = 0; i < 100; ++i) {
+      cache->put(i, "value" + std::to_string(i));
+    }
+  }
+  // 模拟崩溃时写了一半的记录
+  std::filesystem::path lastSegment;
+  for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+    if (entry.path().extension() == ".xlog" &&
+        std::filesystem::file_size(entry.path()) > 0)
+      lastSegment = std::max(lastSegment, entry.path());
+  }
+  ASSERT_FALSE(lastSegment.empty());
+  {
+    std::ofstream out(lastSegment, std::ios::binary | std::ios::app);
+    out.write("\x01\x02\x03\x04\x05\x06\x07", 7);
+  }
+
+  {
+    auto cache = open(options);
+    EXPECT_EQ(cache->getRecoveryStats().logRecords, 100u);
+    EXPECT_EQ(cache->getRecoveryStats().tornBytes, 7u);
+    cache->put(1000, "after-crash");
+  }
+  auto cache = open(options);
+  std::string result;
+  ASSERT_TRUE(cache->get(1000, result));
+  EXPECT_EQ(result, "after-crash");
+  ASSERT_TRUE(cache->get(99, result));
+  EXPECT_EQ(result, "value99");
+}
+
+// 后台线程写盘失败（这里用RLIMIT_FSIZE制造EFBIG）不终止进程，错误交给之后的put/sync
+TEST_F(PersistentCacheTest, WriteErrorIsReported) {
+  struct rlimit previous;
+  ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &previous), 0);
+  auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+  for (auto durability :
+       {XCache::XDurability::GroupCommit, XCache::XDurability::Async}) {
+    std::filesystem::remove_all(dir);
+    XCache::XLogOptions options;
+    options.durability = durability;
+    auto cache = open(options);
+    cache->put(-1, "before");
+    cache->sync();
+
+    struct rlimit limited = previous;
+    limited.rlim_cur = 4096;
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+    bool failed = false;
+    try {
+      for (int i = 0; i < 1000; ++i)
+        cache->put(i, std::string(100, 'x'));
+      cache->sync();
+    } catch (const std::runtime_error &) {
+      failed = true;
+    }
+    EXPECT_TRUE(failed);
+    EXPECT_THROW(cache->put(5000, "after"), std::runtime_error);
+    EXPECT_THROW(cache->sync(), std::runtime_error);
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &previous), 0);
+    std::string result;
+    EXPECT_TRUE(cache->get(-1, result));
+  }
+  std::signal(SIGXFSZ, previousHandler);
+}
+
+// Clear记录在回放与压缩时丢弃它之前的所有条目
+TEST_F(PersistentCacheTest, ClearIsLogged) {
+  XCache::XLogOptions options;
+  {
+    auto cache = open(options);
+    for (int i = 0; i < 100; ++i)
+      cache->put(i, "old" + std::to_string(i));
+    cache->clear();
+    EXPECT_FALSE(cache->contains(1));
+    cache->put(1, "new");
+  }
+  {
+    auto cache = open(options);
+    EXPECT_EQ(cache->getRecoveryStats().logRecords, 102u);
+    std::string result;
+    EXPECT_FALSE(cache->get(2, result));
+    ASSERT_TRUE(cache->get(1, result));
+    EXPECT_EQ(result, "new");
+    cache->checkpoint();
+  }
+  auto cache = open(options);
+  EXPECT_EQ(cache->getRecoveryStats().checkpointEntries, 1u);
+  std::string result;
+  EXPECT_FALSE(cache->get(2, result));
+  ASSERT_TRUE(cache->get(1, result));
+  EXPECT_EQ(result, "new");
+}
+
+TEST_F(PersistentCacheTest, CheckpointCompactsLog) {
+  XCache::XLogOptions options;
+  options.durability = XCache::XDurability::Async;
+  options.segmentBytes = 4096;
+  options.maxBatchBytes = 1024;
+  options.compactSegments = 2;
+  const int ENTRIES = 20000;
+  const int CAPACITY = 5000;
+  {
+    auto cache = open(options, CAPACITY);
+    for (int i = 0; i < ENTRIES; ++i) {
+      cache->put(i % 8000, "value" + std::to_string(i));
+    }
+    cache->checkpoint();
+    cache->put(ENTRIES, "tail");
+  }
+
+  size_t segments = 0;
+  for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+    if (entry.path().extension() == ".xlog")
+      segments++;
+  }
+  EXPECT_LE(segments, 3u) << "sealed segments should be folded into checkpoint";
+
+  auto cache = open(options, CAPACITY);
+  const auto &stats = cache->getRecoveryStats();
+  // 检查点默认只保留引擎容量个最近写入的条目，更早的在引擎中已被淘汰
+  EXPECT_EQ(stats.checkpointEntries, static_cast<size_t>(CAPACITY));
+  EXPECT_EQ(stats.logRecords, 1u);
+  EXPECT_LT(stats.elapsedMs, 5000.0);
+  std::string result;
+  ASSERT_TRUE(cache->get(ENTRIES, result));
+  EXPECT_EQ(result, "tail");
+  ASSERT_TRUE(cache->get((ENTRIES - 1) % 8000, result));
+  EXPECT_EQ(result, "value" + std::to_string(ENTRIES - 1));
+}
+
+// 回环网络客户端，用于服务端集成测试
+class LoopbackClient {
+public:
+  explicit LoopbackClient(int port) {
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    connected =
+        ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+  }
+
+  explicit LoopbackClient(const std::string &unixPath) {
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, unixPath.c_str(), sizeof(addr.sun_path) - 1);
+    connected =
+        ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+  }
+
+  ~LoopbackClient() { ::close(fd); }
+
+  // 发送请求并读取至少expectedSize字节的回复（2秒超时）
+  std::string roundTrip(const std::string &request, size_t expectedSize) {
+    size_t sent = 0;
+    while (sent < request.size()) {
+      ssize_t w = ::send(fd, request.data() + sent, request.size() - sent, 0);
+      if (w <= 0)
+        return "";
+      sent += size_t(w);
+    }
+    std::string reply;
+    char buf[4096];
+    while (reply.size() < expectedSize) {
+      pollfd pfd{fd, POLLIN, 0};
+      if (::poll(&pfd, 1, 2000) <= 0)
+        break;
+      ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+      if (r <= 0)
+        break;
+      reply.append(buf, size_t(r));
+    }
+    return reply;
+  }
+
+  std::string expect(const std::string &request, const std::string &reply) {
+    return roundTrip(request, reply.size());
+  }
+
+  void shutdownWrite() { ::shutdown(fd, SHUT_WR); }
+
+  bool connected = false;
+
+private:
+  int fd = -1;
+};
+
+class MemcacheServerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    XCache::XServerOptions options;
+    options.host = "127.0.0.1";
+    options.port = 0;
+    options.threads = 2;
+    options.capacity = 1000;
+    options.shards = 4;
+    options.unixPath = ::testing::TempDir() + "xcache_test.sock";
+    server = std::make_unique<XCache::XCacheServer>(options);
+    server->start();
+  }
+
+  void TearDown() override { server->stop(); }
+
+  std::unique_ptr<XCache::XCacheServer> server;
+};
+
+TEST_F(MemcacheServerTest, BasicCommands) {
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+
+  std::string reply = "STORED\r\n";
+  EXPECT_EQ(client.expect("set foo 5 0 3\r\nbar\r\n", reply), reply);
+  reply = "VALUE foo 5 3\r\nbar\r\nEND\r\n";
+  EXPECT_EQ(client.expect("get foo\r\n", reply), reply);
+
+  std::string gets = client.roundTrip("gets foo\r\n", 20);
+  EXPECT_EQ(gets.rfind("VALUE foo 5 3 ", 0), 0u) << gets;
+
+  reply = "STORED\r\n";
+  EXPECT_EQ(client.expect("set n 0 0 2\r\n40\r\n", reply), reply);
+  reply = "42\r\n";
+  EXPECT_EQ(client.expect("incr n 2\r\n", reply), reply);
+  reply = "CLIENT_ERROR cannot increment or decrement non-numeric value\r\n";
+  EXPECT_EQ(client.expect("incr foo 1\r\n", reply), reply);
+  reply = "NOT_FOUND\r\n";
+  EXPECT_EQ(client.expect("incr missing 1\r\n", reply), reply);
+
+  reply = "DELETED\r\n";
+  EXPECT_EQ(client.expect("delete foo\r\n", reply), reply);
+  reply = "NOT_FOUND\r\n";
+  EXPECT_EQ(client.expect("delete foo\r\n", reply), reply);
+  reply = "END\r\n";
+  EXPECT_EQ(client.expect("get foo\r\n", reply), reply);
+  reply = "ERROR\r\n";
+  EXPECT_EQ(client.expect("bogus\r\n", reply), reply);
+}
+
+TEST_F(MemcacheServerTest, PipelinedRequests) {
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+
+  // 一次写入多条命令，连续的get会被合并为一次multi-get
+  std::string request = "set a 0 0 1\r\n1\r\n"
+                        "set b 0 0 1 noreply\r\n2\r\n"
+                        "get a\r\n"
+                        "get b c\r\n"
+                        "get a b\r\n"
+                        "incr a 9\r\n"
+                        "get a\r\n";
+  std::string reply = "STORED\r\n"
+                      "VALUE a 0 1\r\n1\r\nEND\r\n"
+                      "VALUE b 0 1\r\n2\r\nEND\r\n"
+                      "VALUE a 0 1\r\n1\r\nVALUE b 0 1\r\n2\r\nEND\r\n"
+                      "10\r\n"
+                      "VALUE a 0 2\r\n10\r\nEND\r\n";
+  EXPECT_EQ(client.expect(request, reply), reply);
+
+  // key数超过单行token上限的multi-get不丢key
+  std::string manyKeys = "get";
+  std::string manyReply;
+  for (int i = 0; i < 30; ++i) {
+    manyKeys += i % 2 ? " b" : " a";
+    manyReply += i % 2 ? "VALUE b 0 1\r\n2\r\n" : "VALUE a 0 2\r\n10\r\n";
+  }
+  manyReply += "END\r\n";
+  EXPECT_EQ(client.expect(manyKeys + "\r\n", manyReply), manyReply);
+
+  // 数据块被拆成多次到达
+  std::string partial = client.roundTrip("set big 0 0 10\r\n01234", 0);
+  EXPECT_EQ(partial, "");
+  reply = "STORED\r\n";
+  EXPECT_EQ(client.expect("56789\r\n", reply), reply);
+  reply = "VALUE big 0 10\r\n0123456789\r\nEND\r\n";
+  EXPECT_EQ(client.expect("get big\r\n", reply), reply);
+}
+
+// 超大或会溢出的<bytes>被拒绝并关闭连接，服务端不受影响
+TEST_F(MemcacheServerTest, RejectsOversizedItems) {
+  {
+    LoopbackClient client(server->getPort());
+    ASSERT_TRUE(client.connected);
+    std::string reply = "CLIENT_ERROR object too large for cache\r\n";
+    EXPECT_EQ(client.expect("set k 0 0 18446744073709551614\r\nX", reply),
+              reply);
+  }
+  {
+    LoopbackClient client(server->getPort());
+    ASSERT_TRUE(client.connected);
+    std::string reply = "CLIENT_ERROR object too large for cache\r\n";
+    EXPECT_EQ(client.expect("set k 0 0 2000000\r\n", reply), reply);
+  }
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+  std::string reply = "STORED\r\n";
+  EXPECT_EQ(client.expect("set k 0 0 1\r\nX\r\n", reply), reply);
+
+  // 其他字段出错时按<bytes>跳过数据块，数据不会被当成命令
+  reply = "CLIENT_ERROR bad command line format\r\nEND\r\n";
+  EXPECT_EQ(client.expect("set " + std::string(300, 'k') +
+                              " 0 0 7\r\nbogus x\r\nget nothing\r\n",
+                          reply),
+            reply);
+  reply = "CLIENT_ERROR bad command line format\r\nEND\r\n";
+  EXPECT_EQ(client.expect("set k x 0 3\r\nget\r\nget nothing\r\n", reply),
+            reply);
+
+  // 很大的绝对过期时间截断而不溢出，条目不会立即过期
+  reply = "STORED\r\n";
+  EXPECT_EQ(client.expect("set far 0 9223372036854775807 1\r\nY\r\n", reply),
+            reply);
+  reply = "VALUE far 0 1\r\nY\r\nEND\r\n";
+  EXPECT_EQ(client.expect("get far\r\n", reply), reply);
+}
+
+TEST_F(MemcacheServerTest, UnixSocketAndManyConnections) {
+  LoopbackClient unixClient(server->getOptions().unixPath);
+  ASSERT_TRUE(unixClient.connected);
+  std::string reply = "STORED\r\n";
+  EXPECT_EQ(unixClient.expect("set shared 0 0 4\r\nunix\r\n", reply), reply);
+
+  // TCP连接分布在不同事件循环上，看到同一份数据
+  std::vector<std::unique_ptr<LoopbackClient>> clients;
+  for (int i = 0; i < 8; ++i) {
+    clients.push_back(std::make_unique<LoopbackClient>(server->getPort()));
+    ASSERT_TRUE(clients.back()->connected);
+  }
+  reply = "VALUE shared 0 4\r\nunix\r\nEND\r\n";
+  for (auto &client : clients) {
+    EXPECT_EQ(client->expect("get shared\r\n", reply), reply);
+  }
+}
+
+// 流水线请求之后对端半关闭：服务端先发完所有回复（超过套接字缓冲区，需要等待可写）再关闭
+TEST_F(MemcacheServerTest, HalfCloseDrainsReplies) {
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+  std::string value(500000, 'v');
+  std::string reply = "STORED\r\n";
+  EXPECT_EQ(client.expect("set big 0 0 " + std::to_string(value.size()) +
+                              "\r\n" + value + "\r\n",
+                          reply),
+            reply);
+
+  std::string request;
+  std::string expected;
+  for (int i = 0; i < 20; ++i) {
+    request += "get big\r\n";
+    expected += "VALUE big 0 " + std::to_string(value.size()) + "\r\n" +
+                value + "\r\nEND\r\n";
+  }
+  client.roundTrip(request, 0);
+  client.shutdownWrite();
+  std::string received = client.roundTrip("", expected.size() + 1);
+  EXPECT_EQ(received.size(), expected.size());
+  EXPECT_TRUE(received == expected);
+}
+
+// DEL/TTL/EXPIRE的查找用peek，不算访问：TTL之后a仍是LRU端，写入c时被淘汰
+TEST(CacheStoreTest, ReadOnlyPathsDoNotPromote) {
+  XCache::XCacheStore store("lru", 2, 1);
+  XCache::XCacheItem item;
+  item.data = "1";
+  store.set("a", item);
+  store.set("b", item);
+  EXPECT_EQ(store.ttl("a"), -1);
+  EXPECT_FALSE(store.remove("missing"));
+  EXPECT_FALSE(store.expire("missing", 0));
+  store.set("c", item);
+  EXPECT_FALSE(store.get("a", item));
+  EXPECT_TRUE(store.get("b", item));
+
+  // 过期条目在peek路径上同样惰性删除
+  item.expireAt = XCache::XCacheStore::nowMs() - 1;
+  store.set("d", item);
+  EXPECT_EQ(store.ttl("d"), -2);
+  EXPECT_FALSE(store.remove("d"));
+  EXPECT_EQ(store.getStats().expired, 1u);
+  EXPECT_EQ(store.getStats().removes, 0u);
+}
+
+class RespServerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    XCache::XServerOptions options;
+    options.host = "127.0.0.1";
+    options.port = 0;
+    options.threads = 2;
+    options.protocol = "resp";
+    options.capacity = 1000;
+    options.shards = 4;
+    server = std::make_unique<XCache::XCacheServer>(options);
+    server->start();
+  }
+
+  void TearDown() override { server->stop(); }
+
+  std::unique_ptr<XCache::XCacheServer> server;
+};
+
+TEST_F(RespServerTest, BasicCommands) {
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+
+  std::string reply = "+PONG\r\n";
+  EXPECT_EQ(client.expect("*1\r\n$4\r\nPING\r\n", reply), reply);
+  reply = "+OK\r\n";
+  EXPECT_EQ(client.expect("*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n",
+                          reply),
+            reply);
+  reply = "$3\r\nbar\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nget\r\n$3\r\nfoo\r\n", reply), reply);
+  reply = "$-1\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nGET\r\n$4\r\nnone\r\n", reply), reply);
+
+  reply = "+OK\r\n";
+  EXPECT_EQ(client.expect("*5\r\n$4\r\nMSET\r\n$1\r\na\r\n$1\r\n1\r\n"
+                          "$1\r\nb\r\n$2\r\n22\r\n",
+                          reply),
+            reply);
+  reply = "*3\r\n$1\r\n1\r\n$-1\r\n$2\r\n22\r\n";
+  EXPECT_EQ(client.expect("*4\r\n$4\r\nMGET\r\n$1\r\na\r\n$1\r\nx\r\n"
+                          "$1\r\nb\r\n",
+                          reply),
+            reply);
+
+  reply = ":-1\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nTTL\r\n$1\r\na\r\n", reply), reply);
+  reply = ":1\r\n";
+  EXPECT_EQ(client.expect("*3\r\n$6\r\nEXPIRE\r\n$1\r\na\r\n$3\r\n100\r\n",
+                          reply),
+            reply);
+  reply = ":100\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nTTL\r\n$1\r\na\r\n", reply), reply);
+  reply = ":-2\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nTTL\r\n$1\r\nx\r\n", reply), reply);
+
+  // 换算成毫秒后超出int64_t的过期时间被拒绝，不会回绕成已过期
+  reply = "-ERR invalid expire time in 'set' command\r\n";
+  EXPECT_EQ(client.expect("SET big v EX 9223372036854775\r\n", reply), reply);
+  EXPECT_EQ(client.expect("SET big v PX 9223372036854775807\r\n", reply),
+            reply);
+  reply = "-ERR invalid expire time in 'expire' command\r\n";
+  EXPECT_EQ(client.expect("EXPIRE a 9223372036854775\r\n", reply), reply);
+  reply = ":100\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nTTL\r\n$1\r\na\r\n", reply), reply);
+
+  reply = ":2\r\n";
+  EXPECT_EQ(client.expect("*4\r\n$3\r\nDEL\r\n$1\r\na\r\n$1\r\nb\r\n"
+                          "$1\r\nx\r\n",
+                          reply),
+            reply);
+  reply = "-ERR unknown command 'NOPE'\r\n";
+  EXPECT_EQ(client.expect("*1\r\n$4\r\nNOPE\r\n", reply), reply);
+  reply = "-ERR wrong number of arguments for 'get' command\r\n";
+  EXPECT_EQ(client.expect("*1\r\n$3\r\nGET\r\n", reply), reply);
+
+  std::string info = client.roundTrip("*1\r\n$4\r\nINFO\r\n", 64);
+  EXPECT_EQ(info.rfind("$", 0), 0u) << info;
+  EXPECT_NE(info.find("keyspace_hits:"), std::string::npos) << info;
+}
+
+// 超过单条命令上限的bulk在读到长度时即回复协议错误，不等数据到齐后被事件循环断开
+TEST_F(RespServerTest, RejectsOversizedBulk) {
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+  std::string reply = "-ERR Protocol error\r\n";
+  EXPECT_EQ(client.expect("*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$40000000\r\n",
+                          reply),
+            reply);
+}
+
+TEST_F(RespServerTest, PipelinedAndInlineCommands) {
+  LoopbackClient client(server->getPort());
+  ASSERT_TRUE(client.connected);
+
+  // 一次写入多条命令，中间的GET/MGET合并为一次批量查询
+  std::string request = "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$1\r\nv\r\n"
+                        "*2\r\n$3\r\nGET\r\n$1\r\nk\r\n"
+                        "*3\r\n$4\r\nMGET\r\n$1\r\nk\r\n$1\r\nz\r\n"
+                        "*2\r\n$3\r\nGET\r\n$1\r\nz\r\n"
+                        "*2\r\n$3\r\nDEL\r\n$1\r\nk\r\n"
+                        "*2\r\n$3\r\nGET\r\n$1\r\nk\r\n";
+  std::string reply = "+OK\r\n"
+                      "$1\r\nv\r\n"
+                      "*2\r\n$1\r\nv\r\n$-1\r\n"
+                      "$-1\r\n"
+                      ":1\r\n"
+                      "$-1\r\n";
+  EXPECT_EQ(client.expect(request, reply), reply);
+
+  // 内联命令
+  reply = "+OK\r\n$5\r\nhello\r\n";
+  EXPECT_EQ(client.expect("SET greeting hello\r\nGET greeting\r\n", reply),
+            reply);
+
+  // 批量参数被拆成多次到达
+  std::string partial =
+      client.roundTrip("*3\r\n$3\r\nSET\r\n$3\r\nbig\r\n$10\r\n01234", 0);
+  EXPECT_EQ(partial, "");
+  reply = "+OK\r\n";
+  EXPECT_EQ(client.expect("56789\r\n", reply), reply);
+  reply = "$10\r\n0123456789\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nGET\r\n$3\r\nbig\r\n", reply), reply);
+
+  // 大value走writev零拷贝路径
+  std::string large(100000, 'L');
+  reply = "+OK\r\n";
+  EXPECT_EQ(client.expect("*3\r\n$3\r\nSET\r\n$5\r\nlarge\r\n$100000\r\n" +
+                              large + "\r\n",
+                          reply),
+            reply);
+  reply = "$100000\r\n" + large + "\r\n";
+  EXPECT_EQ(client.expect("*2\r\n$3\r\nGET\r\n$5\r\nlarge\r\n", reply), reply);
+}
+
+TEST(IoUringServerTest, PipelinedAndLinkedSends) {
+  if (!XCache::XUringLoop::isSupported())
+    GTEST_SKIP() << "io_uring unavailable";
+  XCache::XServerOptions options;
+  options.host = "127.0.0.1";
+  options.port = 0;
+  options.threads = 2;
+  options.protocol = "resp";
+  options.backend = "io_uring";
+  options.capacity = 10000;
+  options.shards = 4;
+  XCache::XCacheServer server(options);
+  ASSERT_EQ(server.getBackend(), "io_uring");
+  server.start();
+
+  LoopbackClient client(server.getPort());
+  ASSERT_TRUE(client.connected);
+  std::string reply = "+OK\r\n$1\r\nv\r\n$-1\r\n";
+  EXPECT_EQ(client.expect("SET k v\r\nGET k\r\nGET missing\r\n", reply),
+            reply);
+
+  // 1000个大value的MGET产生上千个iovec，需要拆成多个链接的sendmsg
+  std::string mset = "*2001\r\n$4\r\nMSET\r\n";
+  std::string mget = "*1001\r\n$4\r\nMGET\r\n";
+  std::string expected = "*1000\r\n";
+  for (int i = 0; i < 1000; ++i) {
+    std::string key = "key" + std::to_string(i);
+    std::string value(300, char('a' + i % 26));
+    mset += "$" + std::to_string(key.size()) + "\r\n" + key + "\r\n$300\r\n" +
+            value + "\r\n";
+    mget += "$" + std::to_string(key.size()) + "\r\n" + key + "\r\n";
+    expected += "$300\r\n" + value + "\r\n";
+  }
+  reply = "+OK\r\n";
+  EXPECT_EQ(client.expect(mset, reply), reply);
+  std::string got = client.expect(mget, expected);
+  EXPECT_EQ(got.size(), expected.size());
+  EXPECT_TRUE(got == expected);
+
+  std::vector<std::unique_ptr<LoopbackClient>> clients;
+  for (int i = 0; i < 16; ++i) {
+    clients.push_back(std::make_unique<LoopbackClient>(server.getPort()));
+    ASSERT_TRUE(clients.back()->connected);
+  }
+  reply = "$1\r\nv\r\n";
+  for (auto &c : clients)
+    EXPECT_EQ(c->expect("GET k\r\n", reply), reply);
+  reply = "+OK\r\n";
+  EXPECT_EQ(clients[0]->expect("QUIT\r\n", reply), reply);
+
+  // 请求与EOF可能在同一批完成事件中到达：回复仍要发出，连接在发完后释放
+  std::vector<std::unique_ptr<LoopbackClient>> closers;
+  for (int i = 0; i < 50; ++i) {
+    closers.push_back(std::make_unique<LoopbackClient>(server.getPort()));
+    ASSERT_TRUE(closers.back()->connected);
+  }
+  for (int i = 0; i < 50; ++i) {
+    std::string request = "SET c" + std::to_string(i) + " v\r\n";
+    closers[i]->roundTrip(request, 0);
+    closers[i]->shutdownWrite();
+  }
+  for (auto &c : closers)
+    EXPECT_EQ(c->roundTrip("", reply.size()), reply);
+  server.stop();
+}
+
+TEST(TraceTest, FormatsAndBinaryRoundTrip) {
+  namespace fs = std::filesystem;
+  fs::path dir = fs::path(::testing::TempDir()) / "xcache_trace_test";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  auto writeFile = [&](const char *name, const std::string &content) {
+    std::ofstream(dir / name) << content;
+    return (dir / name).string();
+  };
+  auto readAll = [](const std::string &path, const std::string &format) {
+    XCache::XTraceReader reader(path, XCache::parseTraceFormat(format));
+    std::vector<XCache::XTraceRequest> all;
+    XCache::XTraceRequest chunk[3]; // 小块读取，覆盖跨块的ARC展开
+    while (size_t n = reader.next(chunk, 3))
+      all.insert(all.end(), chunk, chunk + n);
+    return all;
+  };
+
+  auto lirs = readAll(writeFile("t.lirs", "5\n7\n*\n5\n"), "lirs");
+  ASSERT_EQ(lirs.size(), 3u);
+  EXPECT_EQ(lirs[2].key, 5u);
+
+  auto arc = readAll(writeFile("t.arc", "100 4 0 1\n7 1 0 2\n"), "arc");
+  ASSERT_EQ(arc.size(), 5u);
+  EXPECT_EQ(arc[3].key, 103u);
+  EXPECT_EQ(arc[4].key, 7u);
+
+  auto msr = readAll(
+      writeFile("t.csv", "Timestamp,Hostname,DiskNumber,Type,Offset,Size,"
+                         "ResponseTime\r\n1,web,0,Read,4096,8192,10\r\n"
+                         "2,web,0,Write,0,512,10\r\n"),
+      "msr");
+  ASSERT_EQ(msr.size(), 2u); // 表头被跳过
+  EXPECT_EQ(msr[0].key, 4096u);
+  EXPECT_EQ(msr[0].size, 8192u);
+  EXPECT_FALSE(msr[0].write);
+  EXPECT_TRUE(msr[1].write);
+
+  std::string binPath = (dir / "t.bin").string();
+  {
+    XCache::XTraceWriter writer(binPath);
+    for (auto &req : msr)
+      writer.append(req);
+  }
+  auto bin = readAll(binPath, "bin");
+  ASSERT_EQ(bin.size(), 2u);
+  EXPECT_EQ(bin[1].key, 0u);
+  EXPECT_EQ(bin[1].size, 512u);
+  EXPECT_TRUE(bin[1].write);
+
+  // 录制记录中的Remove不当作写，回放时跳过；12字节记录无法表示Remove，写入时丢弃
+  for (bool events : {true, false}) {
+    std::string eventsPath = (dir / "e.bin").string();
+    {
+      XCache::XTraceWriter writer(eventsPath, events);
+      for (auto op : {XCache::XTraceOp::Put, XCache::XTraceOp::Remove,
+                      XCache::XTraceOp::Get, XCache::XTraceOp::Remove}) {
+        XCache::XTraceEvent event;
+        event.key = 9;
+        event.size = 64;
+        event.op = op;
+        writer.append(event);
+      }
+    }
+    auto replay = readAll(eventsPath, "bin");
+    ASSERT_EQ(replay.size(), 2u) << events;
+    EXPECT_TRUE(replay[0].write) << events;
+    EXPECT_FALSE(replay[1].write) << events;
+  }
+
+  // 字节命中率按对象大小加权
+  XCache::XSimRun run("lru", 10);
+  std::vector<XCache::XTraceRequest> reqs = {
+      {1, 100, false}, {2, 900, false}, {1, 100, false}, {1, 100, false}};
+  run.feed(reqs.data(), reqs.size());
+  EXPECT_DOUBLE_EQ(run.hitRatio(), 0.5);
+  EXPECT_DOUBLE_EQ(run.byteHitRatio(), 200.0 / 1200.0);
+  fs::remove_all(dir);
+}
+
+TEST(TraceTest, ParallelSimulationMatchesSequential) {
+  std::string path = ::testing::TempDir() + "xcache_parallel.bin";
+  std::vector<XCache::XTraceRequest> reqs;
+  std::mt19937 gen(42);
+  {
+    XCache::XTraceWriter writer(path);
+    for (int i = 0; i < 50000; ++i) {
+      uint64_t key = gen() % 100 < 80 ? gen() % 200 : gen() % 5000;
+      XCache::XTraceRequest req{key, 100 + uint32_t(key % 7) * 50, false};
+      writer.append(req);
+      reqs.push_back(req);
+    }
+  }
+
+  std::vector<std::unique_ptr<XCache::XSimRun>> runs;
+  for (const char *policy : {"lru", "lfu", "arc"}) {
+    for (size_t capacity : {50, 500})
+      runs.push_back(std::make_unique<XCache::XSimRun>(policy, capacity));
+  }
+  // 小块、少槽位，覆盖反压与块复用
+  XCache::XTraceReader reader(path, XCache::parseTraceFormat("bin"));
+  XCache::XParallelSimulator simulator(runs, 3, 3, 1000);
+  EXPECT_EQ(simulator.run(reader), reqs.size());
+
+  for (auto &run : runs) {
+    XCache::XSimRun expected(run->getPolicy(), run->getCapacity());
+    expected.feed(reqs.data(), reqs.size());
+    EXPECT_EQ(run->getRequests(), reqs.size());
+    EXPECT_DOUBLE_EQ(run->hitRatio(), expected.hitRatio()) << run->getPolicy();
+    EXPECT_DOUBLE_EQ(run->byteHitRatio(), expected.byteHitRatio());
+  }
+  std::remove(path.c_str());
+}
+
+// 录制器：多线程写入的事件全部落盘，按key哈希采样时同一key要么全录要么全不录
+TEST(TraceTest, RecorderSamplesByKeyHash) {
+  const std::string path = "/tmp/xcache_recorder_test.bin";
+  for (double rate : {1.0, 0.25}) {
+    XCache::XTraceRecorderOptions options;
+    options.sampleRate = rate;
+    options.flushInterval = std::chrono::milliseconds(1);
+    auto recorder = std::make_shared<XCache::XTraceRecorder>(path, options);
+    XCache::XTracedCache<int, std::string> cache(
+        std::make_unique<XCache::XLRUCache<int, std::string>>(1000), recorder);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&cache, t] {
+        std::string value;
+        for (int i = 0; i < 5000; ++i) {
+          int key = (i * 7 + t) % 400;
+          if (i % 4 == 0)
+            cache.put(key, std::string(10 + key % 5, 'v'));
+          else
+            cache.get(key, value);
+        }
+      });
+    }
+    for (auto &th : threads)
+      th.join();
+    recorder->close();
+    EXPECT_EQ(recorder->getDropped(), 0u);
+
+    std::set<uint64_t> sampledKeys;
+    for (int key = 0; key < 400; ++key) {
+      uint64_t h = XCache::XTraceRecorder::hashKey(std::hash<int>()(key));
+      if (recorder->sampled(h))
+        sampledKeys.insert(h);
+    }
+    // 采样的key有若干次访问，全部写入trace
+    uint64_t expected = 0;
+    uint64_t expectedWrites = 0;
+    for (int t = 0; t < 4; ++t) {
+      for (int i = 0; i < 5000; ++i) {
+        int key = (i * 7 + t) % 400;
+        size_t hit = sampledKeys.count(
+            XCache::XTraceRecorder::hashKey(std::hash<int>()(key)));
+        expected += hit;
+        expectedWrites += i % 4 == 0 ? hit : 0;
+      }
+    }
+    if (rate == 1.0)
+      EXPECT_EQ(expected, 20000u);
+    else
+      EXPECT_NEAR(sampledKeys.size() / 400.0, rate, 0.1);
+    EXPECT_EQ(recorder->getRecorded(), expected);
+
+    // 16字节录制记录可由XTraceReader直接读取
+    XCache::XTraceReader reader(path, XCache::parseTraceFormat("bin"));
+    std::vector<XCache::XTraceRequest> reqs(30000);
+    size_t n = reader.next(reqs.data(), reqs.size());
+    ASSERT_EQ(n, expected);
+    size_t writes = 0;
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_TRUE(sampledKeys.count(reqs[i].key));
+      if (reqs[i].write) {
+        writes++;
+        EXPECT_GE(reqs[i].size, 10u);
+      }
+    }
+    EXPECT_EQ(writes, expectedWrites);
+  }
+  std::remove(path.c_str());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "XCacheStore.h"
+#include "XEventLoop.h"
+#include "XMemcacheProtocol.h"
+#include "XRespProtocol.h"
+#include "XUringLoop.h"
+
+namespace XCache {
+struct XServerOptions {
+  std::string host = "0.0.0.0";
+  int port = 11211;      // 0表示由系统分配（测试用）
+  std::string unixPath;  // 非空时额外监听Unix套接字
+  size_t threads = 0;    // 事件循环数量，0表示每核一个
+  bool pinThreads = false; // 将第i个循环绑定到第i个CPU
+  std::string protocol = "memcache"; // memcache|resp
+  std::string backend = "epoll";     // epoll|io_uring（内核不支持时退回epoll）
+  std::string policy = "lru";
+  size_t capacity = 1000000;
+  size_t shards = 64;
+};
+
+// 缓存服务：每个事件循环独占一个SO_REUSEPORT监听套接字，由内核分发新连接
+class XCacheServer {
+public:
+  explicit XCacheServer(XServerOptions options)
+      : options(std::move(options)),
+        store(this->options.policy, this->options.capacity,
+              this->options.shards) {
+    if (this->options.threads == 0)
+      this->options.threads =
+          std::max(1u, std::thread::hardware_concurrency());
+    if (this->options.protocol != "memcache" &&
+        this->options.protocol != "resp")
+      throw std::invalid_argument("unknown protocol: " +
+                                  this->options.protocol);
+    if (this->options.backend != "epoll" &&
+        this->options.backend != "io_uring")
+      throw std::invalid_argument("unknown backend: " + this->options.backend);
+    if (this->options.backend == "io_uring" && !XUringLoop::isSupported())
+      this->options.backend = "epoll";
+  }
+
+  ~XCacheServer() { stop(); }
+
+  XCacheServer(const XCacheServer &) = delete;
+  XCacheServer &operator=(const XCacheServer &) = delete;
+
+  // 创建监听套接字并在后台线程中运行所有事件循环
+  void start() {
+    int unixFd = options.unixPath.empty() ? -1 : listenUnix(options.unixPath);
+    for (size_t i = 0; i < options.threads; ++i) {
+      std::unique_ptr<XServerLoop> loop = makeLoop();
+      if (options.port >= 0) {
+        int fd = listenTcp(options.host, boundPort ? boundPort : options.port);
+        loop->addListener(fd, false);
+        ownedFds.push_back(fd);
+      }
+      if (unixFd >= 0)
+        loop->addListener(unixFd, true);
+      loops.push_back(std::move(loop));
+    }
+    if (unixFd >= 0)
+      ownedFds.push_back(unixFd);
+    for (size_t i = 0; i < loops.size(); ++i) {
+      threads.emplace_back([this, i] { loops[i]->run(); });
+      if (options.pinThreads)
+        pinThread(threads.back(), i);
+    }
+  }
+
+  void stop() {
+    for (auto &loop : loops)
+      loop->stop();
+    for (auto &t : threads) {
+      if (t.joinable())
+        t.join();
+    }
+    threads.clear();
+    loops.clear();
+    for (int fd : ownedFds)
+      ::close(fd);
+    ownedFds.clear();
+    if (!options.unixPath.empty())
+      ::unlink(options.unixPath.c_str());
+  }
+
+  // 实际监听的TCP端口（options.port为0时由系统分配）
+  int getPort() const { return boundPort; }
+
+  XCacheStore &getStore() { return store; }
+
+  const XServerOptions &getOptions() const { return options; }
+
+  // 实际使用的事件循环后端
+  const std::string &getBackend() const { return options.backend; }
+
+private:
+  std::unique_ptr<XProtocolHandler> makeHandler() {
+    if (options.protocol == "resp")
+      return std::make_unique<XRespProtocol>(store);
+    return std::make_unique<XMemcacheProtocol>(store);
+  }
+
+  std::unique_ptr<XServerLoop> makeLoop() {
+    if (options.backend == "io_uring")
+      return std::make_unique<XUringLoop>(makeHandler());
+    return std::make_unique<XEventLoop>(makeHandler());
+  }
+
+  int listenTcp(const std::string &host, int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+      throw std::runtime_error("socket() failed");
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+      ::close(fd);
+      throw std::invalid_argument("invalid listen address: " + host);
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 1024) != 0) {
+      ::close(fd);
+      throw std::runtime_error("cannot listen on " + host + ":" +
+                               std::to_string(port) + ": " +
+                               std::strerror(errno));
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    boundPort = ntohs(addr.sin_port);
+    return fd;
+  }
+
+  int listenUnix(const std::string &path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+      throw std::runtime_error("socket() failed");
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      ::close(fd);
+      throw std::invalid_argument("unix socket path too long: " + path);
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 1024) != 0) {
+      ::close(fd);
+      throw std::runtime_error("cannot listen on " + path + ": " +
+                               std::strerror(errno));
+    }
+    return fd;
+  }
+
+  static void pinThread(std::thread &t, size_t index) {
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    ::pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+  }
+
+  XServerOptions options;
+  XCacheStore store;
+  int boundPort = 0;
+  std::vector<std::unique_ptr<XServerLoop>> loops;
+  std::vector<std::thread> threads;
+  std::vector<int> ownedFds;
+};
+} // namespace XCache
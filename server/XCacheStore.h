@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../XCacheFactory.h"
+
+namespace XCache {
+// 服务端存储的条目：数据 + 协议元信息
+struct XCacheItem {
+  std::string data;
+  uint32_t flags = 0;
+  uint64_t cas = 0;
+  int64_t expireAt = 0; // 过期时间（unix毫秒），0表示永不过期
+};
+
+// 分片存储：每个分片一个引擎和一把锁，读改写操作（incr等）在分片锁内完成
+class XCacheStore {
+public:
+  enum class IncrResult { Ok, NotFound, NonNumeric };
+
+  XCacheStore(const std::string &policy, size_t capacity, size_t shardNum = 16)
+      : shardNum(shardNum == 0 ? 1 : shardNum), policy(policy) {
+    size_t shardCapacity = static_cast<size_t>(
+        std::ceil(capacity / static_cast<double>(this->shardNum)));
+    for (size_t i = 0; i < this->shardNum; ++i) {
+      shards.emplace_back(new Shard{
+          makeCachePolicy<std::string, XCacheItem>(policy, shardCapacity),
+          {}, {}});
+    }
+  }
+
+  bool get(const std::string &key, XCacheItem &item) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    bool hit = getLocked(shard, key, item);
+    shard.stats.gets++;
+    shard.stats.hits += hit;
+    return hit;
+  }
+
+  // 批量查询：同一分片的key只加一次锁
+  void getMany(const std::vector<std::string> &keys,
+               std::vector<XCacheItem> &items, std::vector<char> &found) {
+    items.resize(keys.size());
+    found.assign(keys.size(), 0);
+    std::vector<std::vector<size_t>> byShard(shardNum);
+    for (size_t i = 0; i < keys.size(); ++i)
+      byShard[shardIndex(keys[i])].push_back(i);
+    for (size_t s = 0; s < shardNum; ++s) {
+      if (byShard[s].empty())
+        continue;
+      Shard &shard = *shards[s];
+      std::lock_guard<std::mutex> lock(shard.mtx);
+      for (size_t i : byShard[s]) {
+        found[i] = getLocked(shard, keys[i], items[i]);
+        shard.stats.hits += found[i];
+      }
+      shard.stats.gets += byShard[s].size();
+    }
+  }
+
+  uint64_t set(const std::string &key, XCacheItem item) {
+    Shard &shard = shardFor(key);
+    item.cas = nextCas.fetch_add(1, std::memory_order_relaxed);
+    uint64_t cas = item.cas;
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    shard.engine->put(key, std::move(item));
+    shard.stats.sets++;
+    return cas;
+  }
+
+  bool remove(const std::string &key) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    XCacheItem item;
+    if (!peekLocked(shard, key, item))
+      return false;
+    shard.engine->remove(key);
+    shard.stats.removes++;
+    return true;
+  }
+
+  // 数值自增：值按十进制无符号整数解释，溢出时回绕（与memcached一致）
+  IncrResult incr(const std::string &key, uint64_t delta, uint64_t &result) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    XCacheItem item;
+    if (!getLocked(shard, key, item))
+      return IncrResult::NotFound;
+    uint64_t current = 0;
+    if (item.data.empty() || item.data.size() > 20)
+      return IncrResult::NonNumeric;
+    for (char c : item.data) {
+      if (c < '0' || c > '9')
+        return IncrResult::NonNumeric;
+      current = current * 10 + uint64_t(c - '0');
+    }
+    result = current + delta;
+    item.data = std::to_string(result);
+    item.cas = nextCas.fetch_add(1, std::memory_order_relaxed);
+    shard.engine->put(key, std::move(item));
+    return IncrResult::Ok;
+  }
+
+  // 设置过期时间（unix毫秒，0表示取消过期），key不存在时返回false；
+  // 查找不算访问，写回的put与SET一样更新引擎中的位置
+  bool expire(const std::string &key, int64_t expireAt) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    XCacheItem item;
+    if (!peekLocked(shard, key, item))
+      return false;
+    if (expireAt != 0 && expireAt <= nowMs()) {
+      shard.engine->remove(key);
+      return true;
+    }
+    item.expireAt = expireAt;
+    shard.engine->put(key, std::move(item));
+    return true;
+  }
+
+  // 剩余生存时间（毫秒）：-2表示不存在，-1表示永不过期；不算访问，不改变淘汰顺序与频率
+  int64_t ttl(const std::string &key) {
+    Shard &shard = shardFor(key);
+    XCacheItem item;
+    {
+      std::lock_guard<std::mutex> lock(shard.mtx);
+      if (!peekLocked(shard, key, item))
+        return -2;
+    }
+    if (item.expireAt == 0)
+      return -1;
+    return std::max<int64_t>(0, item.expireAt - nowMs());
+  }
+
+  struct Stats {
+    uint64_t gets = 0;
+    uint64_t hits = 0;
+    uint64_t sets = 0;
+    uint64_t removes = 0;
+    uint64_t expired = 0;
+  };
+
+  // 汇总各分片的计数（分片计数在分片锁内更新，不引入额外的原子竞争）
+  Stats getStats() {
+    Stats total;
+    for (auto &shard : shards) {
+      std::lock_guard<std::mutex> lock(shard->mtx);
+      total.gets += shard->stats.gets;
+      total.hits += shard->stats.hits;
+      total.sets += shard->stats.sets;
+      total.removes += shard->stats.removes;
+      total.expired += shard->stats.expired;
+    }
+    return total;
+  }
+
+  const std::string &getPolicy() const { return policy; }
+  size_t getShardNum() const { return shardNum; }
+
+  static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+private:
+  struct Shard {
+    std::unique_ptr<XCachePolicy<std::string, XCacheItem>> engine;
+    std::mutex mtx;
+    Stats stats;
+  };
+
+  size_t shardIndex(const std::string &key) const {
+    return std::hash<std::string>{}(key) % shardNum;
+  }
+
+  Shard &shardFor(const std::string &key) { return *shards[shardIndex(key)]; }
+
+  // 惰性过期：读到过期条目时删除并视为未命中
+  bool getLocked(Shard &shard, const std::string &key, XCacheItem &item) {
+    if (!shard.engine->get(key, item))
+      return false;
+    return !expireLocked(shard, key, item);
+  }
+
+  // 同getLocked，但用peek读取：DEL/TTL/EXPIRE不算访问，不提升LRU位置、不增加频率
+  bool peekLocked(Shard &shard, const std::string &key, XCacheItem &item) {
+    if (!shard.engine->peek(key, item))
+      return false;
+    return !expireLocked(shard, key, item);
+  }
+
+  bool expireLocked(Shard &shard, const std::string &key,
+                    const XCacheItem &item) {
+    if (item.expireAt == 0 || item.expireAt > nowMs())
+      return false;
+    shard.engine->remove(key);
+    shard.stats.expired++;
+    return true;
+  }
+
+  size_t shardNum;
+  std::string policy;
+  std::vector<std::unique_ptr<Shard>> shards;
+  std::atomic<uint64_t> nextCas{1};
+};
+} // namespace XCache
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <errno.h>
+#include <limits.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace XCache {
+// 回复输出队列：协议头等小片段拷贝进scratch，大块的值以所有权转移的方式挂在队列上，
+// 发送时按片段组装iovec，用writev一次写出（scatter/gather）
+class XOutputQueue {
+public:
+  void append(std::string_view bytes) {
+    if (bytes.empty())
+      return;
+    if (!segments.empty() && segments.back().source == kScratch &&
+        segments.back().offset + segments.back().length == scratch.size()) {
+      segments.back().length += bytes.size();
+    } else {
+      segments.push_back({kScratch, scratch.size(), bytes.size()});
+    }
+    scratch.append(bytes.data(), bytes.size());
+  }
+
+  // 接管value的内存，避免把值拷贝进发送缓冲
+  void appendOwned(std::string &&value) {
+    if (value.size() < kCopyThreshold) {
+      append(value);
+      return;
+    }
+    owned.push_back(std::move(value));
+    segments.push_back({owned.size() - 1, 0, owned.back().size()});
+  }
+
+  XOutputQueue &operator+=(std::string_view bytes) {
+    append(bytes);
+    return *this;
+  }
+  XOutputQueue &operator+=(char c) {
+    append(std::string_view(&c, 1));
+    return *this;
+  }
+
+  bool empty() const { return next == segments.size(); }
+
+  size_t pendingBytes() const {
+    size_t total = 0;
+    for (size_t i = next; i < segments.size(); ++i)
+      total += segments[i].length;
+    return total;
+  }
+
+  // 按顺序填充iovec，返回个数
+  int fill(iovec *iov, int maxIov) const {
+    int n = 0;
+    for (size_t i = next; i < segments.size() && n < maxIov; ++i, ++n) {
+      const Segment &seg = segments[i];
+      const char *base =
+          seg.source == kScratch ? scratch.data() : owned[seg.source].data();
+      iov[n].iov_base = const_cast<char *>(base + seg.offset);
+      iov[n].iov_len = seg.length;
+    }
+    return n;
+  }
+
+  // 标记已发送的字节，全部发完时复用内存
+  void consume(size_t bytes) {
+    while (bytes > 0 && next < segments.size()) {
+      Segment &seg = segments[next];
+      size_t step = std::min(bytes, seg.length);
+      seg.offset += step;
+      seg.length -= step;
+      bytes -= step;
+      if (seg.length == 0)
+        next++;
+    }
+    if (next == segments.size())
+      clear();
+  }
+
+  void clear() {
+    scratch.clear();
+    owned.clear();
+    segments.clear();
+    next = 0;
+  }
+
+  // 测试与调试用：拼出尚未发送的全部字节
+  std::string str() const {
+    std::string result;
+    for (size_t i = next; i < segments.size(); ++i) {
+      const Segment &seg = segments[i];
+      const char *base =
+          seg.source == kScratch ? scratch.data() : owned[seg.source].data();
+      result.append(base + seg.offset, seg.length);
+    }
+    return result;
+  }
+
+private:
+  static constexpr size_t kScratch = size_t(-1);
+  static constexpr size_t kCopyThreshold = 256; // 小值直接拷贝更划算
+
+  struct Segment {
+    size_t source; // kScratch或owned中的下标
+    size_t offset;
+    size_t length;
+  };
+
+  std::string scratch;
+  std::deque<std::string> owned;
+  std::vector<Segment> segments;
+  size_t next = 0; // 第一个未发送完的片段
+};
+
+// 一个客户端连接的读写缓冲
+struct XConnection {
+  int fd = -1;
+  std::vector<char> in; // 已读入、尚未被协议消费的字节
+  size_t inStart = 0;
+  XOutputQueue out; // 待发送的回复
+  bool closing = false; // 发送完剩余数据后关闭（如quit）
+  bool readClosed = false; // 对端已半关闭（读到EOF），不再关注可读
+  bool writeArmed = false;
+};
+
+// 单连接未消费输入的上限，事件循环超过时关闭连接；协议的单条请求上限要小于它
+inline constexpr size_t kMaxConnectionInput = 64u << 20;
+
+// 协议处理器：消费完整请求并把回复追加到conn.out，返回消费的字节数
+class XProtocolHandler {
+public:
+  virtual ~XProtocolHandler() = default;
+  virtual size_t process(XConnection &conn, const char *data, size_t len) = 0;
+};
+
+// 服务端事件循环接口：epoll与io_uring两种后端
+class XServerLoop {
+public:
+  virtual ~XServerLoop() = default;
+  // shared为true时监听套接字被多个循环共享
+  virtual void addListener(int fd, bool shared) = 0;
+  virtual void run() = 0;
+  // 可在其他线程调用，唤醒并结束run()
+  virtual void stop() = 0;
+};
+
+// epoll事件循环：每个线程一个，各自持有监听套接字（SO_REUSEPORT）和连接
+class XEventLoop : public XServerLoop {
+  static constexpr size_t kReadChunk = 64 * 1024;
+  static constexpr size_t kMaxInput = kMaxConnectionInput;
+
+public:
+  explicit XEventLoop(std::unique_ptr<XProtocolHandler> handler)
+      : handler(std::move(handler)) {
+    epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &wakeFd;
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev);
+  }
+
+  ~XEventLoop() {
+    for (auto &pair : connections)
+      ::close(pair.first);
+    ::close(wakeFd);
+    ::close(epfd);
+  }
+
+  // 共享的监听套接字用EPOLLEXCLUSIVE避免惊群
+  void addListener(int fd, bool shared) override {
+    listeners.push_back(fd);
+    epoll_event ev{};
+    ev.events = EPOLLIN | (shared ? uint32_t(EPOLLEXCLUSIVE) : 0u);
+    ev.data.ptr = &listeners.back();
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+  }
+
+  void run() override {
+    std::vector<epoll_event> events(256);
+    while (!stopping.load(std::memory_order_acquire)) {
+      int n = ::epoll_wait(epfd, events.data(), int(events.size()), -1);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        break;
+      }
+      for (int i = 0; i < n; ++i) {
+        void *ptr = events[i].data.ptr;
+        if (ptr == &wakeFd) {
+          uint64_t v;
+          (void)!::read(wakeFd, &v, sizeof(v));
+          continue;
+        }
+        if (isListener(ptr)) {
+          acceptAll(*static_cast<int *>(ptr));
+          continue;
+        }
+        auto *conn = static_cast<XConnection *>(ptr);
+        uint32_t mask = events[i].events;
+        if (mask & (EPOLLERR | EPOLLHUP)) {
+          closeConnection(conn);
+          continue;
+        }
+        if ((mask & EPOLLIN) && !onReadable(conn))
+          continue;
+        if (mask & EPOLLOUT)
+          onWritable(conn);
+      }
+    }
+  }
+
+  void stop() override {
+    stopping.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    (void)!::write(wakeFd, &one, sizeof(one));
+  }
+
+  size_t getConnectionCount() const { return connections.size(); }
+
+private:
+  bool isListener(void *ptr) const {
+    for (const int &fd : listeners) {
+      if (&fd == ptr)
+        return true;
+    }
+    return false;
+  }
+
+  void acceptAll(int listenFd) {
+    while (true) {
+      int fd = ::accept4(listenFd, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0)
+        return; // EAGAIN或被其他循环抢先
+      auto conn = std::make_unique<XConnection>();
+      conn->fd = fd;
+      epoll_event ev{};
+      ev.events = EPOLLIN | EPOLLRDHUP;
+      ev.data.ptr = conn.get();
+      ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+      connections.emplace(fd, std::move(conn));
+    }
+  }
+
+  // 读尽套接字后一次性处理所有完整请求（流水线），返回false表示连接已关闭。
+  // 对端半关闭（shutdown(SHUT_WR)）时先处理已读到的请求并发完回复再关闭
+  bool onReadable(XConnection *conn) {
+    bool peerClosed = false;
+    bool readFailed = false;
+    while (true) {
+      if (conn->inStart > 0 && conn->inStart == conn->in.size()) {
+        conn->in.clear();
+        conn->inStart = 0;
+      }
+      size_t used = conn->in.size();
+      conn->in.resize(used + kReadChunk);
+      ssize_t r = ::read(conn->fd, conn->in.data() + used, kReadChunk);
+      conn->in.resize(used + (r > 0 ? size_t(r) : 0));
+      if (r > 0) {
+        if (size_t(r) < kReadChunk)
+          break;
+        continue;
+      }
+      if (r == 0)
+        peerClosed = true;
+      else if (errno == EINTR)
+        continue;
+      else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        readFailed = true;
+      break;
+    }
+
+    size_t pending = conn->in.size() - conn->inStart;
+    if (pending > 0) {
+      size_t consumed =
+          handler->process(*conn, conn->in.data() + conn->inStart, pending);
+      conn->inStart += consumed;
+      if (conn->inStart == conn->in.size()) {
+        conn->in.clear();
+        conn->inStart = 0;
+      } else if (conn->inStart > kReadChunk) {
+        conn->in.erase(conn->in.begin(), conn->in.begin() + conn->inStart);
+        conn->inStart = 0;
+      }
+      if (conn->in.size() > kMaxInput)
+        conn->closing = true;
+    }
+
+    if (peerClosed) {
+      conn->closing = true;
+      conn->readClosed = true;
+      updateEvents(conn);
+    }
+    if (readFailed || !flush(conn)) {
+      closeConnection(conn);
+      return false;
+    }
+    return true;
+  }
+
+  void onWritable(XConnection *conn) {
+    if (!flush(conn))
+      closeConnection(conn);
+  }
+
+  // 用writev尽量写出回复；写不完时关注EPOLLOUT，返回false表示应关闭连接
+  bool flush(XConnection *conn) {
+    iovec iov[IOV_MAX];
+    while (!conn->out.empty()) {
+      int n = conn->out.fill(iov, IOV_MAX);
+      msghdr msg{};
+      msg.msg_iov = iov;
+      msg.msg_iovlen = size_t(n);
+      ssize_t w = ::sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+      if (w > 0) {
+        conn->out.consume(size_t(w));
+        continue;
+      }
+      if (w < 0 && errno == EINTR)
+        continue;
+      if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        armWrite(conn, true);
+        return true;
+      }
+      return false;
+    }
+    armWrite(conn, false);
+    return !conn->closing;
+  }
+
+  void armWrite(XConnection *conn, bool enable) {
+    if (conn->writeArmed == enable)
+      return;
+    conn->writeArmed = enable;
+    updateEvents(conn);
+  }
+
+  // 水平触发：半关闭后EOF一直可读，不再关注EPOLLIN，否则发送剩余回复期间会反复被唤醒
+  void updateEvents(XConnection *conn) {
+    epoll_event ev{};
+    ev.events = (conn->readClosed ? 0u : uint32_t(EPOLLIN | EPOLLRDHUP)) |
+                (conn->writeArmed ? uint32_t(EPOLLOUT) : 0u);
+    ev.data.ptr = conn;
+    ::epoll_ctl(epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+  }
+
+  void closeConnection(XConnection *conn) {
+    int fd = conn->fd;
+    ::epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+  }
+
+  std::unique_ptr<XProtocolHandler> handler;
+  int epfd = -1;
+  int wakeFd = -1;
+  std::list<int> listeners; // epoll中保存元素地址，需保证地址稳定
+  std::unordered_map<int, std::unique_ptr<XConnection>> connections;
+  std::atomic<bool> stopping{false};
+};
+} // namespace XCache
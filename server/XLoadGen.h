@@ -0,0 +1,279 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace XCache {
+// xcache_server的回环压测客户端（xcache_loadgen与bench共用）：每个线程持有若干连接，每个连接按流水线深度批量发送请求，
+// 统计吞吐量与每批请求的往返延迟
+struct XLoadOptions {
+  std::string host = "127.0.0.1";
+  int port = 11211;
+  std::string protocol = "memcache";
+  size_t threads = 1;
+  size_t connections = 4; // 每线程连接数
+  size_t pipeline = 16;   // 每批请求数
+  double seconds = 5;
+  size_t keys = 100000;
+  size_t valueSize = 32;
+  double getRatio = 0.9;
+};
+
+// 回复计数：返回buf中从offset开始的一个完整回复的长度，不完整时返回0
+inline size_t respReplyLength(const char *p, size_t n) {
+  if (n < 3)
+    return 0;
+  const char *crlf = static_cast<const char *>(std::memchr(p, '\n', n));
+  if (!crlf)
+    return 0;
+  size_t line = size_t(crlf - p) + 1;
+  long long v = std::atoll(p + 1);
+  switch (p[0]) {
+  case '$':
+    if (v < 0)
+      return line;
+    return n >= line + size_t(v) + 2 ? line + size_t(v) + 2 : 0;
+  case '*': {
+    size_t total = line;
+    for (long long i = 0; i < v; ++i) {
+      size_t len = respReplyLength(p + total, n - total);
+      if (len == 0)
+        return 0;
+      total += len;
+    }
+    return total;
+  }
+  default:
+    return line;
+  }
+}
+
+inline size_t memcacheReplyLength(const char *p, size_t n) {
+  size_t total = 0;
+  while (true) {
+    const char *crlf =
+        static_cast<const char *>(std::memchr(p + total, '\n', n - total));
+    if (!crlf)
+      return 0;
+    size_t line = size_t(crlf - (p + total)) + 1;
+    if (line >= 6 && std::memcmp(p + total, "VALUE ", 6) == 0) {
+      // VALUE <key> <flags> <bytes>
+      const char *lastSpace = p + total + line - 3;
+      while (*lastSpace != ' ')
+        --lastSpace;
+      size_t bytes = std::strtoull(lastSpace + 1, nullptr, 10);
+      total += line + bytes + 2;
+      if (total > n)
+        return 0;
+      continue;
+    }
+    return total + line;
+  }
+}
+
+struct XLoadThreadResult {
+  uint64_t requests = 0;
+  std::vector<double> batchLatencyUs;
+};
+
+inline int connectTo(const XLoadOptions &options) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(options.port));
+  ::inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr);
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    throw std::runtime_error(std::string("connect failed: ") +
+                             std::strerror(errno));
+  }
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+inline void appendRequest(const XLoadOptions &options, std::string &out,
+                          bool isGet, const std::string &key,
+                          const std::string &value) {
+  if (options.protocol == "resp") {
+    if (isGet) {
+      out += "*2\r\n$3\r\nGET\r\n$" + std::to_string(key.size()) + "\r\n" +
+             key + "\r\n";
+    } else {
+      out += "*3\r\n$3\r\nSET\r\n$" + std::to_string(key.size()) + "\r\n" +
+             key + "\r\n$" + std::to_string(value.size()) + "\r\n" + value +
+             "\r\n";
+    }
+  } else {
+    if (isGet) {
+      out += "get " + key + "\r\n";
+    } else {
+      out += "set " + key + " 0 0 " + std::to_string(value.size()) + "\r\n" +
+             value + "\r\n";
+    }
+  }
+}
+
+inline void runLoadThread(const XLoadOptions &options, size_t id,
+                          std::atomic<bool> &go, std::atomic<bool> &stop,
+                          std::atomic<size_t> &ready,
+                          XLoadThreadResult &result) {
+  std::mt19937_64 gen(id * 7919 + 1);
+  std::uniform_int_distribution<size_t> keyDist(0, options.keys - 1);
+  std::uniform_real_distribution<double> opDist(0.0, 1.0);
+  std::string value(options.valueSize, 'x');
+  auto replyLength =
+      options.protocol == "resp" ? respReplyLength : memcacheReplyLength;
+
+  std::vector<int> fds;
+  struct Closer {
+    std::vector<int> &fds;
+    ~Closer() {
+      for (int fd : fds)
+        ::close(fd);
+    }
+  } closer{fds};
+  for (size_t i = 0; i < options.connections; ++i)
+    fds.push_back(connectTo(options));
+  std::vector<std::string> requests(fds.size());
+  std::vector<std::chrono::steady_clock::time_point> sentAt(fds.size());
+  std::vector<char> buf(1 << 20);
+  ready.fetch_add(1);
+  while (!go.load(std::memory_order_acquire))
+    std::this_thread::yield();
+
+  auto sendAll = [](int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+      ssize_t w =
+          ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (w <= 0)
+        return false;
+      sent += size_t(w);
+    }
+    return true;
+  };
+
+  while (!stop.load(std::memory_order_relaxed)) {
+    // 所有连接先各发一批，再依次收齐回复，使服务端同时看到多个连接的流水线请求
+    for (size_t c = 0; c < fds.size(); ++c) {
+      requests[c].clear();
+      for (size_t i = 0; i < options.pipeline; ++i) {
+        appendRequest(options, requests[c], opDist(gen) < options.getRatio,
+                      "key:" + std::to_string(keyDist(gen)), value);
+      }
+      sentAt[c] = std::chrono::steady_clock::now();
+      if (!sendAll(fds[c], requests[c]))
+        throw std::runtime_error("connection closed by server");
+    }
+    for (size_t c = 0; c < fds.size(); ++c) {
+      size_t have = 0;
+      size_t replies = 0;
+      while (replies < options.pipeline) {
+        if (have == buf.size())
+          buf.resize(buf.size() * 2);
+        ssize_t r = ::recv(fds[c], buf.data() + have, buf.size() - have, 0);
+        if (r <= 0)
+          throw std::runtime_error("connection closed by server");
+        have += size_t(r);
+        size_t offset = 0;
+        while (replies < options.pipeline) {
+          size_t len = replyLength(buf.data() + offset, have - offset);
+          if (len == 0)
+            break;
+          offset += len;
+          replies++;
+        }
+        std::memmove(buf.data(), buf.data() + offset, have - offset);
+        have -= offset;
+      }
+      result.batchLatencyUs.push_back(
+          std::chrono::duration<double, std::micro>(
+              std::chrono::steady_clock::now() - sentAt[c])
+              .count());
+      result.requests += options.pipeline;
+    }
+  }
+}
+
+struct XLoadResult {
+  uint64_t requests = 0;
+  double seconds = 0;
+  double requestsPerSec = 0;
+  double p50Us = 0; // 每批请求的往返延迟
+  double p99Us = 0;
+  double maxUs = 0;
+};
+
+// 建立全部连接后开始计时，运行options.seconds秒
+inline XLoadResult runLoad(const XLoadOptions &options) {
+  std::atomic<bool> go{false};
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> ready{0};
+  std::vector<XLoadThreadResult> results(options.threads);
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(options.threads);
+  for (size_t t = 0; t < options.threads; ++t) {
+    threads.emplace_back([&, t] {
+      try {
+        runLoadThread(options, t, go, stop, ready, results[t]);
+      } catch (...) {
+        errors[t] = std::current_exception();
+        if (!go.load())
+          ready.fetch_add(1);
+        stop = true;
+      }
+    });
+  }
+  while (ready.load() < options.threads)
+    std::this_thread::yield();
+  go.store(true, std::memory_order_release);
+  auto begin = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  stop = true;
+  for (auto &t : threads)
+    t.join();
+  for (auto &e : errors) {
+    if (e)
+      std::rethrow_exception(e);
+  }
+
+  XLoadResult total;
+  total.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+  std::vector<double> latencies;
+  for (auto &r : results) {
+    total.requests += r.requests;
+    latencies.insert(latencies.end(), r.batchLatencyUs.begin(),
+                     r.batchLatencyUs.end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    if (latencies.empty())
+      return 0.0;
+    return latencies[std::min(latencies.size() - 1,
+                              size_t(p * latencies.size()))];
+  };
+  total.requestsPerSec = total.requests / total.seconds;
+  total.p50Us = percentile(0.50);
+  total.p99Us = percentile(0.99);
+  total.maxUs = latencies.empty() ? 0.0 : latencies.back();
+  return total;
+}
+} // namespace XCache
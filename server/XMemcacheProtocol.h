@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "XCacheStore.h"
+#include "XEventLoop.h"
+
+namespace XCache {
+// memcached文本协议：get/gets/set/delete/incr/version/quit
+// 同一批输入中连续的get/gets命令合并为一次multi-get，按分片批量查询
+class XMemcacheProtocol : public XProtocolHandler {
+  static constexpr size_t kMaxLine = 2048;
+  static constexpr size_t kMaxKey = 250;
+  static constexpr size_t kMaxItemSize = 1u << 20; // 与memcached默认的item上限相同
+  static constexpr int64_t kRelativeExpireLimit = 60 * 60 * 24 * 30; // 30天
+
+public:
+  explicit XMemcacheProtocol(XCacheStore &store) : store(store) {}
+
+  size_t process(XConnection &conn, const char *data, size_t len) override {
+    size_t pos = 0;
+    while (pos < len && !conn.closing) {
+      const char *lineEnd =
+          static_cast<const char *>(std::memchr(data + pos, '\n', len - pos));
+      if (!lineEnd) {
+        if (len - pos > kMaxLine) {
+          flushGets(conn.out);
+          conn.out += "CLIENT_ERROR line too long\r\n";
+          conn.closing = true;
+          return len;
+        }
+        break;
+      }
+      size_t next = size_t(lineEnd - data) + 1;
+      size_t lineLen = next - pos - 1;
+      if (lineLen > 0 && data[pos + lineLen - 1] == '\r')
+        lineLen--;
+      std::string_view line(data + pos, lineLen);
+
+      size_t tokenCount = tokenize(line);
+      if (tokenCount == 0) {
+        flushGets(conn.out);
+        conn.out += "ERROR\r\n";
+        pos = next;
+        continue;
+      }
+      std::string_view cmd = tokens[0];
+
+      if (cmd == "get" || cmd == "gets") {
+        // 先攒起来，遇到其他命令或本批结束时统一查询
+        if (tokenCount < 2) {
+          flushGets(conn.out);
+          conn.out += "ERROR\r\n";
+        } else {
+          // key数不受tokens数组大小限制，直接从整行取
+          size_t firstKey = pendingKeys.size();
+          bool isCommand = true;
+          forEachToken(line, [&](std::string_view token) {
+            if (!std::exchange(isCommand, false))
+              pendingKeys.emplace_back(token);
+          });
+          pendingCommands.push_back({firstKey, pendingKeys.size() - firstKey,
+                                     cmd.size() == 4});
+        }
+        pos = next;
+        continue;
+      }
+
+      flushGets(conn.out);
+      if (cmd == "set") {
+        size_t consumed = handleSet(conn, tokenCount, data + next, len - next);
+        if (consumed == kNeedMore)
+          return pos; // 数据块尚未到齐，保留整条命令等待下次
+        pos = next + consumed;
+        continue;
+      }
+      if (cmd == "delete")
+        handleDelete(conn, tokenCount);
+      else if (cmd == "incr")
+        handleIncr(conn, tokenCount);
+      else if (cmd == "version")
+        conn.out += "VERSION xcache-1.0\r\n";
+      else if (cmd == "quit")
+        conn.closing = true;
+      else
+        conn.out += "ERROR\r\n";
+      pos = next;
+    }
+    flushGets(conn.out);
+    return pos;
+  }
+
+private:
+  static constexpr size_t kNeedMore = size_t(-1);
+  static constexpr size_t kMaxTokens = 24;
+
+  struct PendingGet {
+    size_t firstKey;
+    size_t keyCount;
+    bool withCas;
+  };
+
+  template <typename Fn> static void forEachToken(std::string_view line, Fn &&fn) {
+    size_t i = 0;
+    while (i < line.size()) {
+      while (i < line.size() && line[i] == ' ')
+        ++i;
+      size_t start = i;
+      while (i < line.size() && line[i] != ' ')
+        ++i;
+      if (i > start)
+        fn(line.substr(start, i - start));
+    }
+  }
+
+  // 只保留前kMaxTokens个，足够get以外的所有命令
+  size_t tokenize(std::string_view line) {
+    size_t count = 0;
+    forEachToken(line, [&](std::string_view token) {
+      if (count < kMaxTokens)
+        tokens[count++] = token;
+    });
+    return count;
+  }
+
+  template <typename T> static bool parseNumber(std::string_view s, T &out) {
+    auto result = std::from_chars(s.data(), s.data() + s.size(), out);
+    return result.ec == std::errc() && result.ptr == s.data() + s.size();
+  }
+
+  // 执行攒下的multi-get，按命令原顺序输出
+  void flushGets(XOutputQueue &out) {
+    if (pendingCommands.empty())
+      return;
+    store.getMany(pendingKeys, items, found);
+    for (const PendingGet &cmd : pendingCommands) {
+      for (size_t i = cmd.firstKey; i < cmd.firstKey + cmd.keyCount; ++i) {
+        if (!found[i])
+          continue;
+        XCacheItem &item = items[i];
+        out += "VALUE ";
+        out += pendingKeys[i];
+        out += ' ';
+        out += std::to_string(item.flags);
+        out += ' ';
+        out += std::to_string(item.data.size());
+        if (cmd.withCas) {
+          out += ' ';
+          out += std::to_string(item.cas);
+        }
+        out += "\r\n";
+        out.appendOwned(std::move(item.data));
+        out += "\r\n";
+      }
+      out += "END\r\n";
+    }
+    pendingCommands.clear();
+    pendingKeys.clear();
+  }
+
+  // set <key> <flags> <exptime> <bytes> [noreply]\r\n<data>\r\n
+  // 返回数据块占用的字节数，数据不完整时返回kNeedMore
+  size_t handleSet(XConnection &conn, size_t tokenCount, const char *block,
+                   size_t available) {
+    uint32_t flags;
+    int64_t exptime;
+    size_t bytes;
+    // <bytes>能解析时其余字段出错也跳过数据块，否则数据会被当成命令解析
+    bool sized = tokenCount >= 5 && parseNumber(tokens[4], bytes);
+    if (sized && bytes > kMaxItemSize) {
+      // 数据块无法跳过，回复错误后关闭连接
+      conn.out += "CLIENT_ERROR object too large for cache\r\n";
+      conn.closing = true;
+      return 0;
+    }
+    if (sized && available < bytes + 2)
+      return kNeedMore;
+    if (!sized || tokens[1].size() > kMaxKey ||
+        !parseNumber(tokens[2], flags) || !parseNumber(tokens[3], exptime)) {
+      conn.out += "CLIENT_ERROR bad command line format\r\n";
+      return sized ? bytes + 2 : 0;
+    }
+    bool noreply = tokenCount > 5 && tokens[5] == "noreply";
+    if (block[bytes] != '\r' || block[bytes + 1] != '\n') {
+      conn.out += "CLIENT_ERROR bad data chunk\r\n";
+      return bytes + 2;
+    }
+    XCacheItem item;
+    item.data.assign(block, bytes);
+    item.flags = flags;
+    item.expireAt = toExpireAt(exptime);
+    std::string key(tokens[1]);
+    if (exptime < 0)
+      store.remove(key); // 负的过期时间表示立即过期
+    else
+      store.set(key, std::move(item));
+    if (!noreply)
+      conn.out += "STORED\r\n";
+    return bytes + 2;
+  }
+
+  void handleDelete(XConnection &conn, size_t tokenCount) {
+    if (tokenCount < 2) {
+      conn.out += "ERROR\r\n";
+      return;
+    }
+    bool noreply = tokens[tokenCount - 1] == "noreply";
+    bool removed = store.remove(std::string(tokens[1]));
+    if (!noreply)
+      conn.out += removed ? "DELETED\r\n" : "NOT_FOUND\r\n";
+  }
+
+  void handleIncr(XConnection &conn, size_t tokenCount) {
+    uint64_t delta;
+    if (tokenCount < 3 || !parseNumber(tokens[2], delta)) {
+      conn.out += "CLIENT_ERROR invalid numeric delta argument\r\n";
+      return;
+    }
+    bool noreply = tokenCount > 3 && tokens[3] == "noreply";
+    uint64_t result = 0;
+    auto status = store.incr(std::string(tokens[1]), delta, result);
+    if (noreply)
+      return;
+    switch (status) {
+    case XCacheStore::IncrResult::Ok:
+      conn.out += std::to_string(result);
+      conn.out += "\r\n";
+      break;
+    case XCacheStore::IncrResult::NotFound:
+      conn.out += "NOT_FOUND\r\n";
+      break;
+    case XCacheStore::IncrResult::NonNumeric:
+      conn.out +=
+          "CLIENT_ERROR cannot increment or decrement non-numeric value\r\n";
+      break;
+    }
+  }
+
+  // memcached语义：不超过30天视为相对秒数，否则为unix时间戳；
+  // 时间戳先截到INT64_MAX / 1000再换算成毫秒，避免有符号溢出
+  static int64_t toExpireAt(int64_t exptime) {
+    if (exptime <= 0)
+      return 0;
+    if (exptime <= kRelativeExpireLimit)
+      return XCacheStore::nowMs() + exptime * 1000;
+    return std::min(exptime, std::numeric_limits<int64_t>::max() / 1000) *
+           1000;
+  }
+
+  XCacheStore &store;
+  std::string_view tokens[kMaxTokens];
+  std::vector<PendingGet> pendingCommands;
+  std::vector<std::string> pendingKeys;
+  std::vector<XCacheItem> items;
+  std::vector<char> found;
+};
+} // namespace XCache
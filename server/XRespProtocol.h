@@ -0,0 +1,356 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "XCacheStore.h"
+#include "XEventLoop.h"
+
+namespace XCache {
+// RESP2（Redis协议）子集：GET/SET/DEL/MGET/MSET/EXPIRE/TTL/INFO/PING/QUIT
+// 参数以string_view直接指向读缓冲区（零拷贝），一次读入的所有命令作为一批执行，
+// 批内连续的GET/MGET合并为一次分片批量查询，回复经XOutputQueue用writev写出
+class XRespProtocol : public XProtocolHandler {
+  static constexpr size_t kMaxArgs = 1024 * 1024;
+  // 单条命令（含所有参数）的上限；留出一半给尚未回收的已消费前缀，
+  // 超过时回复协议错误，不会先被事件循环的kMaxConnectionInput断开
+  static constexpr size_t kMaxCommand = kMaxConnectionInput / 2;
+  static constexpr size_t kMaxInline = 64 * 1024;
+
+public:
+  explicit XRespProtocol(XCacheStore &store) : store(store) {}
+
+  size_t process(XConnection &conn, const char *data, size_t len) override {
+    size_t pos = 0;
+    commands.clear();
+    args.clear();
+    while (pos < len) {
+      size_t argStart = args.size();
+      size_t used = parseCommand(data + pos, len - pos);
+      if (used == kIncomplete) {
+        args.resize(argStart);
+        break;
+      }
+      if (used == kProtocolError) {
+        args.resize(argStart);
+        execute(conn);
+        conn.out += "-ERR Protocol error\r\n";
+        conn.closing = true;
+        return len;
+      }
+      if (args.size() > argStart)
+        commands.push_back({argStart, args.size() - argStart});
+      pos += used;
+    }
+    execute(conn);
+    return pos;
+  }
+
+private:
+  static constexpr size_t kIncomplete = 0;
+  static constexpr size_t kProtocolError = size_t(-1);
+
+  struct Command {
+    size_t firstArg;
+    size_t argCount;
+  };
+
+  // 在[p, end)中寻找CRLF，返回'\r'的位置
+  static const char *findCrlf(const char *p, const char *end) {
+    while (p < end) {
+      const char *cr = static_cast<const char *>(std::memchr(p, '\r', end - p));
+      if (!cr || cr + 1 >= end)
+        return nullptr;
+      if (cr[1] == '\n')
+        return cr;
+      p = cr + 1;
+    }
+    return nullptr;
+  }
+
+  template <typename T> static bool parseNumber(std::string_view s, T &out) {
+    auto result = std::from_chars(s.data(), s.data() + s.size(), out);
+    return result.ec == std::errc() && result.ptr == s.data() + s.size();
+  }
+
+  // 解析一条命令并把参数追加到args，返回消费的字节数
+  size_t parseCommand(const char *data, size_t len) {
+    const char *end = data + len;
+    if (data[0] != '*')
+      return parseInline(data, len);
+
+    const char *crlf = findCrlf(data, end);
+    if (!crlf)
+      return len > kMaxInline ? kProtocolError : kIncomplete;
+    long long count;
+    if (!parseNumber(std::string_view(data + 1, crlf - data - 1), count) ||
+        count > static_cast<long long>(kMaxArgs))
+      return kProtocolError;
+    const char *p = crlf + 2;
+    for (long long i = 0; i < count; ++i) {
+      if (p >= end)
+        return kIncomplete;
+      if (*p != '$')
+        return kProtocolError;
+      crlf = findCrlf(p, end);
+      if (!crlf)
+        return size_t(end - p) > kMaxInline ? kProtocolError : kIncomplete;
+      size_t bulkLen;
+      if (!parseNumber(std::string_view(p + 1, crlf - p - 1), bulkLen) ||
+          bulkLen > kMaxCommand)
+        return kProtocolError;
+      p = crlf + 2;
+      if (size_t(p - data) + bulkLen + 2 > kMaxCommand)
+        return kProtocolError;
+      if (size_t(end - p) < bulkLen + 2)
+        return kIncomplete;
+      if (p[bulkLen] != '\r' || p[bulkLen + 1] != '\n')
+        return kProtocolError;
+      args.emplace_back(p, bulkLen);
+      p += bulkLen + 2;
+    }
+    return size_t(p - data);
+  }
+
+  // 内联命令（telnet风格，空格分隔）
+  size_t parseInline(const char *data, size_t len) {
+    const char *nl = static_cast<const char *>(std::memchr(data, '\n', len));
+    if (!nl)
+      return len > kMaxInline ? kProtocolError : kIncomplete;
+    size_t lineLen = size_t(nl - data);
+    if (lineLen > 0 && data[lineLen - 1] == '\r')
+      lineLen--;
+    size_t i = 0;
+    while (i < lineLen) {
+      while (i < lineLen && data[i] == ' ')
+        ++i;
+      size_t start = i;
+      while (i < lineLen && data[i] != ' ')
+        ++i;
+      if (i > start)
+        args.emplace_back(data + start, i - start);
+    }
+    return size_t(nl - data) + 1;
+  }
+
+  static bool is(std::string_view arg, const char *name) {
+    size_t n = std::strlen(name);
+    if (arg.size() != n)
+      return false;
+    for (size_t i = 0; i < n; ++i) {
+      char c = arg[i];
+      if (c >= 'a' && c <= 'z')
+        c = char(c - 'a' + 'A');
+      if (c != name[i])
+        return false;
+    }
+    return true;
+  }
+
+  static bool isRead(std::string_view name) {
+    return is(name, "GET") || is(name, "MGET");
+  }
+
+  void execute(XConnection &conn) {
+    size_t i = 0;
+    while (i < commands.size()) {
+      if (isRead(args[commands[i].firstArg])) {
+        // 连续的读命令合并成一次批量查询
+        size_t j = i;
+        while (j < commands.size() && isRead(args[commands[j].firstArg]))
+          ++j;
+        executeReads(conn, i, j);
+        i = j;
+        continue;
+      }
+      executeOne(conn, commands[i]);
+      ++i;
+      if (conn.closing)
+        break;
+    }
+    commands.clear();
+    args.clear();
+  }
+
+  void executeReads(XConnection &conn, size_t begin, size_t end) {
+    keys.clear();
+    for (size_t c = begin; c < end; ++c) {
+      const Command &cmd = commands[c];
+      for (size_t a = 1; a < cmd.argCount; ++a)
+        keys.emplace_back(args[cmd.firstArg + a]);
+    }
+    store.getMany(keys, items, found);
+
+    size_t k = 0;
+    for (size_t c = begin; c < end; ++c) {
+      const Command &cmd = commands[c];
+      if (is(args[cmd.firstArg], "GET")) {
+        if (cmd.argCount != 2) {
+          k += cmd.argCount - 1;
+          wrongArgs(conn, "get");
+          continue;
+        }
+        writeBulk(conn, k);
+        k++;
+      } else {
+        if (cmd.argCount < 2) {
+          wrongArgs(conn, "mget");
+          continue;
+        }
+        writeInteger(conn, '*', int64_t(cmd.argCount - 1));
+        for (size_t a = 1; a < cmd.argCount; ++a, ++k)
+          writeBulk(conn, k);
+      }
+    }
+  }
+
+  void executeOne(XConnection &conn, const Command &cmd) {
+    std::string_view name = args[cmd.firstArg];
+    const std::string_view *argv = &args[cmd.firstArg];
+    size_t argc = cmd.argCount;
+
+    if (is(name, "SET")) {
+      if (argc < 3)
+        return wrongArgs(conn, "set");
+      XCacheItem item;
+      item.data.assign(argv[2].data(), argv[2].size());
+      for (size_t i = 3; i < argc; ++i) {
+        int64_t amount;
+        if ((is(argv[i], "EX") || is(argv[i], "PX")) && i + 1 < argc) {
+          if (!parseNumber(argv[i + 1], amount) || amount <= 0 ||
+              !toExpireAt(amount, is(argv[i], "EX") ? 1000 : 1,
+                          item.expireAt)) {
+            conn.out += "-ERR invalid expire time in 'set' command\r\n";
+            return;
+          }
+          ++i;
+        } else {
+          conn.out += "-ERR syntax error\r\n";
+          return;
+        }
+      }
+      store.set(std::string(argv[1]), std::move(item));
+      conn.out += "+OK\r\n";
+    } else if (is(name, "MSET")) {
+      if (argc < 3 || argc % 2 == 0)
+        return wrongArgs(conn, "mset");
+      for (size_t i = 1; i + 1 < argc; i += 2) {
+        XCacheItem item;
+        item.data.assign(argv[i + 1].data(), argv[i + 1].size());
+        store.set(std::string(argv[i]), std::move(item));
+      }
+      conn.out += "+OK\r\n";
+    } else if (is(name, "DEL")) {
+      if (argc < 2)
+        return wrongArgs(conn, "del");
+      int64_t removed = 0;
+      for (size_t i = 1; i < argc; ++i)
+        removed += store.remove(std::string(argv[i]));
+      writeInteger(conn, ':', removed);
+    } else if (is(name, "EXPIRE")) {
+      int64_t seconds;
+      if (argc != 3)
+        return wrongArgs(conn, "expire");
+      if (!parseNumber(argv[2], seconds)) {
+        conn.out += "-ERR value is not an integer or out of range\r\n";
+        return;
+      }
+      // 非正数表示立即过期
+      int64_t expireAt = XCacheStore::nowMs() - 1;
+      if (seconds > 0 && !toExpireAt(seconds, 1000, expireAt)) {
+        conn.out += "-ERR invalid expire time in 'expire' command\r\n";
+        return;
+      }
+      writeInteger(conn, ':', store.expire(std::string(argv[1]), expireAt));
+    } else if (is(name, "TTL")) {
+      if (argc != 2)
+        return wrongArgs(conn, "ttl");
+      int64_t ms = store.ttl(std::string(argv[1]));
+      writeInteger(conn, ':', ms < 0 ? ms : (ms + 500) / 1000);
+    } else if (is(name, "INFO")) {
+      writeInfo(conn);
+    } else if (is(name, "PING")) {
+      if (argc > 1) {
+        writeInteger(conn, '$', int64_t(argv[1].size()));
+        conn.out += argv[1];
+        conn.out += "\r\n";
+      } else {
+        conn.out += "+PONG\r\n";
+      }
+    } else if (is(name, "QUIT")) {
+      conn.out += "+OK\r\n";
+      conn.closing = true;
+    } else {
+      conn.out += "-ERR unknown command '";
+      conn.out += name.substr(0, 128);
+      conn.out += "'\r\n";
+    }
+  }
+
+  // 正的时长（amount个unitMs毫秒）换算为unix毫秒；结果超出int64_t时返回false，与Redis一样拒绝
+  static bool toExpireAt(int64_t amount, int64_t unitMs, int64_t &expireAt) {
+    int64_t now = XCacheStore::nowMs();
+    if (amount > (std::numeric_limits<int64_t>::max() - now) / unitMs)
+      return false;
+    expireAt = now + amount * unitMs;
+    return true;
+  }
+
+  void writeBulk(XConnection &conn, size_t index) {
+    if (!found[index]) {
+      conn.out += "$-1\r\n";
+      return;
+    }
+    std::string &data = items[index].data;
+    writeInteger(conn, '$', int64_t(data.size()));
+    conn.out.appendOwned(std::move(data));
+    conn.out += "\r\n";
+  }
+
+  static void writeInteger(XConnection &conn, char prefix, int64_t value) {
+    char buf[24];
+    buf[0] = prefix;
+    auto result = std::to_chars(buf + 1, buf + sizeof(buf) - 2, value);
+    result.ptr[0] = '\r';
+    result.ptr[1] = '\n';
+    conn.out += std::string_view(buf, size_t(result.ptr + 2 - buf));
+  }
+
+  static void wrongArgs(XConnection &conn, const char *name) {
+    conn.out += "-ERR wrong number of arguments for '";
+    conn.out += name;
+    conn.out += "' command\r\n";
+  }
+
+  void writeInfo(XConnection &conn) {
+    XCacheStore::Stats stats = store.getStats();
+    std::string info;
+    info += "# Server\r\n";
+    info += "xcache_version:1.0\r\n";
+    info += "policy:" + store.getPolicy() + "\r\n";
+    info += "shards:" + std::to_string(store.getShardNum()) + "\r\n";
+    info += "# Stats\r\n";
+    info += "keyspace_hits:" + std::to_string(stats.hits) + "\r\n";
+    info += "keyspace_misses:" + std::to_string(stats.gets - stats.hits) +
+            "\r\n";
+    info += "expired_keys:" + std::to_string(stats.expired) + "\r\n";
+    info += "total_sets:" + std::to_string(stats.sets) + "\r\n";
+    info += "total_deletes:" + std::to_string(stats.removes) + "\r\n";
+    writeInteger(conn, '$', int64_t(info.size()));
+    conn.out.appendOwned(std::move(info));
+    conn.out += "\r\n";
+  }
+
+  XCacheStore &store;
+  std::vector<std::string_view> args; // 指向读缓冲区，仅在process期间有效
+  std::vector<Command> commands;
+  std::vector<std::string> keys;
+  std::vector<XCacheItem> items;
+  std::vector<char> found;
+};
+} // namespace XCache
@@ -0,0 +1,604 @@
+#pragma once
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "XEventLoop.h"
+
+namespace XCache {
+namespace detail {
+inline int uringSetup(unsigned entries, io_uring_params *params) {
+  return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int uringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                      unsigned flags) {
+  return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+                       nullptr, 0));
+}
+
+inline int uringRegister(int fd, unsigned opcode, void *arg, unsigned count) {
+  return int(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+} // namespace detail
+
+// io_uring事件循环（直接使用系统调用，不依赖liburing）：
+// - 监听套接字使用multishot accept，一次提交持续产生新连接
+// - 连接使用multishot recv + 提供缓冲环（provided buffer ring），内核直接选缓冲区填数据
+// - 回复用sendmsg发出，超过单次iovec上限时拆成IOSQE_IO_LINK链接的多个sendmsg，保证顺序
+// 每轮循环只调用一次io_uring_enter，同时提交本轮的所有请求并等待完成事件
+class XUringLoop : public XServerLoop {
+  static constexpr unsigned kSqEntries = 1024;
+  static constexpr unsigned kCqEntries = 8192;
+  static constexpr unsigned kBufferCount = 256; // 必须是2的幂
+  static constexpr unsigned kBufferSize = 16 * 1024;
+  static constexpr uint16_t kBufferGroup = 0;
+  static constexpr size_t kIovPerSend = 64;
+  static constexpr size_t kMaxLinkedSends = 8;
+  static constexpr size_t kMaxInput = kMaxConnectionInput;
+
+  // user_data低位标记完成事件类型，高位为对象指针（至少8字节对齐）
+  enum Tag : uint64_t {
+    kRecv = 0,
+    kSend = 1,
+    kAccept = 2,
+    kWake = 3,
+    kProvide = 4
+  };
+
+  struct Connection : XConnection {
+    XOutputQueue sending; // 已提交给内核、尚未确认的回复
+    std::vector<iovec> iov;
+    std::vector<msghdr> msgs;
+    size_t sendsInFlight = 0;
+    size_t sentBytes = 0;
+    bool sendFailed = false;
+    bool recvArmed = false;
+    bool dead = false;
+    bool dirty = false;
+  };
+
+public:
+  explicit XUringLoop(std::unique_ptr<XProtocolHandler> handler)
+      : handler(std::move(handler)) {
+    setupRing();
+    setupBuffers();
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    armWake();
+  }
+
+  ~XUringLoop() override {
+    for (auto &pair : connections)
+      ::close(pair.second->fd);
+    if (wakeFd >= 0)
+      ::close(wakeFd);
+    if (ringFd >= 0)
+      ::close(ringFd);
+    if (ringMem && ringMem != MAP_FAILED)
+      ::munmap(ringMem, ringBytes);
+    if (sqes && sqes != MAP_FAILED)
+      ::munmap(sqes, sqesBytes);
+    if (bufRing && bufRing != MAP_FAILED)
+      ::munmap(bufRing, bufRingBytes);
+  }
+
+  XUringLoop(const XUringLoop &) = delete;
+  XUringLoop &operator=(const XUringLoop &) = delete;
+
+  // 内核是否支持本循环依赖的特性（缓冲环、multishot accept/recv）
+  static bool isSupported() {
+    static const bool supported = [] {
+      try {
+        struct NullHandler : XProtocolHandler {
+          size_t process(XConnection &, const char *, size_t len) override {
+            return len;
+          }
+        };
+        XUringLoop probe(std::make_unique<NullHandler>());
+        return probe.hasOpcodes();
+      } catch (const std::exception &) {
+        return false;
+      }
+    }();
+    return supported;
+  }
+
+  void addListener(int fd, bool) override {
+    // 多个环对同一套接字的multishot accept由内核保证每个连接只交给一个环
+    listeners.push_back(fd);
+    armAccept(&listeners.back());
+  }
+
+  void run() override {
+    while (!stopping.load(std::memory_order_acquire)) {
+      submitSends();
+      int ret = detail::uringEnter(ringFd, pendingSubmit, 1,
+                                   IORING_ENTER_GETEVENTS);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          reap();
+          continue;
+        }
+        break;
+      }
+      pendingSubmit -= std::min<unsigned>(pendingSubmit, unsigned(ret));
+      reap();
+    }
+  }
+
+  void stop() override {
+    stopping.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    (void)!::write(wakeFd, &one, sizeof(one));
+  }
+
+  size_t getConnectionCount() const { return connections.size(); }
+
+private:
+  void setupRing() {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL |
+                   IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = kCqEntries;
+    ringFd = detail::uringSetup(kSqEntries, &params);
+    if (ringFd < 0 && errno == EINVAL) {
+      params = io_uring_params{};
+      params.flags = IORING_SETUP_CQSIZE;
+      params.cq_entries = kCqEntries;
+      ringFd = detail::uringSetup(kSqEntries, &params);
+    }
+    if (ringFd < 0)
+      throw std::runtime_error(std::string("io_uring_setup failed: ") +
+                               std::strerror(errno));
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+        !(params.features & IORING_FEAT_NODROP))
+      throw std::runtime_error("io_uring kernel too old");
+
+    // IORING_FEAT_SINGLE_MMAP：提交环与完成环共用一次映射
+    ringBytes = std::max<size_t>(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ringMem = ::mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (ringMem == MAP_FAILED)
+      throw std::runtime_error("cannot map io_uring rings");
+    sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(
+        ::mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED)
+      throw std::runtime_error("cannot map io_uring sqes");
+
+    char *sq = static_cast<char *>(ringMem);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sqEntries = params.sq_entries;
+    char *cq = static_cast<char *>(ringMem);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    localSqTail = *sqTail;
+  }
+
+  // 注册提供缓冲环：内核为multishot recv从环中取缓冲区，用完后由我们放回。
+  // 注册后先用socketpair自检一次；部分内核上缓冲环注册成功却总是返回ENOBUFS，
+  // 此时注销缓冲环，退回IORING_OP_PROVIDE_BUFFERS逐个归还缓冲区
+  void setupBuffers() {
+    buffers.resize(size_t(kBufferCount) * kBufferSize);
+    bufRingBytes = kBufferCount * sizeof(io_uring_buf);
+    bufRing = static_cast<io_uring_buf_ring *>(
+        ::mmap(nullptr, bufRingBytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (bufRing == MAP_FAILED)
+      throw std::runtime_error("cannot allocate buffer ring");
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = kBufferCount;
+    reg.bgid = kBufferGroup;
+    useBufferRing =
+        detail::uringRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+    if (useBufferRing) {
+      for (unsigned i = 0; i < kBufferCount; ++i)
+        pushBuffer(uint16_t(i), i);
+      bufTail = kBufferCount;
+      __atomic_store_n(&bufRing->tail, uint16_t(bufTail), __ATOMIC_RELEASE);
+      if (bufferRingWorks())
+        return;
+      detail::uringRegister(ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+      useBufferRing = false;
+    }
+    for (unsigned i = 0; i < kBufferCount; ++i)
+      recycleBuffer(uint16_t(i));
+    if (detail::uringEnter(ringFd, pendingSubmit, 0, 0) < 0)
+      throw std::runtime_error("io_uring provided buffers unsupported");
+    pendingSubmit = 0;
+    reapSetup();
+  }
+
+  // 用一次带缓冲区选择的recv验证缓冲环可用
+  bool bufferRingWorks() {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+      return false;
+    (void)!::write(sv[1], "x", 1);
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sv[0];
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    int ret = detail::uringEnter(ringFd, pendingSubmit, 1,
+                                 IORING_ENTER_GETEVENTS);
+    pendingSubmit = 0;
+    int res = ret < 0 ? -errno : reapSetup();
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return res == 1;
+  }
+
+  // 构造阶段同步收取完成事件，返回最后一个结果，并归还其中用到的缓冲区
+  int reapSetup() {
+    int last = 0;
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const io_uring_cqe &cqe = cqes[head & cqMask];
+      last = cqe.res;
+      if (cqe.flags & IORING_CQE_F_BUFFER)
+        recycleBuffer(uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    return last;
+  }
+
+  void pushBuffer(uint16_t bid, unsigned slot) {
+    io_uring_buf &buf = bufRing->bufs[slot & (kBufferCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffers.data() +
+                                          size_t(bid) * kBufferSize);
+    buf.len = kBufferSize;
+    buf.bid = bid;
+  }
+
+  void recycleBuffer(uint16_t bid) {
+    if (useBufferRing) {
+      pushBuffer(bid, bufTail);
+      bufTail++;
+      __atomic_store_n(&bufRing->tail, uint16_t(bufTail), __ATOMIC_RELEASE);
+      return;
+    }
+    // 随下一次io_uring_enter一起提交，成功时不产生完成事件
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1; // 缓冲区个数
+    sqe->addr =
+        reinterpret_cast<uint64_t>(buffers.data() + size_t(bid) * kBufferSize);
+    sqe->len = kBufferSize;
+    sqe->off = bid;
+    sqe->buf_group = kBufferGroup;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = encode(nullptr, kProvide);
+  }
+
+  bool hasOpcodes() {
+    const size_t bytes = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::vector<char> storage(bytes, 0);
+    auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+    if (detail::uringRegister(ringFd, IORING_REGISTER_PROBE, probe, 256) < 0)
+      return false;
+    for (int op : {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SENDMSG,
+                   IORING_OP_POLL_ADD}) {
+      if (op > probe->last_op ||
+          !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+        return false;
+    }
+    return true;
+  }
+
+  // 取一个空闲SQE；提交队列满时先把已准备的请求交给内核
+  io_uring_sqe *getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (localSqTail - head >= sqEntries) {
+      detail::uringEnter(ringFd, pendingSubmit, 0, 0);
+      pendingSubmit = 0;
+      head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+      if (localSqTail - head >= sqEntries)
+        throw std::runtime_error("io_uring submission queue full");
+    }
+    unsigned index = localSqTail & sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    localSqTail++;
+    __atomic_store_n(sqTail, localSqTail, __ATOMIC_RELEASE);
+    pendingSubmit++;
+    return sqe;
+  }
+
+  static uint64_t encode(void *ptr, Tag tag) {
+    return reinterpret_cast<uint64_t>(ptr) | tag;
+  }
+
+  void armAccept(int *listenFd) {
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = *listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = encode(listenFd, kAccept);
+  }
+
+  void armWake() {
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeFd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = encode(nullptr, kWake);
+  }
+
+  void armRecv(Connection *conn) {
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->ioprio = multishotRecv ? IORING_RECV_MULTISHOT : 0;
+    sqe->user_data = encode(conn, kRecv);
+    conn->recvArmed = true;
+  }
+
+  void reap() {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & cqMask];
+        handleCompletion(cqe.user_data, cqe.res, cqe.flags);
+      }
+      __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+      tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    }
+  }
+
+  void handleCompletion(uint64_t userData, int res, uint32_t flags) {
+    Tag tag = Tag(userData & 7);
+    void *ptr = reinterpret_cast<void *>(userData & ~uint64_t(7));
+    switch (tag) {
+    case kAccept:
+      onAccept(static_cast<int *>(ptr), res, flags);
+      break;
+    case kRecv:
+      onRecv(static_cast<Connection *>(ptr), res, flags);
+      break;
+    case kSend:
+      onSend(static_cast<Connection *>(ptr), res);
+      break;
+    case kProvide:
+      break;
+    case kWake: {
+      uint64_t v;
+      (void)!::read(wakeFd, &v, sizeof(v));
+      if (!stopping.load(std::memory_order_acquire))
+        armWake();
+      break;
+    }
+    }
+  }
+
+  void onAccept(int *listenFd, int res, uint32_t flags) {
+    if (res >= 0) {
+      // 不设置O_NONBLOCK：阻塞语义的套接字由io_uring内部轮询，不会把EAGAIN抛给用户
+      auto conn = std::make_unique<Connection>();
+      conn->fd = res;
+      Connection *raw = conn.get();
+      connections.emplace(res, std::move(conn));
+      armRecv(raw);
+    }
+    if (!(flags & IORING_CQE_F_MORE) &&
+        !stopping.load(std::memory_order_acquire))
+      armAccept(listenFd);
+  }
+
+  void onRecv(Connection *conn, int res, uint32_t flags) {
+    if (!(flags & IORING_CQE_F_MORE))
+      conn->recvArmed = false;
+    if (flags & IORING_CQE_F_BUFFER) {
+      uint16_t bid = uint16_t(flags >> IORING_CQE_BUFFER_SHIFT);
+      if (res > 0 && !conn->dead)
+        consumeInput(conn, buffers.data() + size_t(bid) * kBufferSize,
+                     size_t(res));
+      recycleBuffer(bid);
+    }
+
+    if (conn->dead) {
+      release(conn);
+      return;
+    }
+    if (res == 0) {
+      // 对端半关闭：先把已产生的回复发完，startSend在输出清空后关闭连接
+      conn->closing = true;
+      markDirty(conn);
+      return;
+    }
+    if (res < 0) {
+      if (res == -EINVAL && multishotRecv) {
+        // 内核不支持multishot recv时退化为每次重新提交
+        multishotRecv = false;
+      } else if (res != -ENOBUFS && res != -EINTR && res != -EAGAIN) {
+        closeConnection(conn);
+        return;
+      }
+    }
+    if (!conn->recvArmed)
+      armRecv(conn);
+  }
+
+  // 未消费输入为空时直接在内核填好的缓冲区上解析（零拷贝），只把不完整的尾部留存
+  void consumeInput(Connection *conn, const char *data, size_t len) {
+    size_t pending = conn->in.size() - conn->inStart;
+    if (pending == 0) {
+      size_t consumed = handler->process(*conn, data, len);
+      conn->in.clear();
+      conn->inStart = 0;
+      conn->in.insert(conn->in.end(), data + consumed, data + len);
+    } else {
+      conn->in.insert(conn->in.end(), data, data + len);
+      size_t consumed = handler->process(
+          *conn, conn->in.data() + conn->inStart, pending + len);
+      conn->inStart += consumed;
+      if (conn->inStart == conn->in.size()) {
+        conn->in.clear();
+        conn->inStart = 0;
+      } else if (conn->inStart > kBufferSize) {
+        conn->in.erase(conn->in.begin(), conn->in.begin() + conn->inStart);
+        conn->inStart = 0;
+      }
+    }
+    if (conn->in.size() > kMaxInput)
+      conn->closing = true;
+    markDirty(conn);
+  }
+
+  void markDirty(Connection *conn) {
+    if (!conn->dirty) {
+      conn->dirty = true;
+      dirtyConnections.push_back(conn);
+    }
+  }
+
+  // 本轮产生回复的连接统一在进入内核前提交发送
+  void submitSends() {
+    for (Connection *conn : dirtyConnections) {
+      conn->dirty = false;
+      if (conn->dead) {
+        release(conn); // 在dirty期间推迟的释放
+        continue;
+      }
+      if (conn->sendsInFlight == 0)
+        startSend(conn);
+    }
+    dirtyConnections.clear();
+  }
+
+  void startSend(Connection *conn) {
+    if (conn->sending.empty()) {
+      if (conn->out.empty()) {
+        if (conn->closing)
+          closeConnection(conn);
+        return;
+      }
+      std::swap(conn->sending, conn->out);
+    }
+    // 发送期间不修改sending，新回复继续追加到out，iovec指向的内存保持稳定
+    size_t maxIov = kIovPerSend * kMaxLinkedSends;
+    conn->iov.resize(maxIov);
+    size_t iovCount = size_t(conn->sending.fill(conn->iov.data(), int(maxIov)));
+    size_t sendCount = (iovCount + kIovPerSend - 1) / kIovPerSend;
+    conn->msgs.assign(sendCount, msghdr{});
+    for (size_t i = 0; i < sendCount; ++i) {
+      msghdr &msg = conn->msgs[i];
+      msg.msg_iov = conn->iov.data() + i * kIovPerSend;
+      msg.msg_iovlen = std::min(kIovPerSend, iovCount - i * kIovPerSend);
+      io_uring_sqe *sqe = getSqe();
+      sqe->opcode = IORING_OP_SENDMSG;
+      sqe->fd = conn->fd;
+      sqe->addr = reinterpret_cast<uint64_t>(&msg);
+      // MSG_WAITALL让内核在部分发送时继续重试，链中的下一个sendmsg只在前一个写完后执行
+      sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+      if (i + 1 < sendCount)
+        sqe->flags = IOSQE_IO_LINK;
+      sqe->user_data = encode(conn, kSend);
+    }
+    conn->sendsInFlight = sendCount;
+    conn->sentBytes = 0;
+    conn->sendFailed = false;
+  }
+
+  void onSend(Connection *conn, int res) {
+    if (res > 0)
+      conn->sentBytes += size_t(res);
+    else if (res < 0 && res != -ECANCELED)
+      conn->sendFailed = true; // 链中的后续请求会以ECANCELED结束
+    if (--conn->sendsInFlight > 0)
+      return;
+    if (conn->dead) {
+      release(conn);
+      return;
+    }
+    if (conn->sendFailed) {
+      closeConnection(conn);
+      return;
+    }
+    conn->sending.consume(conn->sentBytes);
+    startSend(conn);
+  }
+
+  // 关闭连接：shutdown使挂起的recv/send尽快完成，全部完成事件回收后再释放
+  void closeConnection(Connection *conn) {
+    if (conn->dead)
+      return;
+    conn->dead = true;
+    ::shutdown(conn->fd, SHUT_RDWR);
+    release(conn);
+  }
+
+  // 仍在dirtyConnections中的连接由submitSends释放
+  void release(Connection *conn) {
+    if (conn->recvArmed || conn->sendsInFlight > 0 || conn->dirty)
+      return;
+    int fd = conn->fd;
+    ::close(fd);
+    connections.erase(fd);
+  }
+
+  std::unique_ptr<XProtocolHandler> handler;
+  int ringFd = -1;
+  int wakeFd = -1;
+  void *ringMem = nullptr;
+  size_t ringBytes = 0;
+  io_uring_sqe *sqes = nullptr;
+  size_t sqesBytes = 0;
+  unsigned *sqHead = nullptr;
+  unsigned *sqTail = nullptr;
+  unsigned *sqArray = nullptr;
+  unsigned sqMask = 0;
+  unsigned sqEntries = 0;
+  unsigned localSqTail = 0;
+  unsigned pendingSubmit = 0;
+  unsigned *cqHead = nullptr;
+  unsigned *cqTail = nullptr;
+  unsigned cqMask = 0;
+  io_uring_cqe *cqes = nullptr;
+
+  io_uring_buf_ring *bufRing = nullptr;
+  size_t bufRingBytes = 0;
+  unsigned bufTail = 0;
+  std::vector<char> buffers;
+  bool useBufferRing = false;
+  bool multishotRecv = true;
+
+  std::list<int> listeners; // user_data中保存元素地址，需保证地址稳定
+  std::unordered_map<int, std::unique_ptr<Connection>> connections;
+  std::vector<Connection *> dirtyConnections;
+  std::atomic<bool> stopping{false};
+};
+} // namespace XCache
@@ -0,0 +1,74 @@
+#include <iomanip>
+#include <iostream>
+
+#include "XLoadGen.h"
+
+using XCache::XLoadOptions;
+
+static void usage(const char *prog) {
+  std::cout << "用法: " << prog << " [选项]\n"
+            << "  --host <addr>        服务地址（默认127.0.0.1）\n"
+            << "  --port <n>           服务端口（默认11211）\n"
+            << "  --protocol <name>    memcache|resp（默认memcache）\n"
+            << "  --threads <n>        压测线程数（默认1）\n"
+            << "  --connections <n>    每线程连接数（默认4）\n"
+            << "  --pipeline <n>       每批请求数（默认16）\n"
+            << "  --seconds <s>        压测时长（默认5）\n"
+            << "  --keys <n>           key空间大小（默认100000）\n"
+            << "  --value-size <n>     value字节数（默认32）\n"
+            << "  --get-ratio <r>      读请求比例（默认0.9）\n";
+}
+
+int main(int argc, char **argv) {
+  XLoadOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--host")
+      options.host = value;
+    else if (arg == "--port")
+      options.port = std::stoi(value);
+    else if (arg == "--protocol")
+      options.protocol = value;
+    else if (arg == "--threads")
+      options.threads = std::stoul(value);
+    else if (arg == "--connections")
+      options.connections = std::stoul(value);
+    else if (arg == "--pipeline")
+      options.pipeline = std::stoul(value);
+    else if (arg == "--seconds")
+      options.seconds = std::stod(value);
+    else if (arg == "--keys")
+      options.keys = std::stoul(value);
+    else if (arg == "--value-size")
+      options.valueSize = std::stoul(value);
+    else if (arg == "--get-ratio")
+      options.getRatio = std::stod(value);
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  XCache::XLoadResult result;
+  try {
+    result = XCache::runLoad(options);
+  } catch (const std::exception &e) {
+    std::cerr << "xcache_loadgen: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << std::fixed << std::setprecision(1) << options.protocol
+            << " threads=" << options.threads
+            << " connections=" << options.threads * options.connections
+            << " pipeline=" << options.pipeline << "\n"
+            << "  requests/s: " << result.requestsPerSec << "\n"
+            << "  batch latency p50: " << result.p50Us
+            << " us, p99: " << result.p99Us << " us, max: " << result.maxUs
+            << " us" << std::endl;
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <signal.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "XCacheServer.h"
+
+// 独立缓存守护进程，支持memcached文本协议与RESP2（Redis协议）子集
+static void usage(const char *prog) {
+  std::cout
+      << "用法: " << prog << " [选项]\n"
+      << "  --host <addr>       TCP监听地址（默认0.0.0.0）\n"
+      << "  --protocol <name>   memcache|resp（默认memcache）\n"
+      << "  --port <n>          TCP端口（默认memcache为11211、resp为6379，-1关闭TCP）\n"
+      << "  --unix <path>       额外监听的Unix套接字路径\n"
+      << "  --threads <n>       事件循环数量（默认每核一个）\n"
+      << "  --pin               将事件循环绑定到CPU\n"
+      << "  --backend <name>    epoll|io_uring（默认epoll，内核不支持时退回epoll）\n"
+      << "  --policy <name>     lru|lru-k|lfu|lfu-aging|arc|w-tinylfu（默认lru）\n"
+      << "  --capacity <n>      总条目容量（默认1000000）\n"
+      << "  --shards <n>        分片数量（默认64）\n";
+}
+
+int main(int argc, char **argv) {
+  XCache::XServerOptions options;
+  bool portGiven = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        usage(argv[0]);
+        std::exit(1);
+      }
+      return argv[++i];
+    };
+    if (arg == "--host")
+      options.host = value();
+    else if (arg == "--port") {
+      options.port = std::stoi(value());
+      portGiven = true;
+    } else if (arg == "--protocol")
+      options.protocol = value();
+    else if (arg == "--unix")
+      options.unixPath = value();
+    else if (arg == "--threads")
+      options.threads = std::stoul(value());
+    else if (arg == "--pin")
+      options.pinThreads = true;
+    else if (arg == "--backend")
+      options.backend = value();
+    else if (arg == "--policy")
+      options.policy = value();
+    else if (arg == "--capacity")
+      options.capacity = std::stoul(value());
+    else if (arg == "--shards")
+      options.shards = std::stoul(value());
+    else {
+      usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  if (!portGiven && options.protocol == "resp")
+    options.port = 6379;
+
+  // 在启动工作线程前屏蔽信号，由主线程同步等待
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  ::signal(SIGPIPE, SIG_IGN);
+
+  try {
+    XCache::XCacheServer server(options);
+    server.start();
+    std::cout << "xcache_server: protocol=" << server.getOptions().protocol
+              << " policy=" << server.getOptions().policy
+              << " capacity=" << server.getOptions().capacity
+              << " shards=" << server.getOptions().shards
+              << " threads=" << server.getOptions().threads
+              << " backend=" << server.getBackend();
+    if (options.port >= 0)
+      std::cout << " port=" << server.getPort();
+    if (!options.unixPath.empty())
+      std::cout << " unix=" << options.unixPath;
+    std::cout << std::endl;
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    server.stop();
+  } catch (const std::exception &e) {
+    std::cerr << "xcache_server: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
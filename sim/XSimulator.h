@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../XCacheFactory.h"
+#include "../XEvictionStats.h"
+#include "XTrace.h"
+
+namespace XCache {
+// 一次模拟：一个淘汰策略在一个容量下回放trace，value记录对象大小以统计字节命中率
+class XSimRun {
+public:
+  XSimRun(std::string policy, size_t capacity)
+      : policy(std::move(policy)), capacity(capacity),
+        engine(makeCachePolicy<uint64_t, uint32_t>(this->policy, capacity)) {}
+
+  // 未命中时按写分配插入；写请求命中时更新大小
+  void feed(const XTraceRequest *reqs, size_t n) {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+      const XTraceRequest &req = reqs[i];
+      uint32_t size;
+      bool hit = engine->get(req.key, size);
+      if (hit) {
+        hits++;
+        byteHits += req.size;
+        if (req.write && size != req.size)
+          engine->put(req.key, req.size);
+      } else {
+        engine->put(req.key, req.size);
+      }
+      bytes += req.size;
+    }
+    requests += n;
+    elapsed += std::chrono::steady_clock::now() - begin;
+  }
+
+  // 开启淘汰统计，时间按访问次数计，回放结果与trace的时间戳无关
+  void enableEvictionStats(size_t ghostCapacity) {
+    evictionStats = std::make_shared<XEvictionStats>(ghostCapacity,
+                                                     XEvictionClock::Accesses);
+    engine->setEvictionStats(evictionStats);
+  }
+  const XEvictionStats *getEvictionStats() const { return evictionStats.get(); }
+
+  const std::string &getPolicy() const { return policy; }
+  size_t getCapacity() const { return capacity; }
+  uint64_t getRequests() const { return requests; }
+  double hitRatio() const { return requests ? double(hits) / requests : 0; }
+  double byteHitRatio() const { return bytes ? double(byteHits) / bytes : 0; }
+  double seconds() const { return elapsed.count(); }
+  // 引擎本身的吞吐（不含trace解码）
+  double requestsPerSec() const {
+    return elapsed.count() > 0 ? requests / elapsed.count() : 0;
+  }
+
+private:
+  std::string policy;
+  size_t capacity;
+  std::unique_ptr<XCachePolicy<uint64_t, uint32_t>> engine;
+  std::shared_ptr<XEvictionStats> evictionStats;
+  uint64_t requests = 0;
+  uint64_t hits = 0;
+  uint64_t bytes = 0;
+  uint64_t byteHits = 0;
+  std::chrono::duration<double> elapsed{0};
+};
+// 并行模拟：读取线程把trace每块只解码一次放进共享的块槽，线程池中的工作线程
+// 以（模拟, 块）为单位并行消费。每个模拟按顺序处理各块，不同模拟互不依赖；
+// 所有模拟都处理完的块才回收复用，最慢的模拟落后maxChunks块时读取线程阻塞（反压）
+class XParallelSimulator {
+public:
+  XParallelSimulator(std::vector<std::unique_ptr<XSimRun>> &runs,
+                     size_t threads, size_t maxChunks = 0,
+                     size_t chunkSize = 64 * 1024)
+      : runs(runs), threads(std::max<size_t>(1, threads)),
+        maxChunks(maxChunks ? maxChunks : 2 * this->threads + 2),
+        chunkSize(chunkSize), slots(this->maxChunks),
+        nextChunk(runs.size(), 0), queued(runs.size(), false) {
+    for (auto &slot : slots)
+      slot.reqs.resize(chunkSize);
+  }
+
+  // 回放至多limit条请求，返回实际回放的条数
+  uint64_t run(XTraceReader &reader, uint64_t limit = UINT64_MAX) {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i)
+      workers.emplace_back([this] { workerLoop(); });
+
+    uint64_t total = 0;
+    while (total < limit) {
+      Chunk *slot;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        readerCv.wait(lock, [&] { return decoded - oldest < maxChunks; });
+        slot = &slots[decoded % maxChunks];
+      }
+      // 槽位空闲时没有工作线程会访问它，解码不需要持锁
+      size_t n = reader.next(slot->reqs.data(),
+                             size_t(std::min<uint64_t>(chunkSize, limit - total)));
+      if (n == 0)
+        break;
+      total += n;
+      std::lock_guard<std::mutex> lock(mtx);
+      slot->count = n;
+      slot->pending = runs.size();
+      decoded++;
+      for (size_t r = 0; r < runs.size(); ++r)
+        schedule(r);
+      while (oldest < decoded && slots[oldest % maxChunks].pending == 0)
+        oldest++; // 没有任何模拟时块立即回收
+      workerCv.notify_all();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      readerCv.wait(lock, [&] { return oldest == decoded; });
+      stopping = true;
+    }
+    workerCv.notify_all();
+    for (auto &t : workers)
+      t.join();
+    return total;
+  }
+
+private:
+  struct Chunk {
+    std::vector<XTraceRequest> reqs;
+    size_t count = 0;
+    size_t pending = 0; // 尚未处理该块的模拟数
+  };
+
+  // 持锁调用：模拟r有未处理的块且不在队列/执行中时入队
+  void schedule(size_t r) {
+    if (!queued[r] && nextChunk[r] < decoded) {
+      queued[r] = true;
+      ready.push_back(r);
+    }
+  }
+
+  void workerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+      workerCv.wait(lock, [&] { return stopping || !ready.empty(); });
+      if (ready.empty())
+        return;
+      size_t r = ready.front();
+      ready.pop_front();
+      uint64_t seq = nextChunk[r];
+      Chunk &chunk = slots[seq % maxChunks];
+      lock.unlock();
+      runs[r]->feed(chunk.reqs.data(), chunk.count);
+      lock.lock();
+      nextChunk[r] = seq + 1;
+      queued[r] = false;
+      // 每次只处理一块再重新排队，避免领先的模拟独占线程、拖住块的回收
+      schedule(r);
+      if (!ready.empty())
+        workerCv.notify_one();
+      if (--chunk.pending == 0) {
+        while (oldest < decoded && slots[oldest % maxChunks].pending == 0)
+          oldest++;
+        readerCv.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<XSimRun>> &runs;
+  size_t threads;
+  size_t maxChunks;
+  size_t chunkSize;
+  std::vector<Chunk> slots;
+  std::vector<uint64_t> nextChunk; // 每个模拟下一个要处理的块序号
+  std::vector<bool> queued;
+  std::deque<size_t> ready;
+  uint64_t decoded = 0; // 已发布的块数
+  uint64_t oldest = 0;  // 最早一个尚未被全部模拟处理完的块
+  bool stopping = false;
+  std::mutex mtx;
+  std::condition_variable readerCv;
+  std::condition_variable workerCv;
+};
+} // namespace XCache
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace XCache {
+// 一次缓存访问
+struct XTraceRequest {
+  uint64_t key = 0;
+  uint32_t size = 0; // 对象字节数，用于字节命中率
+  bool write = false;
+};
+
+enum class XTraceOp : uint8_t { Get = 0, Put = 1, Remove = 2 };
+
+// 线上录制的一条访问，比XTraceRequest多出命中与否和粗粒度时间戳
+struct XTraceEvent {
+  uint64_t key = 0; // key的哈希
+  uint32_t size = 0;
+  XTraceOp op = XTraceOp::Get;
+  bool hit = false;
+  uint32_t timestampMs = 0; // 相对录制开始的毫秒数
+};
+
+enum class XTraceFormat {
+  Arc,    // ARC论文trace：每行 "起始块 块数 忽略 请求号"，展开为连续块
+  Lirs,   // LIRS trace：每行一个块号，'*'开头的行为分隔符
+  Csv,    // 逗号分隔，按列号取key/大小/读写类型
+  Binary, // 紧凑二进制格式，见XTraceWriter
+};
+
+struct XTraceFormatSpec {
+  XTraceFormat format = XTraceFormat::Binary;
+  int keyColumn = 0;
+  int sizeColumn = -1; // -1表示使用blockBytes
+  int opColumn = -1;   // 以'W'/'w'开头视为写
+  uint32_t blockBytes = 512;
+};
+
+// 解析格式名：arc | lirs | msr | cloudphysics | csv:<key列>,<大小列>[,<读写列>] | bin
+inline XTraceFormatSpec parseTraceFormat(const std::string &name) {
+  XTraceFormatSpec spec;
+  if (name == "arc") {
+    spec.format = XTraceFormat::Arc;
+  } else if (name == "lirs") {
+    spec.format = XTraceFormat::Lirs;
+  } else if (name == "msr") {
+    // MSR Cambridge：Timestamp,Hostname,DiskNumber,Type,Offset,Size,ResponseTime
+    spec.format = XTraceFormat::Csv;
+    spec.keyColumn = 4;
+    spec.sizeColumn = 5;
+    spec.opColumn = 3;
+  } else if (name == "cloudphysics") {
+    // CloudPhysics块trace的CSV导出：timestamp,lba,size,op
+    spec.format = XTraceFormat::Csv;
+    spec.keyColumn = 1;
+    spec.sizeColumn = 2;
+    spec.opColumn = 3;
+  } else if (name.rfind("csv:", 0) == 0) {
+    spec.format = XTraceFormat::Csv;
+    int columns[3] = {-1, -1, -1};
+    size_t pos = 4;
+    for (int i = 0; i < 3 && pos <= name.size(); ++i) {
+      size_t comma = name.find(',', pos);
+      std::string field = name.substr(pos, comma - pos);
+      if (!field.empty())
+        columns[i] = std::stoi(field);
+      if (comma == std::string::npos)
+        break;
+      pos = comma + 1;
+    }
+    if (columns[0] < 0)
+      throw std::invalid_argument("csv format needs a key column: " + name);
+    spec.keyColumn = columns[0];
+    spec.sizeColumn = columns[1];
+    spec.opColumn = columns[2];
+  } else if (name == "bin") {
+    spec.format = XTraceFormat::Binary;
+  } else {
+    throw std::invalid_argument("unknown trace format: " + name);
+  }
+  return spec;
+}
+
+namespace detail {
+// 二进制trace：16字节文件头 + 每条12字节记录（小端）；录制的trace每条16字节，
+// 前12字节相同，后4字节低2位为操作类型、第2位为命中、高29位为毫秒时间戳。
+// 大小字段的最高位只表示Put，Remove在12字节记录中无法表示
+constexpr char kTraceMagic[8] = {'X', 'C', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr size_t kTraceHeaderBytes = 16;
+constexpr size_t kTraceRecordBytes = 12;
+constexpr size_t kTraceEventBytes = 16;
+constexpr uint32_t kTraceWriteBit = 1u << 31;
+constexpr uint32_t kTraceOpMask = 3u;
+constexpr uint32_t kTraceHitBit = 1u << 2;
+constexpr int kTraceTimeShift = 3;
+} // namespace detail
+
+// 流式trace读取器：mmap整个文件但按块解码，已读过的区域定期MADV_DONTNEED释放，
+// 常驻内存与trace大小无关
+class XTraceReader {
+  static constexpr size_t kReleaseBytes = 64u << 20;
+
+public:
+  XTraceReader(const std::string &path, XTraceFormatSpec spec) : spec(spec) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw std::runtime_error("cannot open trace: " + path);
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      length = static_cast<size_t>(st.st_size);
+      void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("cannot map trace: " + path);
+      }
+      addr = static_cast<const char *>(p);
+      ::madvise(const_cast<char *>(addr), length, MADV_SEQUENTIAL);
+    }
+    rewind();
+  }
+
+  ~XTraceReader() {
+    if (addr)
+      ::munmap(const_cast<char *>(addr), length);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  XTraceReader(const XTraceReader &) = delete;
+  XTraceReader &operator=(const XTraceReader &) = delete;
+
+  // 解码最多max条请求到out，返回条数，0表示结束
+  size_t next(XTraceRequest *out, size_t max) {
+    size_t n = 0;
+    while (n < max) {
+      if (pendingBlocks > 0) {
+        // ARC记录展开出的连续块
+        out[n].key = nextBlock++;
+        out[n].size = spec.blockBytes;
+        out[n].write = false;
+        pendingBlocks--;
+        n++;
+        continue;
+      }
+      if (pos >= length)
+        break;
+      if (spec.format == XTraceFormat::Binary) {
+        n += decodeBinary(out + n, max - n);
+        continue;
+      }
+      const char *begin = addr + pos;
+      const char *nl =
+          static_cast<const char *>(std::memchr(begin, '\n', length - pos));
+      size_t lineLen = nl ? size_t(nl - begin) : length - pos;
+      pos += lineLen + (nl ? 1 : 0);
+      std::string_view line(begin, lineLen);
+      if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+      if (decodeLine(line, out[n]))
+        n++;
+    }
+    releaseBehind();
+    return n;
+  }
+
+  // 回到trace开头（例如多轮预热）
+  void rewind() {
+    pos = 0;
+    released = 0;
+    pendingBlocks = 0;
+    if (spec.format == XTraceFormat::Binary && length > 0) {
+      if (length < detail::kTraceHeaderBytes ||
+          std::memcmp(addr, detail::kTraceMagic, 8) != 0)
+        throw std::runtime_error("not an xcache binary trace");
+      // 记录长度取自文件头，录制记录的额外字段中只用操作类型跳过Remove，命中与时间戳忽略
+      uint32_t bytes;
+      std::memcpy(&bytes, addr + 8, 4);
+      if (bytes < detail::kTraceRecordBytes)
+        throw std::runtime_error("bad xcache trace record size");
+      recordBytes = bytes;
+      pos = detail::kTraceHeaderBytes;
+    }
+  }
+
+  size_t bytesRead() const { return pos; }
+  size_t fileSize() const { return length; }
+
+private:
+  // 录制的Remove不是一次访问，模拟时跳过；返回0而pos未到末尾时由next继续解码
+  size_t decodeBinary(XTraceRequest *out, size_t max) {
+    size_t available = (length - pos) / recordBytes;
+    if (available == 0) {
+      pos = length; // 末尾不足一条记录
+      return 0;
+    }
+    bool events = recordBytes >= detail::kTraceEventBytes;
+    const char *p = addr + pos;
+    size_t n = 0, consumed = 0;
+    for (; consumed < available && n < max; ++consumed, p += recordBytes) {
+      if (events) {
+        uint32_t meta;
+        std::memcpy(&meta, p + 12, 4);
+        if ((meta & detail::kTraceOpMask) ==
+            static_cast<uint32_t>(XTraceOp::Remove))
+          continue;
+      }
+      uint32_t sizeAndFlags;
+      std::memcpy(&out[n].key, p, 8);
+      std::memcpy(&sizeAndFlags, p + 8, 4);
+      out[n].size = sizeAndFlags & ~detail::kTraceWriteBit;
+      out[n].write = (sizeAndFlags & detail::kTraceWriteBit) != 0;
+      n++;
+    }
+    pos += consumed * recordBytes;
+    return n;
+  }
+
+  static bool parseU64(std::string_view field, uint64_t &value) {
+    while (!field.empty() && field.front() == ' ')
+      field.remove_prefix(1);
+    while (!field.empty() && field.back() == ' ')
+      field.remove_suffix(1);
+    auto result =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && !field.empty();
+  }
+
+  // 按分隔符切出第index个字段
+  static std::string_view field(std::string_view line, int index, char sep) {
+    size_t start = 0;
+    for (int i = 0; i < index; ++i) {
+      size_t p = line.find(sep, start);
+      if (p == std::string_view::npos)
+        return {};
+      start = p + 1;
+    }
+    size_t end = line.find(sep, start);
+    return line.substr(start, end == std::string_view::npos ? line.size() - start
+                                                           : end - start);
+  }
+
+  // 无法解析的行（表头、注释）直接跳过
+  bool decodeLine(std::string_view line, XTraceRequest &req) {
+    switch (spec.format) {
+    case XTraceFormat::Lirs: {
+      if (line.empty() || line[0] == '*')
+        return false;
+      if (!parseU64(line, req.key))
+        return false;
+      req.size = spec.blockBytes;
+      req.write = false;
+      return true;
+    }
+    case XTraceFormat::Arc: {
+      uint64_t start, count;
+      if (!parseU64(field(line, 0, ' '), start) ||
+          !parseU64(field(line, 1, ' '), count) || count == 0)
+        return false;
+      req.key = start;
+      req.size = spec.blockBytes;
+      req.write = false;
+      nextBlock = start + 1;
+      pendingBlocks = count - 1;
+      return true;
+    }
+    case XTraceFormat::Csv: {
+      if (!parseU64(field(line, spec.keyColumn, ','), req.key))
+        return false;
+      uint64_t size = spec.blockBytes;
+      if (spec.sizeColumn >= 0 &&
+          !parseU64(field(line, spec.sizeColumn, ','), size))
+        return false;
+      req.size = static_cast<uint32_t>(
+          std::min<uint64_t>(size, ~detail::kTraceWriteBit));
+      req.write = false;
+      if (spec.opColumn >= 0) {
+        std::string_view op = field(line, spec.opColumn, ',');
+        while (!op.empty() && op.front() == ' ')
+          op.remove_prefix(1);
+        req.write = !op.empty() && (op[0] == 'W' || op[0] == 'w');
+      }
+      return true;
+    }
+    case XTraceFormat::Binary:
+      break;
+    }
+    return false;
+  }
+
+  void releaseBehind() {
+    if (pos - released < kReleaseBytes)
+      return;
+    size_t page = size_t(::sysconf(_SC_PAGESIZE));
+    size_t end = pos / page * page;
+    if (end > released) {
+      ::madvise(const_cast<char *>(addr) + released, end - released,
+                MADV_DONTNEED);
+      released = end;
+    }
+  }
+
+  XTraceFormatSpec spec;
+  int fd = -1;
+  const char *addr = nullptr;
+  size_t length = 0;
+  size_t pos = 0;
+  size_t released = 0;
+  uint64_t nextBlock = 0;
+  uint64_t pendingBlocks = 0;
+  size_t recordBytes = detail::kTraceRecordBytes;
+};
+
+// 二进制trace写入器：文件头为8字节魔数 + 记录长度 + 保留字段，
+// 每条记录为key(u64) + 大小(u32，最高位表示写)；events为true时写16字节的录制记录
+class XTraceWriter {
+public:
+  explicit XTraceWriter(const std::string &path, bool events = false)
+      : recordBytes(events ? detail::kTraceEventBytes
+                           : detail::kTraceRecordBytes) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+      throw std::runtime_error("cannot create trace: " + path);
+    char header[detail::kTraceHeaderBytes] = {};
+    std::memcpy(header, detail::kTraceMagic, 8);
+    std::memcpy(header + 8, &recordBytes, 4);
+    std::fwrite(header, 1, sizeof(header), file);
+    buffer.reserve(kBufferBytes);
+  }
+
+  ~XTraceWriter() { close(); }
+
+  XTraceWriter(const XTraceWriter &) = delete;
+  XTraceWriter &operator=(const XTraceWriter &) = delete;
+
+  void append(const XTraceRequest &req) {
+    XTraceEvent event;
+    event.key = req.key;
+    event.size = req.size;
+    event.op = req.write ? XTraceOp::Put : XTraceOp::Get;
+    append(event);
+  }
+
+  // 12字节记录没有操作类型，无法区分Remove与Get，丢弃Remove
+  void append(const XTraceEvent &event) {
+    if (event.op == XTraceOp::Remove && recordBytes < detail::kTraceEventBytes)
+      return;
+    char record[detail::kTraceEventBytes];
+    uint32_t sizeAndFlags = (event.size & ~detail::kTraceWriteBit) |
+                            (event.op == XTraceOp::Put ? detail::kTraceWriteBit : 0);
+    uint32_t meta = static_cast<uint32_t>(event.op) |
+                    (event.hit ? detail::kTraceHitBit : 0) |
+                    (event.timestampMs << detail::kTraceTimeShift);
+    std::memcpy(record, &event.key, 8);
+    std::memcpy(record + 8, &sizeAndFlags, 4);
+    std::memcpy(record + 12, &meta, 4);
+    buffer.insert(buffer.end(), record, record + recordBytes);
+    if (buffer.size() >= kBufferBytes)
+      flush();
+    count++;
+  }
+
+  void flush() {
+    if (!buffer.empty() && file) {
+      std::fwrite(buffer.data(), 1, buffer.size(), file);
+      buffer.clear();
+    }
+  }
+
+  void close() {
+    if (!file)
+      return;
+    flush();
+    std::fclose(file);
+    file = nullptr;
+  }
+
+  uint64_t getCount() const { return count; }
+
+private:
+  static constexpr size_t kBufferBytes = 1u << 20;
+
+  uint32_t recordBytes;
+  std::FILE *file = nullptr;
+  std::vector<char> buffer;
+  uint64_t count = 0;
+};
+} // namespace XCache
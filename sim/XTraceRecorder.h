@@ -0,0 +1,308 @@
+#pragma once
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../XCachePolicy.h"
+#include "../XSerializer.h"
+#include "XTrace.h"
+
+namespace XCache {
+struct XTraceRecorderOptions {
+  double sampleRate = 1.0;      // 按key哈希采样的比例，被采中的key的所有访问都会记录
+  size_t bufferEvents = 1 << 16; // 每个线程环形缓冲区的容量（取2的幂）
+  std::chrono::milliseconds flushInterval{50}; // 后台线程落盘间隔
+};
+
+// 线上访问trace录制器：每个线程写自己的单生产者环形缓冲区（无锁、不阻塞，满了就丢弃并计数），
+// 后台线程定期汇总写成二进制trace（16字节记录，可直接交给xcache_sim回放）。
+// 按key哈希采样（同一key要么全部记录要么全部跳过），回放采样trace时容量应同比缩小。
+// 各线程缓冲区按块交错落盘，trace中的顺序只在单个线程内严格保持；
+// 时间戳为粗粒度的毫秒数，29位，约6天回绕一次
+class XTraceRecorder {
+  struct ThreadBuffer {
+    explicit ThreadBuffer(size_t capacity) : events(capacity) {}
+
+    std::vector<XTraceEvent> events;
+    std::atomic<uint64_t> head{0}; // 生产者写入位置
+    std::atomic<uint64_t> tail{0}; // 后台线程读取位置
+    std::atomic<bool> closed{false};
+  };
+
+  // 线程本地的缓冲区表，按录制器id查找；录制器关闭后对应项在下次查找时清理
+  struct LocalEntry {
+    uint64_t recorderId;
+    std::shared_ptr<ThreadBuffer> buffer;
+  };
+
+public:
+  XTraceRecorder(const std::string &path,
+                 XTraceRecorderOptions options = XTraceRecorderOptions())
+      : options(options), writer(path, true), id(nextId()),
+        startMs(coarseMs()) {
+    size_t capacity = 1;
+    while (capacity < options.bufferEvents)
+      capacity <<= 1;
+    this->options.bufferEvents = capacity;
+    double rate = std::min(std::max(options.sampleRate, 0.0), 1.0);
+    sampleThreshold = rate >= 1.0 ? UINT64_MAX
+                                  : static_cast<uint64_t>(rate * 18446744073709551616.0);
+    flusher = std::thread([this] { flushLoop(); });
+  }
+
+  ~XTraceRecorder() { close(); }
+
+  XTraceRecorder(const XTraceRecorder &) = delete;
+  XTraceRecorder &operator=(const XTraceRecorder &) = delete;
+
+  // 把std::hash的结果打散成trace中的key（std::hash对整数是恒等映射）
+  static uint64_t hashKey(uint64_t h) { return mix(h); }
+
+  // 打散后的key是否被采中
+  bool sampled(uint64_t keyHash) const {
+    return sampleThreshold == UINT64_MAX || keyHash < sampleThreshold;
+  }
+
+  // 记录一次访问；keyHash为hashKey的结果，调用方应先用sampled过滤
+  void record(uint64_t keyHash, XTraceOp op, bool hit, uint32_t size) {
+    ThreadBuffer *buffer = localBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) >=
+        buffer->events.size()) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    XTraceEvent &event = buffer->events[head & (buffer->events.size() - 1)];
+    event.key = keyHash;
+    event.size = size;
+    event.op = op;
+    event.hit = hit;
+    event.timestampMs = static_cast<uint32_t>(coarseMs() - startMs);
+    buffer->head.store(head + 1, std::memory_order_release);
+  }
+
+  // 把当前所有缓冲区中的事件写入文件并刷新
+  void flush() {
+    std::lock_guard<std::mutex> lock(writerMtx);
+    drain();
+    writer.flush();
+  }
+
+  // 停止后台线程，写出剩余事件并关闭文件
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(flushMtx);
+      if (stopping)
+        return;
+      stopping = true;
+    }
+    flushCv.notify_all();
+    if (flusher.joinable())
+      flusher.join();
+    std::lock_guard<std::mutex> lock(writerMtx);
+    drain();
+    writer.close();
+    std::lock_guard<std::mutex> bufferLock(buffersMtx);
+    for (auto &buffer : buffers)
+      buffer->closed.store(true, std::memory_order_release);
+  }
+
+  uint64_t getRecorded() const { return recorded.load(); }
+  uint64_t getDropped() const { return dropped.load(); }
+
+private:
+  static uint64_t nextId() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+  }
+
+  // CLOCK_MONOTONIC_COARSE走vDSO，只读一个内核维护的时间，开销远小于精确时钟
+  static uint64_t coarseMs() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return uint64_t(ts.tv_sec) * 1000 + uint64_t(ts.tv_nsec) / 1000000;
+  }
+
+  static uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+  }
+
+  ThreadBuffer *localBuffer() {
+    thread_local std::vector<LocalEntry> local;
+    for (size_t i = 0; i < local.size(); ++i) {
+      if (local[i].recorderId == id)
+        return local[i].buffer.get();
+    }
+    // 首次在本线程记录：清理已关闭录制器的缓冲区，再注册新的
+    local.erase(std::remove_if(local.begin(), local.end(),
+                               [](const LocalEntry &e) {
+                                 return e.buffer->closed.load(
+                                     std::memory_order_acquire);
+                               }),
+                local.end());
+    auto buffer = std::make_shared<ThreadBuffer>(options.bufferEvents);
+    {
+      std::lock_guard<std::mutex> lock(buffersMtx);
+      buffers.push_back(buffer);
+    }
+    local.push_back({id, buffer});
+    return buffer.get();
+  }
+
+  // 需持有writerMtx
+  void drain() {
+    std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+    {
+      std::lock_guard<std::mutex> lock(buffersMtx);
+      snapshot = buffers;
+    }
+    for (auto &buffer : snapshot) {
+      uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+      uint64_t head = buffer->head.load(std::memory_order_acquire);
+      const size_t mask = buffer->events.size() - 1;
+      for (uint64_t i = tail; i < head; ++i)
+        writer.append(buffer->events[i & mask]);
+      buffer->tail.store(head, std::memory_order_release);
+      recorded.fetch_add(head - tail, std::memory_order_relaxed);
+    }
+  }
+
+  void flushLoop() {
+    std::unique_lock<std::mutex> lock(flushMtx);
+    while (!stopping) {
+      flushCv.wait_for(lock, options.flushInterval);
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> writerLock(writerMtx);
+        drain();
+      }
+      lock.lock();
+    }
+  }
+
+  XTraceRecorderOptions options;
+  XTraceWriter writer;
+  uint64_t id;
+  uint64_t startMs;
+  uint64_t sampleThreshold = UINT64_MAX;
+
+  std::mutex buffersMtx;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::mutex writerMtx;
+  std::mutex flushMtx;
+  std::condition_variable flushCv;
+  bool stopping = false;
+  std::thread flusher;
+  std::atomic<uint64_t> recorded{0};
+  std::atomic<uint64_t> dropped{0};
+};
+
+// 给任意引擎加上trace录制：包装Engine，每次访问先按key哈希判断是否采样，
+// 未采中的访问只多一次哈希与比较
+template <typename Key, typename Value,
+          typename Engine = XCachePolicy<Key, Value>>
+class XTracedCache : public XCachePolicy<Key, Value> {
+public:
+  XTracedCache(std::unique_ptr<Engine> engine,
+               std::shared_ptr<XTraceRecorder> recorder)
+      : engine(std::move(engine)), recorder(std::move(recorder)) {}
+
+  void put(Key key, Value value) override {
+    uint64_t h = XTraceRecorder::hashKey(std::hash<Key>()(key));
+    if (recorder->sampled(h))
+      recorder->record(h, XTraceOp::Put, false, valueSize(value));
+    engine->put(key, std::move(value));
+  }
+
+  bool get(Key key, Value &value) override {
+    bool hit = engine->get(key, value);
+    uint64_t h = XTraceRecorder::hashKey(std::hash<Key>()(key));
+    if (recorder->sampled(h))
+      recorder->record(h, XTraceOp::Get, hit, hit ? valueSize(value) : 0);
+    return hit;
+  }
+
+  Value get(Key key) override {
+    Value value{};
+    get(key, value);
+    return value;
+  }
+
+  void remove(Key key) override {
+    uint64_t h = XTraceRecorder::hashKey(std::hash<Key>()(key));
+    if (recorder->sampled(h))
+      recorder->record(h, XTraceOp::Remove, false, 0);
+    engine->remove(key);
+  }
+
+  // 只在确实删除时录制
+  bool removeIf(Key key,
+                const typename XCachePolicy<Key, Value>::RemovePred &pred) override {
+    if (!engine->removeIf(key, pred))
+      return false;
+    uint64_t h = XTraceRecorder::hashKey(std::hash<Key>()(key));
+    if (recorder->sampled(h))
+      recorder->record(h, XTraceOp::Remove, false, 0);
+    return true;
+  }
+
+  // 录制为一次get，写回时再录一次put
+  Value modify(Key key,
+               const typename XCachePolicy<Key, Value>::ModifyFn &fn) override {
+    bool hit = false, wrote = false;
+    Value value = engine->modify(key, [&](Value &v, bool present) {
+      hit = present;
+      wrote = fn(v, present);
+      return wrote;
+    });
+    uint64_t h = XTraceRecorder::hashKey(std::hash<Key>()(key));
+    if (recorder->sampled(h)) {
+      recorder->record(h, XTraceOp::Get, hit, hit ? valueSize(value) : 0);
+      if (wrote)
+        recorder->record(h, XTraceOp::Put, false, valueSize(value));
+    }
+    return value;
+  }
+
+  // 不是真实访问，不录制
+  bool peek(Key key, Value &value) const override {
+    return engine->peek(key, value);
+  }
+  bool contains(Key key) const override { return engine->contains(key); }
+
+  // 不是访问，不录制
+  void clear() override { engine->clear(); }
+
+  void setEvictionStats(std::shared_ptr<XEvictionStats> stats) override {
+    engine->setEvictionStats(std::move(stats));
+  }
+
+  Engine &getEngine() { return *engine; }
+
+private:
+  static uint32_t valueSize(const Value &value) {
+    if constexpr (isSerializable<Value>)
+      return static_cast<uint32_t>(std::min<size_t>(
+          serializedSize(value), ~detail::kTraceWriteBit));
+    else
+      return static_cast<uint32_t>(sizeof(Value));
+  }
+
+  std::unique_ptr<Engine> engine;
+  std::shared_ptr<XTraceRecorder> recorder;
+};
+} // namespace XCache
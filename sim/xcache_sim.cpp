@@ -0,0 +1,176 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "XSimulator.h"
+#include "XTrace.h"
+
+// trace驱动的缓存模拟器：流式解码trace，每块只解码一次，由线程池并行喂给所有（策略, 容量）组合
+static void usage(const char *prog) {
+  std::cout
+      << "用法: " << prog << " --trace <file> [选项]\n"
+      << "  --format <name>       arc|lirs|msr|cloudphysics|csv:<key列>,<大小列>[,<读写列>]|bin（默认bin）\n"
+      << "  --policies <list>     逗号分隔的策略（默认全部：lru,lru-k,lfu,lfu-aging,arc,w-tinylfu）\n"
+      << "  --capacities <list>   逗号分隔的容量（条目数，默认1000,10000,100000）\n"
+      << "  --block-bytes <n>     arc/lirs等无大小信息时每块的字节数（默认512）\n"
+      << "  --limit <n>           最多回放n条请求\n"
+      << "  --threads <n>         模拟线程数（默认每核一个）\n"
+      << "  --eviction-stats <n>  输出淘汰统计，n为追踪再请求的幽灵表容量（0为不输出）\n"
+      << "  --convert <file>      不模拟，把trace转换为二进制格式写入file\n";
+}
+
+static std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty())
+      items.push_back(item);
+  }
+  return items;
+}
+
+int main(int argc, char **argv) {
+  std::string tracePath;
+  std::string format = "bin";
+  std::string convertPath;
+  std::vector<std::string> policies = XCache::cachePolicyNames();
+  std::vector<size_t> capacities = {1000, 10000, 100000};
+  uint32_t blockBytes = 512;
+  uint64_t limit = UINT64_MAX;
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t evictionGhost = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || i + 1 >= argc) {
+      usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--trace")
+      tracePath = value;
+    else if (arg == "--format")
+      format = value;
+    else if (arg == "--policies")
+      policies = splitList(value);
+    else if (arg == "--capacities") {
+      capacities.clear();
+      for (const std::string &c : splitList(value))
+        capacities.push_back(std::stoull(c));
+    } else if (arg == "--block-bytes")
+      blockBytes = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "--limit")
+      limit = std::stoull(value);
+    else if (arg == "--threads")
+      threads = std::stoul(value);
+    else if (arg == "--eviction-stats")
+      evictionGhost = std::stoull(value);
+    else if (arg == "--convert")
+      convertPath = value;
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (tracePath.empty()) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  try {
+    XCache::XTraceFormatSpec spec = XCache::parseTraceFormat(format);
+    spec.blockBytes = blockBytes;
+    XCache::XTraceReader reader(tracePath, spec);
+    std::vector<XCache::XTraceRequest> chunk(64 * 1024);
+
+    if (!convertPath.empty()) {
+      XCache::XTraceWriter writer(convertPath);
+      uint64_t total = 0;
+      while (total < limit) {
+        size_t n = reader.next(chunk.data(),
+                               size_t(std::min<uint64_t>(chunk.size(), limit - total)));
+        if (n == 0)
+          break;
+        for (size_t i = 0; i < n; ++i)
+          writer.append(chunk[i]);
+        total += n;
+      }
+      writer.close();
+      std::cout << "转换完成: " << total << " 条请求 -> " << convertPath
+                << std::endl;
+      return 0;
+    }
+
+    std::vector<std::unique_ptr<XCache::XSimRun>> runs;
+    for (const std::string &policy : policies) {
+      for (size_t capacity : capacities)
+        runs.push_back(std::make_unique<XCache::XSimRun>(policy, capacity));
+    }
+    if (evictionGhost > 0) {
+      for (auto &run : runs)
+        run->enableEvictionStats(evictionGhost);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    XCache::XParallelSimulator simulator(runs, threads);
+    uint64_t total = simulator.run(reader, limit);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+
+    std::cout << "trace: " << tracePath << " (" << format << "), " << total
+              << " 条请求, " << runs.size() << " 组模拟, " << threads
+              << " 线程, 总耗时 " << std::fixed << std::setprecision(2)
+              << seconds << " s, 合计 " << std::setprecision(3)
+              << (seconds > 0 ? total * runs.size() / seconds / 1e6 : 0)
+              << " Mreq/s" << std::endl;
+    std::cout << std::left << std::setw(12) << "policy" << std::right
+              << std::setw(12) << "capacity" << std::setw(12) << "hit%"
+              << std::setw(12) << "byteHit%" << std::setw(14) << "Mreq/s"
+              << std::endl;
+    for (auto &run : runs) {
+      std::cout << std::left << std::setw(12) << run->getPolicy() << std::right
+                << std::setw(12) << run->getCapacity() << std::setw(12)
+                << std::setprecision(2) << run->hitRatio() * 100
+                << std::setw(12) << run->byteHitRatio() * 100 << std::setw(14)
+                << std::setprecision(3) << run->requestsPerSec() / 1e6
+                << std::endl;
+    }
+
+    if (evictionGhost > 0) {
+      // 时间单位为访问次数；零命中淘汰多且再请求间隔短，说明新条目的留存时间不够
+      std::cout << "\n淘汰统计（时间单位：访问次数）\n"
+                << std::left << std::setw(12) << "policy" << std::right
+                << std::setw(12) << "capacity" << std::setw(12) << "evictions"
+                << std::setw(12) << "age p50" << std::setw(12) << "age p99"
+                << std::setw(12) << "zeroHit%" << std::setw(12) << "hits p50"
+                << std::setw(12) << "rereq%" << std::setw(12) << "rereq p50"
+                << std::endl;
+      for (auto &run : runs) {
+        const XCache::XEvictionStats *stats = run->getEvictionStats();
+        uint64_t evictions = stats->getEvictions();
+        XCache::XHistogram age = stats->getAgeAtEviction();
+        XCache::XHistogram rereq = stats->getEvictionToRerequest();
+        std::cout << std::left << std::setw(12) << run->getPolicy()
+                  << std::right << std::setw(12) << run->getCapacity()
+                  << std::setw(12) << evictions << std::setw(12)
+                  << age.percentile(50) << std::setw(12) << age.percentile(99)
+                  << std::setw(12) << std::setprecision(2)
+                  << (evictions ? 100.0 * stats->getZeroHitEvictions() / evictions : 0)
+                  << std::setw(12) << stats->getHitsAtEviction().percentile(50)
+                  << std::setw(12)
+                  << (evictions ? 100.0 * rereq.count() / evictions : 0)
+                  << std::setw(12) << rereq.percentile(50) << std::endl;
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "xcache_sim: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}